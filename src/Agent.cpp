@@ -31,10 +31,12 @@
 #include "creaturesImage.h"
 #include "Camera.h"
 #include "VoiceData.h"
+#include "PointerAgent.h"
 
 void Agent::core_init() {
 	initialized = false;
 	lifecount = 0;
+	handle = agentHandles::nohandle;
 }
 
 Agent::Agent(unsigned char f, unsigned char g, unsigned short s, unsigned int p) :
@@ -91,6 +93,8 @@ Agent::Agent(unsigned char f, unsigned char g, unsigned short s, unsigned int p)
 	clik = -1;
 	
 	dying = false;
+	vmdeferred = false;
+	physicsdone = false;
 	unid = -1;
 
 	paused = displaycore = false;
@@ -113,8 +117,7 @@ void Agent::finishInit() {
 	
 	// shared_from_this() can only be used if these is at least one extant
 	// shared_ptr which owns this
-	world.agents.push_front(boost::shared_ptr<Agent>(this));
-	agents_iter = world.agents.begin();
+	unid = world.agents.add(boost::shared_ptr<Agent>(this));
 
 	if (engine.version > 2 && findScript(10))
 		queueScript(10); // constructor
@@ -146,6 +149,7 @@ void Agent::moveTo(float _x, float _y, bool force) {
 	float yoffset = _y - y;		
 
 	x = _x; y = _y;
+	if (this != world.hand() && (xoffset != 0.0f || yoffset != 0.0f)) world.partsChanged();
 
 	// handle wraparound
 	// TODO: this is perhaps non-ideal
@@ -218,7 +222,6 @@ shared_ptr<script> Agent::findScript(unsigned short event) {
 	return world.scriptorium.getScript(family, genus, species, event);
 }
 
-#include "PointerAgent.h"
 #include "creatures/CreatureAgent.h"
 #include "creatures/Creature.h"
 bool Agent::fireScript(unsigned short event, Agent *from, caosVar one, caosVar two) {
@@ -337,6 +340,20 @@ bool Agent::fireScript(unsigned short event, Agent *from, caosVar one, caosVar t
 	return ranscript;
 }
 
+/*
+ * Set the IMSK flags, keeping the world's input subscriber lists in step.
+ */
+void Agent::setInputMask(unsigned int flags) {
+	world.setInputMask(this, getInputMask(), flags);
+	imsk_key_down = (flags & 1);
+	imsk_key_up = (flags & 2);
+	imsk_mouse_move = (flags & 4);
+	imsk_mouse_down = (flags & 8);
+	imsk_mouse_up = (flags & 16);
+	imsk_mouse_wheel = (flags & 32);
+	imsk_translated_char = (flags & 64);
+}
+
 bool Agent::queueScript(unsigned short event, AgentRef from, caosVar p0, caosVar p1) {
 	// Queue a script for execution on the VM of this agent.
 
@@ -541,31 +558,11 @@ bool Agent::validInRoomSystem(Point p, float w, float h, int testperm) {
 	return true;
 }
 
-void Agent::physicsTick() {
-	if (engine.version == 1) return; // C1 has no physics, and different attributes.
-
-	if (carriedby) return; // We don't move when carried, so what's the point?
-
-	if (engine.version == 2) {
-		// Creatures 2 physics is different.
-		physicsTickC2();
-		return;
-	}
-
-	if (!falling) return; // TODO: there are probably all sorts of issues here, untested
-
-	if (!wasmoved) return; // some agents are created outside INST and get autokilled if we try physics on them before they move
-
-	if (invehicle) return; // TODO: c2e verhicle physics
-
-	// set destination point based on velocities
-	float destx = x + velx.getFloat();
-	float desty = y + vely.getFloat();
-
+/*
+ * Where our velocities (and gravity) would take us this tick, ignoring the room system.
+ */
+void Agent::physicsDestination(float &destx, float &desty) {
 	if (rotatable()) {
-		// TODO: the real engine seems to reset velx/vely, so i do that here, but why?
-		velx.setFloat(0.0f); vely.setFloat(0.0f);
-
 		// TODO: which order should these be in?
 
 		// calculate forwards velocity
@@ -580,10 +577,10 @@ void Agent::physicsTick() {
 		// set destination based on forward/sideways velocity
 		destx = x + forward_x + sideways_x;
 		desty = y + forward_y + sideways_y;
-
-		// modify spin based on angular velocity
-		spin = fmodf(spin + avel, 1.0f);
-		if (spin < 0.0f) spin += 1.0f;
+	} else {
+		// set destination point based on velocities
+		destx = x + velx.getFloat();
+		desty = y + vely.getFloat();
 	}
 
 	if (sufferphysics()) {
@@ -594,96 +591,145 @@ void Agent::physicsTick() {
 		// TODO: should we be changing vely first, instead of after a successful move (below)?
 		desty += accg.getFloat();
 	}
-	
-	if (suffercollisions()) {
-		float lastdistance = 1000000.0f;
-		bool collided = false;
-		Line wall; // only valid when collided
-		unsigned int collidedirection = 0; // only valid when collided
-		Point bestmove;
+}
 
-		// iterate through all four points of the bounding box
-		for (unsigned int i = 0; i < 4; i++) {
-			// this mess is because we want to start with the bottom point - DOWN (3) - before the others, for efficiency
-			Point src = boundingBoxPoint((i == 0) ? 3 : i - 1);
+void Agent::setupCollision(physicsCollision &c, float destx, float desty) {
+	c.pos = Point(x, y);
+	if (has_custom_core_size) {
+		c.core = Point(x + custom_core_xleft, y + custom_core_ytop);
+		c.w = custom_core_xright - custom_core_xleft;
+		c.h = custom_core_ybottom - custom_core_ytop;
+	} else {
+		c.core = c.pos;
+		c.w = getWidth();
+		c.h = getHeight();
+	}
+	c.dest = Point(destx, desty);
+	c.perm = perm;
+}
 
-			// store values
-			float srcx = src.x, srcy = src.y;
-			
-			shared_ptr<Room> ourRoom = world.map.roomAt(srcx, srcy);
-			if (!ourRoom) {
-				ourRoom = world.map.roomAt(srcx, srcy);
-			}
-			if (!ourRoom) {
-				if (!displaycore) { // TODO: ugh, displaycore is a horrible thing to use for this
-					// we're out of the room system, physics bug, but let's try MVSFing back in to cover for fuzzie's poor programming skills
-					static bool tryingmove; tryingmove = false; // avoid infinite loop
-					if (!tryingmove && tryMoveToPlaceAround(x, y)) {
-						//std::cout << identify() << " was out of room system due to a physics bug but we hopefully moved it back in.." << std::endl;
-						tryingmove = true;
-						physicsTick();
-						return;
-					}
-					
-					// didn't work!
-					unhandledException(boost::str(boost::format("out of room system at (%f, %f)") % srcx % srcy), false);
-				}
-				displaycore = true;
-				falling = false;
-				return; // out of room system
-			}
-			
-			Point dest(destx + (srcx - x), desty + (srcy - y));
-			unsigned int local_collidedirection;
-			Line local_wall;
+/*
+ * Works out where moving towards c.dest would leave us, and what we hit on the
+ * way. This only reads the inputs in 'c' and the room system, so it's safe to
+ * call for many agents at once (see World::tickPhysics).
+ */
+void Agent::collideWithRoomSystem(physicsCollision &c) {
+	c.inroomsystem = true;
+	c.lastdistance = 1000000.0f;
+	c.collided = false;
+	c.collidedirection = 0;
+
+	// iterate through all four points of the bounding box
+	for (unsigned int i = 0; i < 4; i++) {
+		// this mess is because we want to start with the bottom point - DOWN (3) - before the others, for efficiency
+		Point src = boundingBoxPoint((i == 0) ? 3 : i - 1, c.core, c.w, c.h);
+
+		// store values
+		float srcx = src.x, srcy = src.y;
 		
-			// this changes src to the point at which we end up
-			bool local_collided = world.map.collideLineWithRoomSystem(src, dest, ourRoom, src, local_wall, local_collidedirection, perm);
-
-			float dist;
-			if (src.x == srcx && src.y == srcy)
-				dist = 0.0f;
-			else {
-				float xdiff = src.x - srcx;
-				float ydiff = src.y - srcy;
-				dist = xdiff*xdiff + ydiff*ydiff;
-			}
+		shared_ptr<Room> ourRoom = world.map.roomAt(srcx, srcy);
+		if (!ourRoom) {
+			c.inroomsystem = false;
+			c.outside = src;
+			return;
+		}
+		
+		Point dest(c.dest.x + (srcx - c.pos.x), c.dest.y + (srcy - c.pos.y));
+		unsigned int local_collidedirection;
+		Line local_wall;
+	
+		// this changes src to the point at which we end up
+		bool local_collided = world.map.collideLineWithRoomSystem(src, dest, ourRoom, src, local_wall, local_collidedirection, c.perm);
+
+		float dist;
+		if (src.x == srcx && src.y == srcy)
+			dist = 0.0f;
+		else {
+			float xdiff = src.x - srcx;
+			float ydiff = src.y - srcy;
+			dist = xdiff*xdiff + ydiff*ydiff;
+		}
 
-			if (dist >= lastdistance) {
-				assert(i != 0); // this had better not be our first collision!
-				continue; // further away than a previous collision
-			}
+		if (dist >= c.lastdistance) {
+			assert(i != 0); // this had better not be our first collision!
+			continue; // further away than a previous collision
+		}
 
-			lastdistance = dist;
-			bestmove.x = x + (src.x - srcx);
-			bestmove.y = y + (src.y - srcy);
-			collidedirection = local_collidedirection;
-			wall = local_wall;
-			collided = local_collided;
+		c.lastdistance = dist;
+		c.bestmove.x = c.pos.x + (src.x - srcx);
+		c.bestmove.y = c.pos.y + (src.y - srcy);
+		c.collidedirection = local_collidedirection;
+		c.wall = local_wall;
+		c.collided = local_collided;
 
-			if (dist == 0.0f)
-				break; // no point checking any more, is there?
-		}	
+		if (dist == 0.0f)
+			break; // no point checking any more, is there?
+	}
+}
 
-		// *** do actual movement
-		if (lastdistance != 0.0f) {	
-			moveTo(bestmove.x, bestmove.y);
-		
-			if (collided) {
-				lastcollidedirection = collidedirection;
-				queueScript(6, 0, velx, vely); // TODO: include this? .. we need to include SOMETHING, c3 ball checks for <3
-
-				if (elas != 0) {
-					if (wall.getType() == HORIZONTAL) {
-						vely.setFloat(-vely.getFloat());
-					} else if (wall.getType() == VERTICAL) {
-						velx.setFloat(-velx.getFloat());
+/*
+ * Reads what integratePhysics needs from us into 's', starting with where our
+ * velocities would take us this tick, ignoring the room system.
+ */
+void Agent::preparePhysics(physicsStep &s) {
+	s.suffercollisions = suffercollisions();
+	s.sufferphysics = sufferphysics();
+	s.rotatable = rotatable();
+
+	float destx, desty;
+	physicsDestination(destx, desty);
+	setupCollision(s.collision, destx, desty);
+
+	if (s.rotatable) {
+		// velx/vely are reset by applyPhysics before anything uses them
+		s.velx = s.vely = 0.0f;
+		s.hasvelocity = true;
+		s.setvelx = s.setvely = true;
+	} else {
+		s.velx = velx.getFloat();
+		s.vely = vely.getFloat();
+		s.hasvelocity = velx.hasDecimal() || vely.hasDecimal();
+		s.setvelx = s.setvely = false;
+	}
+	s.accg = s.sufferphysics ? accg.getFloat() : 0.0f;
+	s.aero = s.sufferphysics ? aero.getFloat() : 0.0f;
+	s.elas = elas;
+}
+
+/*
+ * Works out where 's' moves its agent to and what its velocities become. This
+ * only reads the step and the room system, so, as with collideWithRoomSystem,
+ * it's safe to run for many agents at once.
+ */
+void integratePhysics(physicsStep &s) {
+	s.move = false;
+	s.collided = false;
+	s.stopfalling = false;
+
+	if (s.suffercollisions) {
+		physicsCollision &c = s.collision;
+		if (!c.inroomsystem) return; // see Agent::leftRoomSystem
+
+		if (c.lastdistance != 0.0f) {
+			s.move = true;
+			s.moveto = c.bestmove;
+
+			if (c.collided) {
+				s.collided = true;
+
+				if (s.elas != 0) {
+					if (c.wall.getType() == HORIZONTAL) {
+						s.vely = -s.vely;
+						s.setvely = true;
+					} else if (c.wall.getType() == VERTICAL) {
+						s.velx = -s.velx;
+						s.setvelx = true;
 					} else {
 						// line starts always have a lower x value than the end
-						float xdiff = wall.getEnd().x - wall.getStart().x;
-						float ydiff = wall.getEnd().y - wall.getStart().y;
-						float fvelx = velx.getFloat(), fvely = vely.getFloat();
-					
+						float xdiff = c.wall.getEnd().x - c.wall.getStart().x;
+						float ydiff = c.wall.getEnd().y - c.wall.getStart().y;
+						float fvelx = s.velx, fvely = s.vely;
+
 						// calculate input/slope angles
 						double inputangle;
 						if (fvelx == 0.0f) {
@@ -704,49 +750,159 @@ void Agent::physicsTick() {
 						float xoutput = cos(outputangle) * vectorlength;
 						float youtput = sin(outputangle) * vectorlength;
 
-						velx.setFloat(xoutput);
-						vely.setFloat(-youtput);
+						s.velx = xoutput;
+						s.vely = -youtput;
+						s.setvelx = s.setvely = true;
 					}
 
-					if (elas != 100.0f) {
-						velx.setFloat(velx.getFloat() * (elas / 100.0f));
-						vely.setFloat(vely.getFloat() * (elas / 100.0f));
+					if (s.elas != 100.0f) {
+						s.velx = s.velx * (s.elas / 100.0f);
+						s.vely = s.vely * (s.elas / 100.0f);
+						s.setvelx = s.setvely = true;
 					}
-				} else				
-					vely.setFloat(0);
-			} else if (sufferphysics() && accg != 0) {
-				vely.setFloat(vely.getFloat() + accg.getFloat());
+				} else {
+					s.vely = 0.0f;
+					s.setvely = true;
+				}
+			} else if (s.sufferphysics && s.accg != 0.0f) {
+				s.vely = s.vely + s.accg;
+				s.setvely = true;
 			}
 		} else {
 			// TODO: correct?
-			if (sufferphysics()) {
-				if (velx.getFloat() == 0.0f && vely.getFloat() == 0.0f)
-					falling = false;
+			if (s.sufferphysics) {
+				if (s.velx == 0.0f && s.vely == 0.0f)
+					s.stopfalling = true;
 			}
-			velx.setFloat(0);
-			vely.setFloat(0);
+			s.velx = s.vely = 0.0f;
+			s.setvelx = s.setvely = true;
 		}
 	} else {
-		if (vely.hasDecimal() || velx.hasDecimal())
-			moveTo(destx, desty);
-		if (sufferphysics())
-			vely.setFloat(vely.getFloat() + accg.getFloat());
+		if (s.hasvelocity) {
+			s.move = true;
+			s.moveto = s.collision.dest;
+		}
+		if (s.sufferphysics) {
+			s.vely = s.vely + s.accg;
+			s.setvely = true;
+		}
 	}
 
-	if (sufferphysics() && (aero != 0)) {
+	if (s.sufferphysics && s.aero != 0.0f) {
 		// reduce speed according to AERO
 		// TODO: aero should be an integer!
-		velx.setFloat(velx.getFloat() - (velx.getFloat() * (aero.getFloat() / 100.0f)));
-		vely.setFloat(vely.getFloat() - (vely.getFloat() * (aero.getFloat() / 100.0f)));
+		s.velx = s.velx - (s.velx * (s.aero / 100.0f));
+		s.vely = s.vely - (s.vely * (s.aero / 100.0f));
+		s.setvelx = s.setvely = true;
 	}
+}
 
-	if (rotatable()) {
+/*
+ * Makes the move worked out by integratePhysics, and queues our collision
+ * script if we hit something. This is the part which has to be done on the
+ * main thread.
+ */
+void Agent::applyPhysics(physicsStep &s) {
+	if (s.rotatable) {
+		// TODO: the real engine seems to reset velx/vely, so i do that here, but why?
+		velx.setFloat(0.0f); vely.setFloat(0.0f);
+
+		// modify spin based on angular velocity
+		spin = fmodf(spin + avel, 1.0f);
+		if (spin < 0.0f) spin += 1.0f;
+	}
+
+	if (s.suffercollisions && !s.collision.inroomsystem) {
+		leftRoomSystem(s.collision);
+		return;
+	}
+
+	// *** do actual movement
+	if (s.move)
+		moveTo(s.moveto.x, s.moveto.y);
+
+	if (s.collided) {
+		lastcollidedirection = s.collision.collidedirection;
+		queueScript(6, 0, velx, vely); // TODO: include this? .. we need to include SOMETHING, c3 ball checks for <3
+	}
+
+	if (s.stopfalling)
+		falling = false;
+	if (s.setvelx)
+		velx.setFloat(s.velx);
+	if (s.setvely)
+		vely.setFloat(s.vely);
+
+	if (s.rotatable) {
 		avel -= avel * admp;
 		fvel -= fvel * fdmp;
 		svel -= svel * sdmp;
 	}
 }
 
+void Agent::leftRoomSystem(physicsCollision &c) {
+	if (!displaycore) { // TODO: ugh, displaycore is a horrible thing to use for this
+		// we're out of the room system, physics bug, but let's try MVSFing back in to cover for fuzzie's poor programming skills
+		static bool tryingmove; tryingmove = false; // avoid infinite loop
+		if (!tryingmove && tryMoveToPlaceAround(x, y)) {
+			//std::cout << identify() << " was out of room system due to a physics bug but we hopefully moved it back in.." << std::endl;
+			tryingmove = true;
+			physicsTick();
+			return;
+		}
+
+		// didn't work!
+		unhandledException(boost::str(boost::format("out of room system at (%f, %f)") % c.outside.x % c.outside.y), false);
+	}
+	displaycore = true;
+	falling = false;
+}
+
+/*
+ * Sets up physicsstep for World::tickPhysics, returning false if we're not
+ * suitable. Anything tied to another agent, with a physicsTick of its own, or
+ * with velocities which aren't numbers is left to our own tick.
+ */
+bool Agent::preparePhysicsStep() {
+	physicsdone = false;
+
+	if (engine.version < 3) return false;
+	if (dying || paused) return false;
+	if (!falling || !wasmoved) return false;
+	if (carriedby || carrying || invehicle || floatingagent) return false;
+	if (this == world.hand() || dynamic_cast<CreatureAgent *>(this)) return false;
+	if (!rotatable() && !(velx.hasDecimal() && vely.hasDecimal())) return false;
+	if (sufferphysics() && !(accg.hasDecimal() && aero.hasDecimal())) return false;
+
+	preparePhysics(physicsstep);
+	return true;
+}
+
+void Agent::physicsTick() {
+	if (engine.version == 1) return; // C1 has no physics, and different attributes.
+
+	if (carriedby) return; // We don't move when carried, so what's the point?
+
+	if (engine.version == 2) {
+		// Creatures 2 physics is different.
+		physicsTickC2();
+		return;
+	}
+
+	if (!falling) return; // TODO: there are probably all sorts of issues here, untested
+
+	if (!wasmoved) return; // some agents are created outside INST and get autokilled if we try physics on them before they move
+
+	if (invehicle) return; // TODO: c2e verhicle physics
+
+	physicsStep s;
+	preparePhysics(s);
+	if (s.suffercollisions)
+		collideWithRoomSystem(s.collision);
+	integratePhysics(s);
+	applyPhysics(s);
+}
+
 shared_ptr<Room> const Agent::bestRoomAt(unsigned int tryx, unsigned int tryy, unsigned int direction, MetaRoom *m, shared_ptr<Room> exclude) {
 	std::vector<shared_ptr<Room> > rooms = m->roomsAt(tryx, tryy);
 
@@ -1004,17 +1160,8 @@ void Agent::tick() {
 	// sanity checks to stop ticks on dead agents
 	LifeAssert la(this);
 	if (dying) return;
-	
-	if (sound) {
-		// if the sound is no longer playing...
-		if (sound->getState() != SS_PLAY) {
-			// ...release our reference to it
-			sound.reset();
-		} else {
-			// otherwise, reposition audio
-			updateAudio(sound);
-		}
-	}
+
+	// (our sound is repositioned by World::updateAudio, with everyone else's)
 
 	// don't tick paused agents
 	if (paused) return;
@@ -1041,8 +1188,11 @@ void Agent::tick() {
 		}
 	}
 
-	// tick the physics engine
-	physicsTick();
+	// tick the physics engine, unless World::tickPhysics already has
+	if (physicsdone)
+		physicsdone = false;
+	else
+		physicsTick();
 	if (dying) return; // in case we were autokilled
 
 	// update the timer if needed, and then queue a timer event if necessary
@@ -1055,8 +1205,17 @@ void Agent::tick() {
 		assert(timerrate > tickssincelasttimer);
 	}
 
-	// tick the agent VM
-	if (vm) vmTick();
+	// tick the agent VM, unless this tick's script budget has been spent;
+	// an agent which misses out goes next tick whatever the budget
+	if (vm) {
+		if (vmdeferred || world.scriptBudgetLeft()) {
+			vmdeferred = false;
+			vmTick();
+		} else {
+			vmdeferred = true;
+			world.scriptstats.deferrals++;
+		}
+	}
 
 	// some silly hack to handle delayed voices
 	tickVoices();
@@ -1098,6 +1257,9 @@ void Agent::vmTick() {
 		assert(vm->timeslice > 0);
 
 		// Tell the VM to tick (using all available timeslice), catching exceptions as necessary.
+		// The script can kill us or CALL another one, changing vm, so count its ops through 'ran'
+		// (a freed VM just goes back to the pool, so it's still safe to read afterwards).
+		caosVM *ran = vm;
 		try {
 			vm->tick();
 		} catch (invalidAgentException &e) {
@@ -1111,6 +1273,7 @@ void Agent::vmTick() {
 		} catch (std::exception &e) {
 			unhandledException(e.what(), true);
 		}
+		world.scriptops += ran->runops;
 		
 		// If the VM stopped, it's done.
 		if (vm && vm->stopped()) {
@@ -1162,6 +1325,7 @@ void Agent::kill() {
 	if (invehicle) invehicle->drop(this);
 	
 	dying = true; // what a world, what a world...
+	world.agents.remove(unid); // invalidates any AgentRefs to us
 
 	if (vm) {
 		vm->stop();
@@ -1170,7 +1334,6 @@ void Agent::kill() {
 	}
 	
 	zotstack();
-	agents_iter->reset();
 
 	if (sound) {
 		sound->stop();
@@ -1203,9 +1366,8 @@ void Agent::setZOrder(unsigned int z) {
 }
 
 int Agent::getUNID() const {
-	if (unid != -1)
-		return unid;
-	return unid = world.newUNID(const_cast<Agent *>(this));
+	assert(unid != -1); // assigned by finishInit
+	return unid;
 }
 
 #include "Catalogue.h"
@@ -1300,7 +1462,7 @@ bool Agent::beDropped() {
 
 	if (!wasinvehicle) { // ie, we're not being dropped by a vehicle
 		// TODO: check for vehicles in a saner manner?
-		for (std::list<boost::shared_ptr<Agent> >::iterator i = world.agents.begin(); i != world.agents.end(); i++) {
+		for (agentRegistry::iterator i = world.agents.begin(); i != world.agents.end(); i++) {
 			boost::shared_ptr<Agent> a = (*i);
 			if (!a) continue;
 			Vehicle *v = dynamic_cast<Vehicle *>(a.get());
@@ -24,6 +24,8 @@
 #include <boost/enable_shared_from_this.hpp>
 #include <boost/shared_ptr.hpp>
 #include "caosVar.h"
+#include "agentVariables.h"
+#include "lazyMap.h"
 #include "CompoundPart.h"
 #include <list>
 #include <map>
@@ -35,6 +37,50 @@
 class script;
 class genomeFile;
 
+/*
+ * Where an agent's bounding box ends up when moved through the room system;
+ * see Agent::collideWithRoomSystem.
+ */
+struct physicsCollision {
+	// inputs
+	Point pos, core, dest;
+	float w, h;
+	int perm;
+
+	// results
+	bool inroomsystem; // if not, 'outside' is the point which wasn't in a room
+	Point outside;
+	float lastdistance;
+	bool collided;
+	Line wall; // only valid when collided
+	unsigned int collidedirection; // only valid when collided
+	Point bestmove;
+};
+
+/*
+ * One tick of c2e physics for an agent. Agent::preparePhysics reads
+ * everything needed from the agent into here, integratePhysics works out the
+ * move and the new velocities from only this and the room system (so it's
+ * safe to run for many agents at once, see World::tickPhysics), and
+ * Agent::applyPhysics then moves the agent and queues its collision script.
+ */
+struct physicsStep {
+	// inputs
+	bool suffercollisions, sufferphysics, rotatable;
+	bool hasvelocity; // VELX or VELY is a number
+	float velx, vely, accg, aero;
+	int elas;
+	physicsCollision collision; // only worked out if suffercollisions
+
+	// results
+	bool move;
+	Point moveto;
+	bool collided, stopfalling;
+	bool setvelx, setvely; // whether velx/vely are to be stored back
+};
+
+void integratePhysics(physicsStep &s);
+
 struct agentzorder {
 	bool operator()(const class Agent *s1, const class Agent *s2) const;
 };
@@ -44,6 +90,7 @@ class Agent : public boost::enable_shared_from_this<Agent> {
 	friend struct agentzorder;
 	friend class caosVM;
 	friend class AgentRef;
+	friend class agentRegistry;
 	friend class World;
 	friend class opOVxx;
 	friend class opMVxx;
@@ -51,6 +98,7 @@ class Agent : public boost::enable_shared_from_this<Agent> {
 	friend class SFCFile;
 	friend class SFCSimpleObject;
 	friend class SFCCompoundObject;
+	friend class agentSnapshot;
 	friend class CreatureAgent;
 	friend class QtOpenc2e; // i despise c++ - fuzzie
 
@@ -65,18 +113,19 @@ private:
 protected:
 	int lastScript;
 
-	caosVar var[100]; // OVxx
-	std::map<caosVar, caosVar, caosVarCompare> name_variables;
+	agentVariables var; // OVxx
+	lazyMap<caosVar, caosVar, caosVarCompare> name_variables;
 	
 	int unused_cint;
 	
-	std::map<unsigned int, boost::shared_ptr<genomeFile> > genome_slots;
+	lazyMap<unsigned int, boost::shared_ptr<genomeFile> > genome_slots;
 	
 	class caosVM *vm;
 
 	void zotstack();
 
 	mutable int unid;
+	unsigned int handle; // our slot in agentHandles, for AgentRef
 	unsigned int zorder;
 	unsigned int tickssincelasttimer, timerrate;
 
@@ -86,18 +135,27 @@ protected:
 	int lastcollidedirection;
 
 	std::multiset<Agent *, agentzorder>::iterator zorder_iter;
-	std::list<boost::shared_ptr<Agent> >::iterator agents_iter;
 	std::list<caosVM *> vmstack; // for CALL etc
 	std::vector<AgentRef> floated;
 
 	void updateAudio(boost::shared_ptr<class AudioSource>);
 	bool dying : 1;
+	bool vmdeferred : 1; // missed its VM tick to the script budget; see World::scriptBudgetLeft
 	
 	void vmTick();
 	virtual bool fireScript(unsigned short event, Agent *from, caosVar one, caosVar two);
 
 	virtual void physicsTick();
 	void physicsTickC2();
+	void physicsDestination(float &destx, float &desty);
+	void setupCollision(physicsCollision &c, float destx, float desty);
+	void collideWithRoomSystem(physicsCollision &c);
+	void preparePhysics(physicsStep &s);
+	void applyPhysics(physicsStep &s);
+	void leftRoomSystem(physicsCollision &c);
+	bool preparePhysicsStep();
+	physicsStep physicsstep; // see World::tickPhysics
+	bool physicsdone : 1; // this tick's physicsstep has been applied already
 	
 	virtual void carry(AgentRef);
 	virtual void drop(AgentRef);
@@ -107,7 +165,7 @@ protected:
 	virtual void adjustCarried(float xoffset, float yoffset);
 
 public:
-	std::map<unsigned int, std::pair<int, int> > carry_points, carried_points;
+	lazyMap<unsigned int, std::pair<int, int> > carry_points, carried_points;
 
 	boost::shared_ptr<class VoiceData> voice;
 	std::vector<std::pair<std::string, unsigned int> > pending_voices;
@@ -118,8 +176,8 @@ public:
 	boost::shared_ptr<class AudioSource> sound;
 
 	// these are maps rather than vectors because ports can be destroyed
-	std::map<unsigned int, boost::shared_ptr<InputPort> > inports; // XXX: do these need to be shared_ptr?
-	std::map<unsigned int, boost::shared_ptr<OutputPort> > outports;
+	lazyMap<unsigned int, boost::shared_ptr<InputPort> > inports; // XXX: do these need to be shared_ptr?
+	lazyMap<unsigned int, boost::shared_ptr<OutputPort> > outports;
 
 	void join(unsigned int outid, AgentRef dest, unsigned int inid);
 
@@ -233,6 +291,11 @@ public:
 	void dropCarried(AgentRef);
 
 	bool queueScript(unsigned short event, AgentRef from = AgentRef(), caosVar p0 = caosVar(), caosVar p1 = caosVar());
+	unsigned int getInputMask() const {
+		return (imsk_key_down ? 1 : 0) | (imsk_key_up ? 2 : 0) | (imsk_mouse_move ? 4 : 0) | (imsk_mouse_down ? 8 : 0) |
+			(imsk_mouse_up ? 16 : 0) | (imsk_mouse_wheel ? 32 : 0) | (imsk_translated_char ? 64 : 0);
+	}
+	void setInputMask(unsigned int flags);
 	void stopScript();
 	void pushVM(caosVM *newvm);
 	bool vmStopped();
@@ -273,7 +336,10 @@ public:
 
 	void playAudio(std::string filename, bool controlled, bool loop);
 
-	boost::shared_ptr<genomeFile> getSlot(unsigned int s) { return genome_slots[s]; }
+	boost::shared_ptr<genomeFile> getSlot(unsigned int s) {
+		lazyMap<unsigned int, boost::shared_ptr<genomeFile> >::iterator i = genome_slots.find(s);
+		return i == genome_slots.end() ? boost::shared_ptr<genomeFile>() : i->second;
+	}
 };
 
 class LifeAssert {
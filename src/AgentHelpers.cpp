@@ -22,32 +22,74 @@
 #include "MetaRoom.h"
 #include "Room.h"
 
+#include <map>
+
+/*
+ * Memo of line-of-sight traces for the current tick, since ESEE, SEEE and the
+ * creature AI tend to ask the same questions repeatedly. The result only depends
+ * on the positions, range and PERM (and the room system), so we check them all.
+ * World::tick empties it at the start of every tick (see forgetVisibility), so
+ * entries for dead or idle agents don't outlive the tick they were made in.
+ */
+struct visibilityMemo {
+	float seerx, seery, targetx, targety, range;
+	int perm;
+	bool valid, visible;
+};
+
+static std::map<std::pair<Agent *, Agent *>, visibilityMemo> visibilitymemo;
+static unsigned int visibilitymemoversion = 0;
+
+void forgetVisibility() {
+	visibilitymemo.clear();
+}
+
 bool agentIsVisible(Agent *seeing, Agent *a, float ownerx, float ownery, MetaRoom *ownermeta, shared_ptr<Room> ownerroom) {
 	assert(ownermeta && ownerroom);
 
 	if (seeing == a) return false;
 
-	// verify we're in the same metaroom as owner, and in a room
 	float thisx = a->x + (a->getWidth() / 2.0f);
 	float thisy = a->y + (a->getHeight() / 2.0f);
+
+	// compare squared distance with range
+	float range = seeing->range.getFloat();
+	double deltax = thisx - ownerx; deltax *= deltax;
+	double deltay = thisy - ownery; deltay *= deltay;
+	if ((deltax + deltay) > (range * range)) return false;
+
+	// verify we're in the same metaroom as owner, and in a room
 	MetaRoom *m = world.map.metaRoomAt(thisx, thisy);
 	if (m != ownermeta) return false;
 	shared_ptr<Room> r = world.map.roomAt(thisx, thisy);
 	if (!r) return false;
-		
-	// compare squared distance with range
-	double deltax = thisx - ownerx; deltax *= deltax;
-	double deltay = thisy - ownery; deltay *= deltay;
-	if ((deltax + deltay) > (seeing->range.getFloat() * seeing->range.getFloat())) return false;
+
+	// cheap rejection of rooms which the line can't possibly reach
+	if (!world.map.roomsPotentiallyVisible(ownerroom.get(), r.get(), thisx, thisy, seeing->perm)) return false;
+
+	if (visibilitymemoversion != world.map.getRoomSystemVersion()) {
+		visibilitymemo.clear();
+		visibilitymemoversion = world.map.getRoomSystemVersion();
+	}
+
+	visibilityMemo &memo = visibilitymemo[std::make_pair(seeing, a)];
+	if (memo.valid && memo.seerx == ownerx && memo.seery == ownery && memo.targetx == thisx && memo.targety == thisy
+		&& memo.range == range && memo.perm == seeing->perm)
+		return memo.visible;
 
 	// do the actual visibiltiy check using a line between centers
 	Point src(ownerx, ownery), dest(thisx, thisy);
 	Line dummywall; unsigned int dummydir;
 	shared_ptr<Room> newroom = ownerroom;
 	world.map.collideLineWithRoomSystem(src, dest, newroom, src, dummywall, dummydir, seeing->perm);
-	if (src != dest) return false;
 
-	return true;
+	memo.seerx = ownerx; memo.seery = ownery;
+	memo.targetx = thisx; memo.targety = thisy;
+	memo.range = range; memo.perm = seeing->perm;
+	memo.visible = (src == dest);
+	memo.valid = true;
+
+	return memo.visible;
 }
 
 bool agentIsVisible(Agent *seeing, Agent *dest) {
@@ -69,9 +111,9 @@ std::vector<boost::shared_ptr<Agent> > getVisibleList(Agent *seeing, unsigned ch
 	shared_ptr<Room> ownerroom = world.map.roomAt(ownerx, ownery);
 	if (!ownermeta) return agents; if (!ownerroom) return agents;
 	
-	for (std::list<boost::shared_ptr<Agent> >::iterator i
+	for (agentRegistry::iterator i
 			= world.agents.begin(); i != world.agents.end(); i++) {
-		boost::shared_ptr<Agent> a = (*i);
+		boost::shared_ptr<Agent> &a = (*i);
 		if (!a) continue;
 		
 		// TODO: if owner is a creature, skip stuff with invisible attribute
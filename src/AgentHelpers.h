@@ -34,6 +34,7 @@ namespace boost {
 bool agentIsVisible(Agent *seeing, Agent *a, float ownerx, float ownery, MetaRoom *ownermeta, boost::shared_ptr<Room> ownerroom);
 bool agentIsVisible(Agent *seeing, Agent *dest);
 std::vector<boost::shared_ptr<Agent> > getVisibleList(Agent *seeing, unsigned char family, unsigned char genus, unsigned short species);
+void forgetVisibility(); // drop memoised line-of-sight results
 
 bool agentsTouching(Agent *first, Agent *second);
 boost::shared_ptr<Room> roomContainingAgent(AgentRef agent);
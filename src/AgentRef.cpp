@@ -22,26 +22,56 @@
 #include <cassert>
 #include <iostream>
 
-void AgentRef::checkLife() const {
-	assert(ref.expired() || !(ref.lock()->isDying()));
+std::vector<agentHandles::slot> *agentHandles::slots = 0;
+std::vector<unsigned int> *agentHandles::freeslots = 0;
+
+unsigned int agentHandles::alloc(Agent *a) {
+	assert(a);
+	if (!slots) {
+		slots = new std::vector<slot>();
+		freeslots = new std::vector<unsigned int>();
+	}
+
+	if (!freeslots->empty()) {
+		unsigned int index = freeslots->back();
+		freeslots->pop_back();
+		(*slots)[index].agent = a;
+		return index;
+	}
+
+	slot s;
+	s.agent = a;
+	s.generation = 1;
+	slots->push_back(s);
+	return slots->size() - 1;
+}
+
+void agentHandles::release(unsigned int index) {
+	assert(slots && index < slots->size());
+	slot &s = (*slots)[index];
+	assert(s.agent);
+	s.agent = NULL;
+	s.generation++;
+	if (s.generation == 0) s.generation = 1;
+	freeslots->push_back(index);
 }
 
 void AgentRef::set(Agent *a) {
-	if (a && !a->isDying())
-		set(a->shared_from_this());
-	else
-		ref.reset();
+	if (a && a->handle != agentHandles::nohandle) {
+		index = a->handle;
+		generation = (*agentHandles::slots)[index].generation;
+	} else
+		clear();
 }
 
 void AgentRef::dump() const {
-	std::cerr << "AgentRef " << (void *)this << " pointing to " << (void *)ref.lock().get() << std::endl;
+	std::cerr << "AgentRef " << (void *)this << " pointing to " << (void *)get() << std::endl;
 }
 
 boost::shared_ptr<Agent> AgentRef::lock() const {
-	boost::shared_ptr<Agent> p = ref.lock();
-	if (p && p->isDying())
-		p.reset();
-	return p;
+	Agent *a = get();
+	if (!a) return boost::shared_ptr<Agent>();
+	return a->shared_from_this();
 }
 
 /* vim: set noet: */
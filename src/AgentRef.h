@@ -24,49 +24,82 @@
 #include <iostream>
 #include <boost/weak_ptr.hpp>
 #include <boost/shared_ptr.hpp>
+#include <vector>
 
 class Agent;
 
+/*
+ * The table backing AgentRef: every registered agent owns one slot, and a
+ * slot's generation is bumped when its agent is killed, so a ref is valid
+ * exactly when its generation still matches.
+ *
+ * The table is never freed (or shrunk), so refs held in static objects can
+ * still be checked during shutdown.
+ */
+class agentHandles {
+	friend class AgentRef;
+
+protected:
+	struct slot {
+		Agent *agent;
+		unsigned int generation; // never 0, which is reserved for null refs
+	};
+
+	static std::vector<slot> *slots;
+	static std::vector<unsigned int> *freeslots;
+
+public:
+	static const unsigned int nohandle = ~0U;
+
+	static unsigned int alloc(Agent *a);
+	static void release(unsigned int index);
+
+	static Agent *resolve(unsigned int index, unsigned int generation) {
+		if (generation == 0) return NULL;
+		// a non-null ref can only come from alloc(), so index is in range
+		const slot &s = (*slots)[index];
+		return s.generation == generation ? s.agent : NULL;
+	}
+};
+
 class AgentRef {
 	friend class Agent;
 	
 protected:
-	boost::weak_ptr<Agent> ref;
-	void checkLife() const;
+	unsigned int index, generation;
 
 public:
 	void dump() const;
 	
-	AgentRef() { }
-	AgentRef(boost::shared_ptr<Agent> a) { ref = a; }
-	AgentRef(boost::weak_ptr<Agent> a) { ref = a; }
+	AgentRef() : index(0), generation(0) { }
+	AgentRef(boost::shared_ptr<Agent> a) { set(a.get()); }
+	AgentRef(boost::weak_ptr<Agent> a) { set(a.lock().get()); }
 	AgentRef(Agent *a) { set(a); }
-	AgentRef(const AgentRef &r) : ref(r.ref) {}
+	AgentRef(const AgentRef &r) : index(r.index), generation(r.generation) {}
 
-	void clear() { ref.reset(); }
-	
-	~AgentRef() { clear(); };
+	void clear() { index = 0; generation = 0; }
 
-	AgentRef &operator=(const AgentRef &r) { ref = r.ref; return *this; }
+	AgentRef &operator=(const AgentRef &r) { index = r.index; generation = r.generation; return *this; }
 	Agent *operator=(Agent *a) { set(a); return a; }
-	Agent &operator*() const { checkLife(); return *ref.lock().get(); }
-	Agent *operator->() const { checkLife(); return ref.lock().get(); }
-	bool operator!() const { return lock().get() == NULL; }
+	Agent &operator*() const { return *get(); }
+	Agent *operator->() const { return get(); }
+	bool operator!() const { return get() == NULL; }
 	/* This next line breaks builds with MSVC, tossing errors about ambiguous operators.
 	operator bool() const { return ref; } */
-	operator Agent *() const { return ref.lock().get(); }
-	bool operator==(const AgentRef &r) const { return lock() == r.lock(); }
-	bool operator==(const Agent *r) const { return r == lock().get(); }
+	operator Agent *() const { return get(); }
+	bool operator==(const AgentRef &r) const { return get() == r.get(); }
+	bool operator==(const Agent *r) const { return r == get(); }
 	bool operator!=(const AgentRef &r) const { return !(*this == r);}
 	bool operator!=(const Agent *r) const { return !(*this == r); }
 
 	void set(Agent *a);
-	void set(const AgentRef &r) { ref = r.ref; }
-	void set(const boost::shared_ptr<Agent> &r) { ref = r; }
-	void set(const boost::weak_ptr<Agent> &r) { ref = r; }
+	void set(const AgentRef &r) { index = r.index; generation = r.generation; }
+	void set(const boost::shared_ptr<Agent> &r) { set(r.get()); }
+	void set(const boost::weak_ptr<Agent> &r) { set(r.lock().get()); }
 
+	// only for when the agent has to outlive something; get() is much cheaper
 	boost::shared_ptr<Agent> lock() const;
-	Agent *get() const { return lock().get(); }
+	Agent *get() const { return agentHandles::resolve(index, generation); }
 };
 		
 
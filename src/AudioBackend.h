@@ -155,6 +155,9 @@ public:
 	virtual void begin() { }
 	virtual void commit() { }
 	virtual void poll() { }
+
+	// a human-readable summary of source and clip cache usage, for DBG: SOUN
+	virtual std::string getStatistics() { return std::string(); }
 };
 
 #endif
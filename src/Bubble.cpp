@@ -206,6 +206,7 @@ unsigned int BubblePart::poseForWidth(unsigned int width) {
 
 void BubblePart::setText(std::string str) {
 	unsigned int twidth = engine.backend->textWidth(str);
+	world.partsChanged();
 
 	if (engine.version == 2) {
 		unsigned int pose = poseForWidth(twidth);
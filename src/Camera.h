@@ -70,6 +70,7 @@ protected:
 
 public:
 	PartCamera(class CameraPart *p) { part = p; }
+	class CameraPart *getPart() { return part; }
 	unsigned int getWidth() const;
 	unsigned int getHeight() const;
 
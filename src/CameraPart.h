@@ -25,18 +25,31 @@
 class Camera;
 
 class CameraPart : public SpritePart {
+	friend class agentSnapshot;
+
 protected:
 	unsigned int viewheight, viewwidth, cameraheight, camerawidth;
 	shared_ptr<Camera> camera;
+
+	// the last rendered view, kept between frames
+	class Surface *surface;
+	unsigned int renderedtick, renderedx, renderedy, renderedmetaroom;
+	unsigned int refreshdivisor; // redraw at most every this many ticks (see CMRD)
+	bool starved;
+
+	bool needsRedraw();
 	
 public:
 	CameraPart(Agent *p, unsigned int _id, std::string spritefile, unsigned int fimg, int _x, int _y,
 			   unsigned int _z, unsigned int viewwidth, unsigned int viewheight,
 			   unsigned int camerawidth, unsigned int cameraheight);
+	~CameraPart();
 
 	unsigned int cameraWidth() const { return viewwidth; }
 	unsigned int cameraHeight() const { return viewheight; }
 	shared_ptr<Camera> &getCamera() { return camera; }
+	unsigned int getRefreshDivisor() const { return refreshdivisor; }
+	void setRefreshDivisor(unsigned int d) { refreshdivisor = (d == 0 ? 1 : d); }
 	void partRender(class Surface *renderer, int xoffset, int yoffset);
 	void tick();
 };
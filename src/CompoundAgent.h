@@ -71,6 +71,7 @@ public:
 	unsigned int getImageCount() { return imagecount; }
 
 	friend class caosVM;
+	friend class agentSnapshot;
 };
 
 #endif
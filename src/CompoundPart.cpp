@@ -25,6 +25,7 @@
 #include "creaturesImage.h"
 #include "Backend.h"
 #include "Agent.h"
+#include "MetaRoom.h"
 
 bool partzorder::operator ()(const CompoundPart *s1, const CompoundPart *s2) const {
 	// TODO: unsure about all of this, needs a check (but seems to work)
@@ -199,6 +200,7 @@ void SpritePart::changeSprite(std::string spritefile, unsigned int fimg) {
 	// TODO: should we preserve tint?
 
 	origsprite = sprite = spr;
+	world.partsChanged(); // the index uses the largest frame of the sprite
 
 	setPose(pose); // TODO: we need to preserve pose, but shouldn't we do some sanity checking?
 }
@@ -209,6 +211,7 @@ void SpritePart::changeSprite(shared_ptr<creaturesImage> spr) {
 	base = 0; // TODO: should we preserve base?
 
 	origsprite = sprite = spr;
+	world.partsChanged(); // the index uses the largest frame of the sprite
 
 	setPose(pose); // TODO: we need to preserve pose, but shouldn't we do some sanity checking?
 }
@@ -228,16 +231,17 @@ unsigned int CompoundPart::getZOrder() const {
 void CompoundPart::zapZOrder() {
 	renderable::zapZOrder();
 	world.zorder.erase(zorder_iter);
+	world.partsChanged();
 }
 
 void CompoundPart::addZOrder() {
 	renderable::addZOrder();
 	zorder_iter = world.zorder.insert(this);	
+	world.partsChanged();
 }
 
 void SpritePart::tint(unsigned char r, unsigned char g, unsigned char b, unsigned char rotation, unsigned char swap) {
-	sprite = origsprite->mutableCopy();
-	sprite->tint(r, g, b, rotation, swap);
+	sprite = world.gallery.getTintedImage(origsprite, r, g, b, rotation, swap);
 }
 
 DullPart::DullPart(Agent *p, unsigned int _id, std::string spritefile, unsigned int fimg, int _x, int _y,
@@ -284,16 +288,24 @@ TextPart::TextPart(Agent *p, unsigned int _id, std::string spritefile, unsigned
 	linespacing = 0; charspacing = 0;
 	horz_align = leftalign; vert_align = top;
 	currpage = 0;
+	rawtextvalid = false;
+	glyphsurface = 0;
 	recalculateData(); // ie, insert a blank first page
 }
 
 TextPart::~TextPart() {
+	freeGlyphSurface();
+}
+
+void TextPart::freeGlyphSurface() {
+	if (glyphsurface)
+		engine.backend->freeSurface(glyphsurface);
+	glyphsurface = 0;
 }
 
 void TextPart::addTint(std::string tintinfo) {
 	// add a tint, starting at text.size(), using the data in tintinfo
-	// TODO: there's some caching to be done here, but tinting is rather rare, so..
-	
+
 	unsigned short r = 128, g = 128, b = 128, rot = 128, swap = 128;
 	int where = 0;
 	std::string cur;
@@ -318,15 +330,16 @@ void TextPart::addTint(std::string tintinfo) {
 	texttintinfo t;
 	t.offset = text.size();
 
-	if (!(r == 128 && g == 128 &&  b == 128 && rot == 128 && swap == 128)) {
-		t.sprite = textsprite->mutableCopy();
-		t.sprite->tint(r, g, b, rot, swap);
-	} else t.sprite = textsprite;
+	t.sprite = world.gallery.getTintedImage(textsprite, r, g, b, rot, swap);
 
 	tints.push_back(t);
 }
 
 void TextPart::setText(std::string t) {
+	// scripts often reset the same text every tick; don't redo the layout for that
+	if (rawtextvalid && t == rawtext && layoutwidth == getWidth() && layoutheight == getHeight())
+		return;
+
 	text.clear();
 	tints.clear();
 
@@ -349,6 +362,8 @@ void TextPart::setText(std::string t) {
 	}
 	
 	recalculateData();
+	rawtext = t;
+	rawtextvalid = true;
 }
 
 void TextEntryPart::setText(std::string t) {
@@ -369,6 +384,7 @@ int TextEntryPart::handleClick(float clickx, float clicky) {
 void TextEntryPart::handleKey(char c) {
 	text.insert(caretpos, 1, c);
 	caretpos++;
+	rawtextvalid = false;
 	recalculateData();
 }
 
@@ -411,6 +427,7 @@ void TextEntryPart::handleSpecialKey(char c) {
 
 	assert(caretpos <= text.size());
 
+	rawtextvalid = false;
 	recalculateData();
 }
 
@@ -445,6 +462,10 @@ unsigned int TextPart::calculateWordWidth(std::string word) {
 void TextPart::recalculateData() {
 	linedata currentdata;
 
+	glyphsvalid = false;
+	layoutwidth = getWidth();
+	layoutheight = getHeight();
+
 	lines.clear();
 	pages.clear();
 	pageheights.clear();
@@ -527,48 +548,93 @@ void TextPart::recalculateData() {
 	pageheights.push_back(currenty);
 }
 
-void TextPart::partRender(Surface *renderer, int xoffset, int yoffset, TextEntryPart *caretdata) {
-	SpritePart::partRender(renderer, xoffset, yoffset);
-	
-	unsigned int xoff = xoffset + x + leftmargin;
-	unsigned int yoff = yoffset + y + topmargin;
-	unsigned int textwidth = getWidth() - leftmargin - rightmargin;
-	unsigned int textheight = getHeight() - topmargin - bottommargin;
-
-	unsigned int currenty = 0, usedheight = 0;
+/*
+ * Lay out the glyphs of the current page, so that rendering doesn't have to
+ * walk the lines and tints every frame.
+ */
+void TextPart::buildGlyphs() {
+	freeGlyphSurface();
+	glyphs.clear();
+	glyphsvalid = true;
+	glyphpage = currpage;
+	glyphwidth = getWidth();
+	glyphheight = getHeight();
+
+	unsigned int textwidth = glyphwidth - leftmargin - rightmargin;
+	unsigned int textheight = glyphheight - topmargin - bottommargin;
+
+	unsigned int currenty = topmargin;
 	if (vert_align == bottom)
-		currenty = textheight - pageheights[currpage];
+		currenty += textheight - pageheights[currpage];
 	else if (vert_align == middle)
-		currenty = (textheight - pageheights[currpage]) / 2;
+		currenty += (textheight - pageheights[currpage]) / 2;
 	unsigned int startline = pages[currpage];
 	unsigned int endline = (currpage + 1 < pages.size() ? pages[currpage + 1] : lines.size());
-	shared_ptr<creaturesImage> sprite = textsprite; unsigned int currtint = 0;
+	int tint = -1; unsigned int currtint = 0;
 	for (unsigned int i = startline; i < endline; i++) {	
-		unsigned int currentx = 0, somex = xoff;
+		unsigned int currentx = leftmargin;
 		if (horz_align == rightalign)
-			somex = somex + (textwidth - lines[i].width);
+			currentx += textwidth - lines[i].width;
 		else if (horz_align == centeralign)
-			somex = somex + ((textwidth - lines[i].width) / 2);
+			currentx += (textwidth - lines[i].width) / 2;
 
+		textglyph g;
+		g.y = currenty;
 		for (unsigned int x = 0; x < lines[i].text.size(); x++) {
 			if (currtint < tints.size() && tints[currtint].offset == lines[i].offset + x) {
-				sprite = tints[currtint].sprite;
+				tint = currtint;
 				currtint++;
 			}
 		
 			if (lines[i].text[x] < 32) continue; // TODO: replace with space or similar?
-			int spriteid = lines[i].text[x] - 32;
-			renderer->render(sprite, spriteid, somex + currentx, yoff + currenty, has_alpha, alpha);
-			if ((caretdata) && (caretdata->caretpos == lines[i].offset + x))
-				caretdata->renderCaret(renderer, somex + currentx, yoff + currenty);
-			currentx += textsprite->width(spriteid) + charspacing;
+			g.x = currentx;
+			g.spriteid = lines[i].text[x] - 32;
+			g.tint = tint;
+			g.offset = lines[i].offset + x;
+			glyphs.push_back(g);
+			currentx += textsprite->width(g.spriteid) + charspacing;
 		}
-		if ((caretdata) && (caretdata->caretpos == lines[i].offset + lines[i].text.size()))
-			caretdata->renderCaret(renderer, somex + currentx, yoff + currenty);		
+		g.x = currentx;
+		g.spriteid = -1;
+		g.tint = -1;
+		g.offset = lines[i].offset + lines[i].text.size();
+		glyphs.push_back(g);
 		currenty += textsprite->height(0) + linespacing + 1;
 	}
 }
 
+void TextPart::partRender(Surface *renderer, int xoffset, int yoffset, TextEntryPart *caretdata) {
+	SpritePart::partRender(renderer, xoffset, yoffset);
+
+	if (!glyphsvalid || glyphpage != currpage || glyphwidth != getWidth() || glyphheight != getHeight())
+		buildGlyphs();
+
+	int xoff = xoffset + x;
+	int yoff = yoffset + y;
+
+	// composite the run into its own surface the first time it's drawn, then
+	// blit that; backends without offscreen surfaces draw glyph by glyph
+	if (!glyphsurface && glyphwidth > 0 && glyphheight > 0) {
+		glyphsurface = engine.backend->newSurface(glyphwidth, glyphheight);
+		if (glyphsurface) {
+			for (std::vector<textglyph>::iterator i = glyphs.begin(); i != glyphs.end(); i++) {
+				if (i->spriteid != -1)
+					glyphsurface->render(i->tint == -1 ? textsprite : tints[i->tint].sprite, i->spriteid, i->x, i->y);
+			}
+		}
+	}
+
+	if (glyphsurface)
+		renderer->renderSurface(glyphsurface, xoff, yoff, has_alpha, alpha);
+
+	for (std::vector<textglyph>::iterator i = glyphs.begin(); i != glyphs.end(); i++) {
+		if (!glyphsurface && i->spriteid != -1)
+			renderer->render(i->tint == -1 ? textsprite : tints[i->tint].sprite, i->spriteid, xoff + i->x, yoff + i->y, has_alpha, alpha);
+		if ((caretdata) && (caretdata->caretpos == i->offset))
+			caretdata->renderCaret(renderer, xoff + i->x, yoff + i->y);
+	}
+}
+
 FixedTextPart::FixedTextPart(Agent *p, unsigned int _id, std::string spritefile, unsigned int fimg, int _x, int _y,
 		                                  unsigned int _z, std::string fontsprite) : TextPart(p, _id, spritefile, fimg, _x, _y, _z, fontsprite) {
 	// nothing, hopefully.. :)
@@ -656,6 +722,30 @@ CameraPart::CameraPart(Agent *p, unsigned int _id, std::string spritefile, unsig
 	camerawidth = camera_width;
 	cameraheight = camera_height;
 	camera = shared_ptr<Camera>(new PartCamera(this));
+
+	surface = 0;
+	renderedtick = renderedx = renderedy = renderedmetaroom = 0;
+	// new cameras start with the engine-wide default, which CMRD can override per camera
+	caosVar &divisor = world.variables["engine_remote_camera_divisor"];
+	setRefreshDivisor((divisor.hasInt() && divisor.getInt() > 0) ? divisor.getInt() : 1);
+	starved = false;
+}
+
+CameraPart::~CameraPart() {
+	if (surface)
+		engine.backend->freeSurface(surface);
+}
+
+/*
+ * The view only needs redrawing if the world has ticked (at most every
+ * refreshdivisor ticks) or the camera has moved since we last drew it.
+ */
+bool CameraPart::needsRedraw() {
+	if (!surface) return true;
+	if (camera->getX() != renderedx || camera->getY() != renderedy) return true;
+	MetaRoom *m = camera->getMetaRoom();
+	if ((m ? m->id : (unsigned int)-1) != renderedmetaroom) return true;
+	return world.tickcount - renderedtick >= refreshdivisor;
 }
 
 void CameraPart::partRender(class Surface *renderer, int xoffset, int yoffset) {
@@ -664,11 +754,32 @@ void CameraPart::partRender(class Surface *renderer, int xoffset, int yoffset) {
 		// make sure we're onscreen before bothering to do any work..
 		if (xoffset + x + (int)camerawidth >= 0 && yoffset + y + (int)cameraheight >= 0 &&
 			xoffset + x < (int)renderer->getWidth() && yoffset + y < (int)renderer->getHeight()) {
-			Surface *surface = engine.backend->newSurface(viewwidth, viewheight);
-			assert(surface); // TODO: good behaviour?
-			world.drawWorld(camera.get(), surface);
+			if (needsRedraw()) {
+				// remote cameras share a time budget per frame; a camera which
+				// had to skip a redraw gets to go first next time
+				static unsigned int budgetslot = world.variables.slot("engine_remote_camera_budget");
+				caosVar &b = world.variables.get(budgetslot);
+				int budget = (b.hasInt() ? b.getInt() : 0);
+				if (surface && !starved && budget > 0 && world.remotecameratime >= (unsigned int)budget) {
+					starved = true;
+				} else {
+					unsigned int start = engine.backend->ticks();
+					if (!surface) {
+						surface = engine.backend->newSurface(viewwidth, viewheight);
+						assert(surface); // TODO: good behaviour?
+					}
+					world.drawWorld(camera.get(), surface);
+
+					MetaRoom *m = camera->getMetaRoom();
+					renderedmetaroom = (m ? m->id : (unsigned int)-1);
+					renderedx = camera->getX();
+					renderedy = camera->getY();
+					renderedtick = world.tickcount;
+					starved = false;
+					world.remotecameratime += engine.backend->ticks() - start;
+				}
+			}
 			renderer->blitSurface(surface, xoffset + x, yoffset + y, camerawidth, cameraheight);
-			engine.backend->freeSurface(surface);
 		}
 	}
 	
@@ -95,6 +95,8 @@ public:
 };
 
 class SpritePart : public AnimatablePart {
+	friend class agentSnapshot;
+
 protected:
 	shared_ptr<creaturesImage> origsprite, sprite;
 	unsigned int firstimg, pose, base, spriteno;
@@ -129,6 +131,8 @@ public:
 };
 
 class ButtonPart : public SpritePart {
+	friend class agentSnapshot;
+
 protected:
 	bool hitopaquepixelsonly;
 	int messageid;
@@ -164,10 +168,20 @@ struct texttintinfo {
 	unsigned int offset;
 };
 
+// a single glyph of laid-out text, relative to the part; spriteid -1 marks a line end (for the caret)
+struct textglyph {
+	int x, y;
+	int spriteid;
+	int tint; // index into tints, or -1 for the plain font
+	unsigned int offset; // into the text
+};
+
 enum horizontalalign { leftalign, centeralign, rightalign };
 enum verticalalign { top, middle, bottom };
 
 class TextPart : public SpritePart {
+	friend class agentSnapshot;
+
 protected:
 	std::vector<texttintinfo> tints;
 	std::vector<linedata> lines;
@@ -184,17 +198,31 @@ protected:
 	verticalalign vert_align;	
 	bool last_page_scroll;
 
+	// glyph run for the current page, rebuilt when the layout or page changes
+	std::vector<textglyph> glyphs;
+	bool glyphsvalid;
+	unsigned int glyphpage, glyphwidth, glyphheight;
+	// the run composited once, so a frame is a single blit (null until drawn)
+	class Surface *glyphsurface;
+
+	// the text as last passed to setText, so unchanged text can skip layout
+	std::string rawtext;
+	bool rawtextvalid;
+	unsigned int layoutwidth, layoutheight;
+
 	TextPart(Agent *p, unsigned int _id, std::string spritefile, unsigned int fimg, int _x, int _y, unsigned int _z, std::string fontsprite);
 	~TextPart();
 	void recalculateData();
 	unsigned int calculateWordWidth(std::string word);
 	void addTint(std::string tintinfo);
+	void buildGlyphs();
+	void freeGlyphSurface();
 
 public:
 	virtual void setText(std::string t);
 	std::string getText() { return text; }
 	unsigned int noPages() { return pages.size(); }
-	void setPage(unsigned int p) { currpage = p; }
+	void setPage(unsigned int p) { if (p != currpage) { currpage = p; glyphsvalid = false; } }
 	unsigned int getPage() { return currpage; }
 	void partRender(class Surface *renderer, int xoffset, int yoffset, class TextEntryPart *caretdata);
 	void partRender(class Surface *renderer, int xoffset, int yoffset) { partRender(renderer, xoffset, yoffset, 0); }
@@ -223,6 +251,7 @@ private:
 	void renderCaret(class Surface *renderer, int xoffset, int yoffset);
 
 	friend class TextPart;
+	friend class agentSnapshot;
 
 public:
 	TextEntryPart(Agent *p, unsigned int _id, std::string spritefile, unsigned int fimg, int _x, int _y,
@@ -30,6 +30,8 @@
 #include "SFCFile.h"
 #include "peFile.h"
 #include "Camera.h"
+#include "mapSnapshot.h"
+#include "caosAOT.h" // loadNativeScripts()
 
 #include <boost/filesystem/path.hpp>
 #include <boost/filesystem/operations.hpp>
@@ -56,6 +58,8 @@ Engine::Engine() {
 	dorendering = true;
 	fastticks = false;
 	refreshdisplay = false;
+	networkbatch = false;
+	autosaveinterval = 0;
 
 	bmprenderer = false;
 
@@ -152,17 +156,39 @@ void Engine::loadGameData() {
 	}
 }
 
+#define NETWORK_SCRIPT_CACHE_SIZE 128
+
 std::string Engine::executeNetwork(std::string in) {
 	// now parse and execute the CAOS we obtained
 	caosVM vm(0); // needs to be outside 'try' so we can reset outputstream on exception
 	try {
-		std::istringstream s(in);
-		caosScript script(world.gametype, "<network>"); // XXX
-		script.parse(s);
-		script.installScripts();
+		// debug tools tend to send the same queries over and over, so reuse the compiled
+		// code if we've seen this exact text before (dropping the least recently used)
+		shared_ptr<caosScript> script;
+		std::map<std::string, networkScriptEntry>::iterator cached = networkscripts.find(in);
+		if (cached != networkscripts.end()) {
+			networkscriptlru.splice(networkscriptlru.begin(), networkscriptlru, cached->second.lru);
+			script = cached->second.script;
+		} else {
+			std::istringstream s(in);
+			script = shared_ptr<caosScript>(new caosScript(world.gametype, "<network>")); // XXX
+			script->parse(s);
+			// only cache plain snippets; anything with event scripts is an injection, which is rarely repeated
+			if (script->scripts.empty()) {
+				while (networkscripts.size() >= NETWORK_SCRIPT_CACHE_SIZE) {
+					networkscripts.erase(networkscriptlru.back());
+					networkscriptlru.pop_back();
+				}
+				networkscriptlru.push_front(in);
+				networkScriptEntry &e = networkscripts[in];
+				e.script = script;
+				e.lru = networkscriptlru.begin();
+			}
+		}
+		script->installScripts();
 		std::ostringstream o;
 		vm.setOutputStream(o);
-		vm.runEntirely(script.installer);
+		vm.runEntirely(script->installer);
 		vm.outputstream = 0; // otherwise would point to dead stack
 		return o.str();
 	} catch (std::exception &e) {
@@ -255,7 +281,8 @@ void Engine::handleKeyboardScrolling() {
 	static float vely = 0;
 
 	bool wasdMode = false;
-	caosVar v = world.variables["engine_wasd"];
+	static unsigned int wasdslot = world.variables.slot("engine_wasd");
+	caosVar v = world.variables.get(wasdslot);
 	if (v.hasInt()) {
 		switch (v.getInt()) {
 			case 1: // enable if CTRL is held
@@ -319,17 +346,31 @@ void Engine::handleKeyboardScrolling() {
 }
 
 void Engine::processEvents() {
-	SomeEvent event;
+	// mouse moves are merged until something else happens (or we run out of
+	// events), so agents get at most one raw mouse move per batch
+	SomeEvent event, mousemove;
+	bool havemousemove = false;
 	while (backend->pollEvent(event)) {
+		if (event.type == eventmousemove) {
+			if (havemousemove) {
+				event.xrel += mousemove.xrel;
+				event.yrel += mousemove.yrel;
+			}
+			mousemove = event;
+			havemousemove = true;
+			continue;
+		}
+
+		if (havemousemove) {
+			handleMouseMove(mousemove);
+			havemousemove = false;
+		}
+
 		switch (event.type) {
 			case eventresizewindow:
 				handleResizedWindow(event);
 				break;
 
-			case eventmousemove:
-				handleMouseMove(event);
-				break;
-
 			case eventmousebuttonup:
 			case eventmousebuttondown:
 				handleMouseButton(event);
@@ -355,11 +396,14 @@ void Engine::processEvents() {
 				break;
 		}
 	}
+
+	if (havemousemove)
+		handleMouseMove(mousemove);
 }
 
 void Engine::handleResizedWindow(SomeEvent &event) {
 	// notify agents
-	for (std::list<boost::shared_ptr<Agent> >::iterator i = world.agents.begin(); i != world.agents.end(); i++) {
+	for (agentRegistry::iterator i = world.agents.begin(); i != world.agents.end(); i++) {
 		if (!*i) continue;
 		(*i)->queueScript(123, 0); // window resized script
 	}
@@ -370,52 +414,39 @@ void Engine::handleMouseMove(SomeEvent &event) {
 	world.hand()->handleEvent(event);
 
 	// notify agents
-	for (std::list<boost::shared_ptr<Agent> >::iterator i = world.agents.begin(); i != world.agents.end(); i++) {
-		if (!*i) continue;
-		if ((*i)->imsk_mouse_move) {
-			caosVar x; x.setFloat(world.hand()->pointerX());
-			caosVar y; y.setFloat(world.hand()->pointerY());
-			(*i)->queueScript(75, 0, x, y); // Raw Mouse Move
-		}
-	}
+	caosVar x; x.setFloat(world.hand()->pointerX());
+	caosVar y; y.setFloat(world.hand()->pointerY());
+	world.queueInputScript(IMSK_MOUSE_MOVE, 75, x, y); // Raw Mouse Move
 }
 
 void Engine::handleMouseButton(SomeEvent &event) {
-	// notify agents
-	for (std::list<boost::shared_ptr<Agent> >::iterator i = world.agents.begin(); i != world.agents.end(); i++) {
-		if (!*i) continue;
-		if ((event.type == eventmousebuttonup && (*i)->imsk_mouse_up) ||
-			(event.type == eventmousebuttondown && (*i)->imsk_mouse_down)) {
-			// set the button value as necessary
-			caosVar button;
-			switch (event.button) { // Backend guarantees that only one button will be set on a mousebuttondown event.
-				// the values here make fuzzie suspicious that c2e combines these events
-				// nornagon seems to think c2e doesn't
-				case buttonleft: button.setInt(1); break;
-				case buttonright: button.setInt(2); break;
-				case buttonmiddle: button.setInt(4); break;
-				default: break;
-			}
-
-			// if it was a mouse button we're interested in, then fire the relevant raw event
-			if (button.getInt() != 0) {
-				if (event.type == eventmousebuttonup)
-					(*i)->queueScript(77, 0, button); // Raw Mouse Up
-				else
-					(*i)->queueScript(76, 0, button); // Raw Mouse Down
-			}
-		}
-		if ((event.type == eventmousebuttondown &&
-			(event.button == buttonwheelup || event.button == buttonwheeldown) &&
-			(*i)->imsk_mouse_wheel)) {
-			// fire the mouse wheel event with the relevant delta value
-			caosVar delta;
-			if (event.button == buttonwheeldown)
-				delta.setInt(-120);
-			else
-				delta.setInt(120);
-			(*i)->queueScript(78, 0, delta); // Raw Mouse Wheel
-		}
+	// notify agents, setting the button value as necessary
+	caosVar button;
+	switch (event.button) { // Backend guarantees that only one button will be set on a mousebuttondown event.
+		// the values here make fuzzie suspicious that c2e combines these events
+		// nornagon seems to think c2e doesn't
+		case buttonleft: button.setInt(1); break;
+		case buttonright: button.setInt(2); break;
+		case buttonmiddle: button.setInt(4); break;
+		default: break;
+	}
+
+	// if it was a mouse button we're interested in, then fire the relevant raw event
+	if (button.getInt() != 0) {
+		if (event.type == eventmousebuttonup)
+			world.queueInputScript(IMSK_MOUSE_UP, 77, button); // Raw Mouse Up
+		else
+			world.queueInputScript(IMSK_MOUSE_DOWN, 76, button); // Raw Mouse Down
+	}
+	if (event.type == eventmousebuttondown &&
+		(event.button == buttonwheelup || event.button == buttonwheeldown)) {
+		// fire the mouse wheel event with the relevant delta value
+		caosVar delta;
+		if (event.button == buttonwheeldown)
+			delta.setInt(-120);
+		else
+			delta.setInt(120);
+		world.queueInputScript(IMSK_MOUSE_WHEEL, 78, delta); // Raw Mouse Wheel
 	}
 
 	world.hand()->handleEvent(event);
@@ -444,11 +475,7 @@ void Engine::handleKeyDown(SomeEvent &event) {
 	// notify agents
 	caosVar k;
 	k.setInt(event.key);
-	for (std::list<boost::shared_ptr<Agent> >::iterator i = world.agents.begin(); i != world.agents.end(); i++) {
-		if (!*i) continue;
-		if ((*i)->imsk_translated_char)
-			(*i)->queueScript(79, 0, k); // translated char script
-	}
+	world.queueInputScript(IMSK_TRANSLATED_CHAR, 79, k); // translated char script
 }
 
 void Engine::handleSpecialKeyUp(SomeEvent &event) {
@@ -486,7 +513,8 @@ void Engine::handleSpecialKeyDown(SomeEvent &event) {
 
 
 	// handle debug keys, if they're enabled
-	caosVar v = world.variables["engine_debug_keys"];
+	static unsigned int debugkeysslot = world.variables.slot("engine_debug_keys");
+	caosVar v = world.variables.get(debugkeysslot);
 	if (v.hasInt() && v.getInt() == 1) {
 		if (backend->keyDown(16)) { // shift down
 			MetaRoom *n; // for pageup/pagedown
@@ -537,11 +565,7 @@ void Engine::handleSpecialKeyDown(SomeEvent &event) {
 	// notify agents
 	caosVar k;
 	k.setInt(event.key);
-	for (std::list<boost::shared_ptr<Agent> >::iterator i = world.agents.begin(); i != world.agents.end(); i++) {
-		if (!*i) continue;
-		if ((*i)->imsk_key_down)
-			(*i)->queueScript(73, 0, k); // key down script
-	}
+	world.queueInputScript(IMSK_KEY_DOWN, 73, k); // key down script
 }
 
 static const char data_default[] = "./data";
@@ -591,6 +615,12 @@ bool Engine::parseCommandLine(int argc, char *argv[]) {
 		("norun,n", "Don't run the game, just execute scripts")
 		("autokill,a", "Enable autokill")
 		("autostop", "Enable autostop (or disable it, for CV)")
+		("netbatch", "Run every pending network request each tick, rather than one per connection")
+		("autosave", po::value<unsigned int>(&autosaveinterval), "Save the world every this many minutes")
+		("scriptbudget", po::value<unsigned int>(&world.scriptbudget), "Limit agent scripts to about this many CAOS ops per tick")
+		("aot", po::value< std::vector<std::string> >(&cmdline_aotmodules)->composing(),
+		 "Load natively compiled scripts from this module (see DBG: AOTC)")
+		("physicsthreads", po::value<unsigned int>(&world.physicsthreads), "Move agents in a separate physics phase on this many threads")
 		;
 	po::variables_map vm;
 	po::store(po::parse_command_line(argc, argv, desc), vm);
@@ -617,6 +647,13 @@ bool Engine::parseCommandLine(int argc, char *argv[]) {
 		world.autostop = true;
 	}
 
+	if (vm.count("netbatch")) {
+		networkbatch = true;
+	}
+
+	if (autosaveinterval && !mapSnapshot::supported())
+		throw creaturesException("--autosave needs serialization support, which this build of openc2e doesn't have");
+
 	if (vm.count("data-path") == 0) {
 		std::cout << "Warning: No data path specified, trying default of '" << data_default << "', see --help if you need to specify one." << std::endl;
 		data_vec.push_back(data_default);
@@ -695,6 +732,8 @@ bool Engine::initialSetup() {
 	
 	// initial setup
 	registerDelegates();
+	for (std::vector<std::string>::iterator i = cmdline_aotmodules.begin(); i != cmdline_aotmodules.end(); i++)
+		loadNativeScripts(*i);
 	std::cout << "* Reading catalogue files..." << std::endl;
 	world.initCatalogue();
 	std::cout << "* Initial setup..." << std::endl;
@@ -792,8 +831,7 @@ bool Engine::initialSetup() {
 					throw creaturesException("non-existant bootstrap file provided in C1/C2 mode");
 				// TODO: the default SFCFile loading code is in World, maybe this should be too..
 				SFCFile sfc;
-				std::ifstream f(scriptdir.native_directory_string().c_str(), std::ios::binary);
-				f >> std::noskipws;
+				mmapifstream f(scriptdir.native_directory_string());
 				sfc.read(&f);
 				sfc.copyToWorld();
 			}
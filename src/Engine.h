@@ -22,12 +22,19 @@
 
 #include "caosVar.h"
 #include <map>
+#include <list>
 #include <boost/filesystem/path.hpp>
 
 class Backend;
 class AudioBackend;
+class caosScript;
 struct SomeEvent;
 
+struct networkScriptEntry {
+	boost::shared_ptr<caosScript> script;
+	std::list<std::string>::iterator lru;
+};
+
 class Engine {
 protected:
 	unsigned int tickdata;
@@ -41,6 +48,7 @@ protected:
 	bool cmdline_enable_sound;
 	bool cmdline_norun;
 	std::vector<std::string> cmdline_bootstrap;
+	std::vector<std::string> cmdline_aotmodules;
 
 	std::string gamename;
 
@@ -59,6 +67,10 @@ protected:
 	class peFile *exefile;
 	void loadGameData();
 
+	// compiled network snippets, keyed by source (see executeNetwork)
+	std::map<std::string, networkScriptEntry> networkscripts;
+	std::list<std::string> networkscriptlru;
+
 public:
 	std::map<caosVar, caosVar, caosVarCompare> eame_variables; // non-serialised
 	
@@ -75,6 +87,8 @@ public:
 
 	bool done;
 	bool dorendering, fastticks, refreshdisplay;
+	bool networkbatch;
+	unsigned int autosaveinterval; // in minutes, 0 for none
 	unsigned int version;
 	bool bmprenderer;
 
@@ -22,9 +22,20 @@
 #include "Room.h"
 #include "MetaRoom.h"
 #include <iostream>
+#include <algorithm>
+#include <set>
+#include <cassert>
 #include "Engine.h"
 
 void Map::Reset() {
+	// doors are shared between the two rooms they connect, and belong to neither
+	std::set<RoomDoor *> doors;
+	for (std::vector<shared_ptr<Room> >::iterator i = rooms.begin(); i != rooms.end(); i++)
+		for (std::map<boost::weak_ptr<Room>,RoomDoor *>::iterator j = (*i)->doors.begin(); j != (*i)->doors.end(); j++)
+			doors.insert(j->second);
+	for (std::set<RoomDoor *>::iterator i = doors.begin(); i != doors.end(); i++)
+		delete *i;
+
 	for (std::vector<MetaRoom *>::iterator i = metarooms.begin(); i != metarooms.end(); i++) {
 		delete *i;
 	}
@@ -32,6 +43,72 @@ void Map::Reset() {
 	// todo: metarooms should be responsible for deleting rooms, so use the following instead of clear:
 	// assert(rooms.empty());
 	rooms.clear();
+	roomSystemChanged(true);
+}
+
+/*
+ * Exchanges the rooms and metarooms of two maps, eg to put a loaded map in place.
+ */
+void Map::swap(Map &other) {
+	std::swap(width, other.width);
+	std::swap(height, other.height);
+	metarooms.swap(other.metarooms);
+	rooms.swap(other.rooms);
+	std::swap(room_base, other.room_base);
+	std::swap(metaroom_base, other.metaroom_base);
+	roomSystemChanged(true);
+	other.roomSystemChanged(true);
+}
+
+/*
+ * Makes 'out', which must be empty, an independent copy of this map, so it can
+ * be read (eg, serialised on another thread) while this one carries on changing.
+ */
+void Map::copyTo(Map &out) {
+	assert(out.metarooms.empty() && out.rooms.empty());
+	out.width = width;
+	out.height = height;
+	out.room_base = room_base;
+	out.metaroom_base = metaroom_base;
+
+	std::map<Room *, shared_ptr<Room> > newrooms;
+	for (std::vector<shared_ptr<Room> >::iterator i = rooms.begin(); i != rooms.end(); i++) {
+		shared_ptr<Room> r(new Room(**i));
+		newrooms[i->get()] = r;
+		out.rooms.push_back(r);
+	}
+
+	for (std::vector<MetaRoom *>::iterator i = metarooms.begin(); i != metarooms.end(); i++) {
+		MetaRoom *m = new MetaRoom(**i);
+		m->rooms.clear();
+		for (std::vector<shared_ptr<Room> >::iterator j = (*i)->rooms.begin(); j != (*i)->rooms.end(); j++) {
+			std::map<Room *, shared_ptr<Room> >::iterator r = newrooms.find(j->get());
+			if (r == newrooms.end()) continue;
+			r->second->metaroom = m;
+			m->rooms.push_back(r->second);
+		}
+		out.metarooms.push_back(m);
+	}
+
+	// point the copied doors at the copied rooms
+	std::map<RoomDoor *, RoomDoor *> newdoors;
+	for (std::vector<shared_ptr<Room> >::iterator i = out.rooms.begin(); i != out.rooms.end(); i++) {
+		std::map<boost::weak_ptr<Room>,RoomDoor *> olddoors;
+		olddoors.swap((*i)->doors);
+		for (std::map<boost::weak_ptr<Room>,RoomDoor *>::iterator j = olddoors.begin(); j != olddoors.end(); j++) {
+			std::map<Room *, shared_ptr<Room> >::iterator other = newrooms.find(j->first.lock().get());
+			if (other == newrooms.end()) continue;
+			RoomDoor *&door = newdoors[j->second];
+			if (!door) {
+				door = new RoomDoor(*j->second);
+				door->first = newrooms[j->second->first.lock().get()];
+				door->second = newrooms[j->second->second.lock().get()];
+			}
+			(*i)->doors[other->second] = door;
+		}
+	}
+
+	out.roomSystemChanged(true);
 }
 
 void Map::SetMapDimensions(unsigned int w, unsigned int h) {
@@ -127,6 +204,121 @@ bool Map::collideLineWithRoomSystem(Point src, Point dest, shared_ptr<Room> &roo
 	}
 }
 
+void Map::roomSystemChanged(bool geometry) {
+	roomsystemversion++;
+	visibilitygroups.clear();
+	if (geometry) roomgeometrydirty = true;
+}
+
+/*
+ * Work out which rooms a line leaving each room could step into next; see
+ * collideLineWithRoomBoundaries, which moves into either a room it has a door
+ * to, or whatever room roomAt() finds half a pixel past the boundary. So the
+ * neighbours of a room are all rooms within a pixel of its bounding box
+ * (or of a wrapped copy of it, in wraparound metarooms).
+ */
+void Map::calculateRoomNeighbours() {
+	roomindices.clear();
+	roomneighbours.clear();
+	visibilitygroups.clear();
+
+	for (unsigned int i = 0; i < rooms.size(); i++)
+		roomindices[rooms[i].get()] = i;
+	roomneighbours.resize(rooms.size());
+
+	for (std::vector<MetaRoom *>::iterator m = metarooms.begin(); m != metarooms.end(); m++) {
+		for (std::vector<shared_ptr<Room> >::iterator i = (*m)->rooms.begin(); i != (*m)->rooms.end(); i++) {
+			Room *a = i->get();
+			unsigned int aindex = roomindices[a];
+			float top = std::min(a->y_left_ceiling, a->y_right_ceiling) - 1.0f;
+			float bottom = std::max(a->y_left_floor, a->y_right_floor) + 1.0f;
+
+			for (unsigned int j = 0; j < rooms.size(); j++) {
+				Room *b = rooms[j].get();
+				if (a == b) continue;
+				if (bottom < std::min(b->y_left_ceiling, b->y_right_ceiling)) continue;
+				if (top > std::max(b->y_left_floor, b->y_right_floor)) continue;
+
+				for (int shift = -1; shift <= 1; shift++) {
+					if (shift != 0 && !(*m)->wraparound()) continue;
+					float left = a->x_left - 1.0f + shift * (float)(*m)->width();
+					float right = a->x_right + 1.0f + shift * (float)(*m)->width();
+					if (right < b->x_left || left > b->x_right) continue;
+					roomneighbours[aindex].push_back(j);
+					break;
+				}
+			}
+		}
+	}
+
+	roomgeometrydirty = false;
+}
+
+/*
+ * Returns the connected components of the room graph for the given PERM, where
+ * rooms are connected if a line could pass directly between them: through a
+ * door with enough permeability, or between neighbouring rooms without a door.
+ */
+std::vector<unsigned int> &Map::visibilityGroupsFor(int perm) {
+	if (roomgeometrydirty || roomindices.size() != rooms.size())
+		calculateRoomNeighbours();
+
+	std::map<int, std::vector<unsigned int> >::iterator cached = visibilitygroups.find(perm);
+	if (cached != visibilitygroups.end()) return cached->second;
+
+	std::vector<unsigned int> &groups = visibilitygroups[perm];
+	groups.resize(rooms.size());
+	for (unsigned int i = 0; i < groups.size(); i++)
+		groups[i] = i;
+
+	for (unsigned int i = 0; i < rooms.size(); i++) {
+		for (std::vector<unsigned int>::iterator j = roomneighbours[i].begin(); j != roomneighbours[i].end(); j++) {
+			std::map<boost::weak_ptr<Room>,RoomDoor *>::iterator door = rooms[i]->doors.find(rooms[*j]);
+			if (door != rooms[i]->doors.end() && perm > door->second->perm) continue;
+
+			// union, with path halving
+			unsigned int a = i, b = *j;
+			while (groups[a] != a) a = groups[a] = groups[groups[a]];
+			while (groups[b] != b) b = groups[b] = groups[groups[b]];
+			if (a != b) groups[std::max(a, b)] = std::min(a, b);
+		}
+	}
+
+	for (unsigned int i = 0; i < groups.size(); i++)
+		groups[i] = groups[groups[i]];
+
+	return groups;
+}
+
+/*
+ * Cheap early rejection for line-of-sight checks: returns false only if no line
+ * starting in 'from' could reach the point (tox, toy) in 'to' through the room
+ * system with the given PERM. If this returns true, you still need to trace the line.
+ */
+bool Map::roomsPotentiallyVisible(Room *from, Room *to, float tox, float toy, int perm) {
+	assert(from && to);
+	if (from == to) return true;
+
+	std::vector<unsigned int> &groups = visibilityGroupsFor(perm);
+	std::map<Room *, unsigned int>::iterator fromindex = roomindices.find(from), toindex = roomindices.find(to);
+	if (fromindex == roomindices.end() || toindex == roomindices.end()) return true; // not in the map?
+	unsigned int group = groups[fromindex->second];
+	if (groups[toindex->second] == group) return true;
+
+	// the line might end in a different room which also contains the point (overlapping rooms, or shared edges)
+	std::vector<unsigned int> &neighbours = roomneighbours[toindex->second];
+	for (std::vector<unsigned int>::iterator i = neighbours.begin(); i != neighbours.end(); i++) {
+		if (groups[*i] != group) continue;
+		Room *r = rooms[*i].get();
+		MetaRoom *m = r->metaroom;
+		if (r->containsPoint(tox, toy)) return true;
+		if (!m) return true; // can't check wraparound, so be conservative
+		if (m->wraparound() && (r->containsPoint(tox - m->width(), toy) || r->containsPoint(tox + m->width(), toy))) return true;
+	}
+
+	return false;
+}
+
 /*
  * poss. optimisation: skip checking the rest of the lines if our distance is 0?
  */
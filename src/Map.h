@@ -23,6 +23,7 @@
 #include "physics.h"
 #include "openc2e.h"
 #include <vector>
+#include <map>
 
 class Room;
 class MetaRoom;
@@ -36,6 +37,16 @@ protected:
 
 	friend class MetaRoom;
 
+	// potentially visible sets for line-of-sight checks, see roomsPotentiallyVisible
+	std::map<Room *, unsigned int> roomindices;
+	std::vector<std::vector<unsigned int> > roomneighbours;
+	std::map<int, std::vector<unsigned int> > visibilitygroups;
+	bool roomgeometrydirty;
+	unsigned int roomsystemversion;
+
+	void calculateRoomNeighbours();
+	std::vector<unsigned int> &visibilityGroupsFor(int perm);
+
 public:
 	/* Get a room, any room.
 	 *
@@ -47,9 +58,11 @@ public:
 	
 	unsigned int room_base, metaroom_base;
 	
-	Map() { width = 0; height = 0; room_base = 0; metaroom_base = 0; }
+	Map() { width = 0; height = 0; room_base = 0; metaroom_base = 0; roomgeometrydirty = true; roomsystemversion = 0; }
 
 	void Reset();
+	void swap(Map &other);
+	void copyTo(Map &out);
 	void SetMapDimensions(unsigned int, unsigned int);
 	unsigned int getWidth() { return width; }
 	unsigned int getHeight() { return height; }
@@ -69,6 +82,11 @@ public:
 	bool collideLineWithRoomSystem(Point src, Point dest, shared_ptr<Room> &room, Point &where, Line &wall, unsigned int &walldir, int perm);
 	bool collideLineWithRoomBoundaries(Point src, Point dest, shared_ptr<Room> room, shared_ptr<Room> &newroom, Point &where, Line &wall, unsigned int &walldir, int perm);
 
+	// must be called whenever rooms are added or door permeabilities change
+	void roomSystemChanged(bool geometry = false);
+	unsigned int getRoomSystemVersion() { return roomsystemversion; }
+	bool roomsPotentiallyVisible(Room *from, Room *to, float tox, float toy, int perm);
+
 	void tick();
 };
 
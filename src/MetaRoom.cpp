@@ -133,6 +133,8 @@ unsigned int MetaRoom::addRoom(shared_ptr<Room> r) {
 	// add to both our local list and the global list
 	rooms.push_back(r);
 	world.map.rooms.push_back(r);
+	r->metaroom = this;
+	world.map.roomSystemChanged(true);
 
 	// set the id and return
 	r->id = world.map.room_base++;
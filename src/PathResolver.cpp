@@ -29,6 +29,7 @@
 #include <algorithm>
 #include <iostream>
 #include <sstream>
+#include <ctime>
 
 using std::map;
 using std::set;
@@ -37,6 +38,8 @@ using namespace boost::filesystem;
 
 static set<string> dircache;
 static map<string, string> cache;
+static map<string, std::time_t> dirscantimes; // when findByWildcard last listed each dir
+static map<string, boost::regex> searchpatterns;
 
 static bool checkDirCache(path &dir);
 static bool doCacheDir(path &dir);
@@ -65,6 +68,7 @@ bool resolveFile(path &p) {
 		// Maybe something changed underneath us; reset the cache and try again
 		cache.clear();
 		dircache.clear();
+		dirscantimes.clear();
 		if (!resolveFile(s))
 			return false;
 	}
@@ -174,10 +178,22 @@ static boost::regex constructSearchPattern(const std::string &wild) {
 	return boost::regex(matchstr.c_str());
 }
 
-std::vector<std::string> findByWildcard(std::string dir, std::string wild) {
-	cache.clear();
-	dircache.clear();
+/* Drop the cached listing of a single directory, so that the next lookup
+ * lists it again. Cached listings of its subdirectories are left alone.
+ */
+static void uncacheDir(const string &dir) {
+	string prefix = dir + "/";
+	map<string, string>::iterator i = cache.lower_bound(prefix);
+	while (i != cache.end() && i->first.compare(0, prefix.length(), prefix) == 0) {
+		map<string, string>::iterator next = i; next++;
+		if (i->first.find('/', prefix.length()) == string::npos)
+			cache.erase(i);
+		i = next;
+	}
+	dircache.erase(dir);
+}
 
+std::vector<std::string> findByWildcard(std::string dir, std::string wild) {
 	wild = toLowerCase(wild);
 
 	path dirp(dir, native);
@@ -186,24 +202,35 @@ std::vector<std::string> findByWildcard(std::string dir, std::string wild) {
 		return std::vector<std::string>();
 	dir = dirp.string();
 
-	if (!doCacheDir(dirp))
-		return std::vector<std::string>();
+	// Reuse the listing from last time unless the directory changed since.
+	// Timestamps only have a resolution of a second, so a directory modified
+	// during the same second as the listing is always listed again.
+	std::time_t mtime = last_write_time(dirp);
+	map<string, std::time_t>::iterator scanned = dirscantimes.find(dir);
+	if (scanned == dirscantimes.end() || mtime >= scanned->second) {
+		uncacheDir(dir);
+		if (!doCacheDir(dirp))
+			return std::vector<std::string>();
+		dirscantimes[dir] = std::time(0);
+	}
+
 	std::vector<std::string> results;
-	boost::regex l = constructSearchPattern(wild);
+	map<string, boost::regex>::iterator pattern = searchpatterns.find(wild);
+	if (pattern == searchpatterns.end()) {
+		if (searchpatterns.size() > 256) searchpatterns.clear();
+		pattern = searchpatterns.insert(std::make_pair(wild, constructSearchPattern(wild))).first;
+	}
+	const boost::regex &l = pattern->second;
 
-	std::string lcdir = toLowerCase(dir);
-	std::map<string, string>::iterator skey = cache.lower_bound(dir);
+	string prefix = dir + "/";
+	map<string, string>::iterator skey = cache.lower_bound(prefix);
 	for (; skey != cache.end(); skey++) {
-		if (skey->first.length() < lcdir.length())
-			break;
-		std::string dirpart, filepart; // XXX: we should use boost fops, maybe
-		dirpart = skey->first.substr(0, lcdir.length());
-		if (dirpart != dir)
+		if (skey->first.compare(0, prefix.length(), prefix) != 0)
 			break;
-		if (skey->first.length() < lcdir.length() + 2)
+		std::string filepart = skey->first.substr(prefix.length());
+		if (filepart.empty() || filepart.find('/') != string::npos)
 			continue;
-		filepart = toLowerCase(skey->first.substr(lcdir.length() + 1));
-		if (!boost::regex_match(filepart, l))
+		if (!boost::regex_match(toLowerCase(filepart), l))
 			continue;
 		results.push_back(skey->second);
 	}
@@ -353,6 +353,7 @@ void PointerAgent::handleEvent(SomeEvent &event) {
 									while (!carrying->validInRoomSystem() && carrying->y - floory + carrying->getHeight() < 50) {
 										carrying->y--;
 									}
+									world.partsChanged(); // we moved it behind moveTo's back
 								}
 							}
 						} else allowdrop = false;
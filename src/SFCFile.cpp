@@ -25,6 +25,8 @@
 #include "Camera.h"
 #include "exceptions.h"
 #include "Agent.h"
+#include "mmapifstream.h"
+#include <iterator>
 
 /*
  * sfcdumper.py has better commentary on this format - use it for debugging
@@ -58,8 +60,19 @@ SFCFile::~SFCFile() {
 	}
 }
 
+void SFCFile::read(mmapifstream *i) {
+	binaryCursor c(*i);
+	read(c);
+}
+
 void SFCFile::read(std::istream *i) {
-	ourStream = i;
+	std::string data((std::istreambuf_iterator<char>(*i)), std::istreambuf_iterator<char>());
+	binaryCursor c(data);
+	read(c);
+}
+
+void SFCFile::read(binaryCursor &c) {
+	cursor = &c;
 
 	mapdata = (MapData *)slurpMFC(TYPE_MAPDATA);
 	sfccheck(mapdata);
@@ -67,7 +80,7 @@ void SFCFile::read(std::istream *i) {
 	// TODO: hackery to seek to the next bit
 	uint8 x = 0;
 	while (x == 0) x = read8();
-	ourStream->seekg(-1, std::ios::cur);
+	cursor->seek(cursor->tell() - 1);
 
 	uint32 numobjects = read32();
 	for (unsigned int i = 0; i < numobjects; i++) {
@@ -114,6 +127,8 @@ void SFCFile::read(std::istream *i) {
 		if (o) // TODO: ugh
 			macros.push_back(o);
 	}
+
+	cursor = 0;
 }
 
 bool validSFCType(unsigned int type, unsigned int reqtype) {
@@ -126,8 +141,6 @@ bool validSFCType(unsigned int type, unsigned int reqtype) {
 }
 
 SFCClass *SFCFile::slurpMFC(unsigned int reqtype) {
-	sfccheck(!ourStream->fail());
-
 	// read the pid (this only works up to 0x7ffe, but we'll cope)
 	uint16 pid = read16();
 
@@ -138,10 +151,7 @@ SFCClass *SFCFile::slurpMFC(unsigned int reqtype) {
 		// completely new class, read details
 		uint16 schemaid = read16();
 		uint16 strlen = read16();
-		char *temp = new char[strlen];
-		ourStream->read(temp, strlen);
-		std::string classname(temp, strlen);
-		delete[] temp;
+		std::string classname = readBytes(strlen);
 		
 		pid = storage.size();
 		
@@ -234,26 +244,6 @@ SFCClass *SFCFile::slurpMFC(unsigned int reqtype) {
 	return newobj;
 }
 
-uint8 SFCFile::read8() {
-	char temp[1];
-	ourStream->read(temp, 1);
-	return temp[0];
-}
-
-uint16 SFCFile::read16() {
-	char temp[2];
-	ourStream->read(temp, 2);
-	uint16 *i = (uint16 *)&temp;
-	return swapEndianShort(*i);
-}
-
-uint32 SFCFile::read32() {
-	char temp[4];
-	ourStream->read(temp, 4);
-	uint32 *i = (uint32 *)&temp;
-	return swapEndianLong(*i);
-}
-
 std::string SFCFile::readstring() {
 	uint32 strlen = read8();
 	if (strlen == 0xff) {
@@ -265,14 +255,6 @@ std::string SFCFile::readstring() {
 	return readBytes(strlen);
 }
 
-std::string SFCFile::readBytes(unsigned int n) {
-	char *temp = new char[n];
-	ourStream->read(temp, n);
-	std::string t = std::string(temp, n);
-	delete[] temp;
-	return t;
-}
-
 void SFCFile::setVersion(unsigned int v) {
 	if (v == 0) {
 		sfccheck(world.gametype == "c1");
@@ -806,7 +788,7 @@ void SFCFile::copyToWorld() {
 	// patch agents
 	// TODO: do we really need to do this, and if so, should it be done here?
 	// I like this for now because it makes debugging suck a lot less - fuzzie
-	for (std::list<boost::shared_ptr<Agent> >::iterator i = world.agents.begin(); i != world.agents.end(); i++) {
+	for (agentRegistry::iterator i = world.agents.begin(); i != world.agents.end(); i++) {
 		boost::shared_ptr<Agent> a = (*i);
 
 		#define NUM_SFC_PATCHES 5
@@ -825,13 +807,13 @@ void SFCFile::copyToWorld() {
 				// patch variable to actually refer to an agent
 				unsigned int varno = patchdata[j][4];
 				for (std::vector<SFCObject *>::iterator i = objects.begin(); i != objects.end(); i++) {
-					if ((*i)->unid == (uint32)a->var[varno].getInt()) {
+					if ((*i)->unid == (uint32)a->var.get(varno).getInt()) {
 						a->var[varno].setAgent((*i)->copiedAgent());
 						break;
 					}
 				}
 
-				if (a->var[varno].hasInt()) {
+				if (a->var.get(varno).hasInt()) {
 					a->var[varno].setAgent(0);
 					// This is useful to enable when you're testing a new patch.
 					//std::cout << "Warning: Couldn't apply agent patch #" << j << "!" << std::endl;
@@ -939,6 +921,7 @@ void MapData::copyToWorld() {
 			}
 		}
 	}
+	world.map.roomSystemChanged();
 
 	// TODO: misc data?
 }
@@ -1019,7 +1002,7 @@ void SFCCompoundObject::copyToWorld() {
 	a->timerrate = tickreset;
 	
 	for (unsigned int i = 0; i < (parent->version() == 0 ? 3 : 100); i++)
-		a->var[i].setInt(variables[i]);
+		if (variables[i]) a->var[i].setInt(variables[i]); // unset OVs already read as zero
 
 	if (parent->version() == 1) {
 		a->size.setInt(size);
@@ -1102,7 +1085,7 @@ void SFCSimpleObject::copyToWorld() {
 	a->timerrate = tickreset;
 	
 	for (unsigned int i = 0; i < (parent->version() == 0 ? 3 : 100); i++)
-		a->var[i].setInt(variables[i]);
+		if (variables[i]) a->var[i].setInt(variables[i]); // unset OVs already read as zero
 	
 	if (parent->version() == 1) {
 		a->size.setInt(size);
@@ -21,6 +21,7 @@
 #define _SFCFILE_H
 
 #include "endianlove.h"
+#include "binaryCursor.h"
 #include <map>
 #include <vector>
 #include <string>
@@ -58,7 +59,8 @@ private:
 	std::vector<SFCClass *> storage;
 	std::map<unsigned int, unsigned int> types;
 
-	std::istream *ourStream;
+	binaryCursor *cursor;
+	void read(binaryCursor &c);
 
 public:
 	MapData *mapdata;
@@ -72,16 +74,17 @@ public:
 	uint32 favplacex, favplacey;
 	std::vector<std::string> speech_history;
 
-	SFCFile() : reading_compound(false), reading_scenery(false) { }
+	SFCFile() : reading_compound(false), reading_scenery(false), cursor(0) { }
 	~SFCFile();
+	void read(class mmapifstream *i);
 	void read(std::istream *i);
 	SFCClass *slurpMFC(unsigned int reqtype = 0);
 
-	uint8 read8();
-	uint16 read16();
-	uint32 read32();
+	uint8 read8() { return cursor->read8(); }
+	uint16 read16() { return cursor->read16(); }
+	uint32 read32() { return cursor->read32(); }
 	signed int reads32() { return (signed int)read32(); }
-	std::string readBytes(unsigned int n);
+	std::string readBytes(unsigned int n) { return cursor->readBytes(n); }
 	std::string readstring();
 
 	bool readingScenery() { return reading_scenery; }
@@ -65,4 +65,13 @@ shared_ptr<script> Scriptorium::getScript(unsigned char family, unsigned char ge
 	} else return x[event];
 }
 
+void Scriptorium::getAllScripts(std::vector<shared_ptr<script> > &out) {
+	std::map<unsigned int, std::map<unsigned short, shared_ptr<script> > >::iterator x;
+	for (x = scripts.begin(); x != scripts.end(); x++) {
+		std::map<unsigned short, shared_ptr<script> >::iterator j;
+		for (j = x->second.begin(); j != x->second.end(); j++)
+			out.push_back(j->second);
+	}
+}
+
 /* vim: set noet: */
@@ -25,6 +25,7 @@
 #include <boost/shared_ptr.hpp>
 using boost::shared_ptr;
 #include <map>
+#include <vector>
 
 class script;
 
@@ -42,6 +43,7 @@ public:
 	void addScript(unsigned char family, unsigned char genus, unsigned short species, unsigned short event, shared_ptr<script> s);
 	void delScript(unsigned char family, unsigned char genus, unsigned short species, unsigned short event);
 	shared_ptr<script> getScript(unsigned char family, unsigned char genus, unsigned short species, unsigned short event);
+	void getAllScripts(std::vector<shared_ptr<script> > &out);
 };
 
 #endif
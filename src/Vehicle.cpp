@@ -62,16 +62,17 @@ void Vehicle::carry(AgentRef passenger) {
 	}
 
 	// push into our cabin
-	// TODO: should we use moveTo here?
-	if (passenger->x + passenger->getWidth() > (x + cabinright)) passenger->x = x + cabinright - passenger->getWidth();
-	if (passenger->x < (x + cabinleft)) passenger->x = x + cabinleft;
+	float newx = passenger->x, newy = passenger->y;
+	if (newx + passenger->getWidth() > (x + cabinright)) newx = x + cabinright - passenger->getWidth();
+	if (newx < (x + cabinleft)) newx = x + cabinleft;
 	if (engine.version > 1) {
 		// TODO: not sure if this is good for too-high agents, if it's possible for them to exist (see comment above)
-		if (passenger->y + passenger->getHeight() > (y + cabinbottom)) passenger->y = y + cabinbottom - passenger->getHeight();
-		if (passenger->y < (y + cabintop)) passenger->y = y + cabintop;
+		if (newy + passenger->getHeight() > (y + cabinbottom)) newy = y + cabinbottom - passenger->getHeight();
+		if (newy < (y + cabintop)) newy = y + cabintop;
 	} else {
-		passenger->y = y + cabinbottom - passenger->getHeight();
+		newy = y + cabinbottom - passenger->getHeight();
 	}
+	passenger->moveTo(newx, newy, true);
 
 	passengers.push_back(passenger);
 	passenger->invehicle = this;
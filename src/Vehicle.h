@@ -26,6 +26,7 @@
 class Vehicle : public CompoundAgent {
 protected:
 	friend class SFCVehicle;
+	friend class agentSnapshot;
 
 	unsigned int capacity;
 	unsigned int bump;
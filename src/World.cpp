@@ -24,6 +24,7 @@
 #include "PointerAgent.h"
 #include "CompoundAgent.h" // for setFocus
 #include <limits.h> // for MAXINT
+#include <string.h> // memcmp
 #include "creaturesImage.h"
 #include "creatures/CreatureAgent.h"
 #include "Backend.h"
@@ -34,9 +35,19 @@
 #include "Catalogue.h"
 #include "Camera.h"
 #include "MusicManager.h"
+#include "mapSnapshot.h"
+#include "workerPool.h"
+#include "mmapifstream.h"
+#include "binaryCursor.h"
+#include "AgentHelpers.h"
 
 #include <boost/format.hpp>
+#include <boost/bind.hpp>
 #include <boost/filesystem/convenience.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <algorithm>
+#include <math.h>
+
 namespace fs = boost::filesystem;
 
 World world;
@@ -48,10 +59,19 @@ World::World() {
 	race = 50; // sensible default?
 	pace = 0.0f; // sensible default?
 	quitting = saving = false;
+	savestarted = lastautosave = 0;
+	remotecameratime = 0;
+	partindexvalid = false;
+	partqueries = 0;
 	theHand = 0;
 	showrooms = false;
 	autokill = false;
 	autostop = false;
+	scriptbudget = scriptops = 0;
+	scriptstats.lastops = scriptstats.peakops = 0;
+	scriptstats.overbudgetticks = scriptstats.deferrals = 0;
+	physicsthreads = 0;
+	physicspool = 0;
 
 	camera = new MainCamera();
 }
@@ -59,6 +79,7 @@ World::World() {
 World::~World() {
 	agents.clear();
 	delete camera;
+	delete physicspool;
 	for (std::vector<caosVM *>::iterator i = vmpool.begin(); i != vmpool.end(); i++)
 		delete *i;
 }
@@ -128,6 +149,9 @@ void World::init() {
 	v.setInt(1); variables["engine_full_screen_toggle"] = v;
 	v.setInt(9998); variables["engine_plane_for_lines"] = v;
 	v.setInt(6); variables["engine_zlib_compression"] = v;
+	v.setInt(1); variables["engine_remote_camera_divisor"] = v; // openc2e-specific
+	v.setInt(10); variables["engine_remote_camera_budget"] = v; // openc2e-specific, in ms per frame
+	v.setInt(16384); variables["engine_sound_cache_size"] = v; // openc2e-specific, in KB of decoded audio
 
 	// creature pregnancy
 	v.setInt(1); variables["engine_multiple_birth_maximum"] = v;
@@ -145,6 +169,7 @@ void World::init() {
 }
 
 void World::shutdown() {
+	if (savewriter) finishSave();
 	agents.clear();
 	uncontrolled_sounds.clear();
 	map.Reset();
@@ -182,6 +207,47 @@ void World::queueScript(unsigned short event, AgentRef agent, AgentRef from, cao
 	scriptqueue.push_back(e);
 }
 
+// drops any events queued for the agent, which haven't run yet
+void World::unqueueScripts(Agent *a) {
+	for (std::list<scriptevent>::iterator i = scriptqueue.begin(); i != scriptqueue.end(); ) {
+		if (i->agent == a)
+			i = scriptqueue.erase(i);
+		else
+			i++;
+	}
+}
+
+/*
+ * Keep the input subscriber lists in step with an agent's IMSK flags.
+ */
+void World::setInputMask(Agent *a, unsigned int oldflags, unsigned int newflags) {
+	for (unsigned int bit = 0; bit < IMSK_BITS; bit++) {
+		bool was = oldflags & (1 << bit), is = newflags & (1 << bit);
+		if (was == is) continue;
+
+		std::vector<AgentRef> &subs = inputsubscribers[bit];
+		if (is) {
+			subs.push_back(AgentRef(a));
+		} else {
+			std::vector<AgentRef>::iterator i = std::find(subs.begin(), subs.end(), AgentRef(a));
+			if (i != subs.end())
+				subs.erase(i);
+		}
+	}
+}
+
+void World::queueInputScript(inputmaskbit bit, unsigned short event, caosVar p0, caosVar p1) {
+	std::vector<AgentRef> &subs = inputsubscribers[bit];
+	unsigned int w = 0;
+	for (unsigned int r = 0; r < subs.size(); r++) {
+		Agent *a = subs[r].get();
+		if (!a) continue; // killed since it set IMSK
+		a->queueScript(event, 0, p0, p1);
+		subs[w++] = subs[r];
+	}
+	subs.resize(w);
+}
+
 // TODO: eventually, the part should be referenced via a weak_ptr, maaaaybe?
 void World::setFocus(CompoundPart *p) {
 	assert(!p || p->canGainFocus());
@@ -205,54 +271,42 @@ void World::setFocus(CompoundPart *p) {
 }
 
 void World::tick() {
-	if (saving) {} // TODO: save
+	forgetVisibility();
+	if (savewriter && savewriter->done())
+		finishSave();
+	if (engine.autosaveinterval && engine.backend->ticks() - lastautosave >= engine.autosaveinterval * 60000) {
+		lastautosave = engine.backend->ticks();
+		// don't queue up autosaves behind a write which hasn't finished yet
+		if (!savewriter) saving = true;
+	}
+	// a save requested while the previous one is still being written waits for it
+	if (saving && !savewriter) {
+		saving = false;
+		saveWorld();
+	}
+	if (pendingload)
+		loadWorld();
 	if (quitting) {
+		if (savewriter) finishSave();
 		// due to destruction ordering we must explicitly destroy all agents here
 		agents.clear();
 		engine.done = true;
 	}
 
-	// Notify the audio backend about our current viewpoint center.
-	engine.audio->setViewpointCenter(camera->getXCentre(), camera->getYCentre());
+	musicmanager.tick();
 	
-	std::list<std::pair<boost::shared_ptr<AudioSource>, bool> >::iterator si = uncontrolled_sounds.begin();
-	while (si != uncontrolled_sounds.end()) {
-		std::list<std::pair<boost::shared_ptr<AudioSource>, bool> >::iterator next = si; next++;
-		if (si->first->getState() != SS_PLAY) {
-			// sound is stopped, so release our reference
-			uncontrolled_sounds.erase(si);
-		} else {
-			if (si->second) {
-				// follow viewport
-				si->first->setPos(camera->getXCentre(), camera->getYCentre(), 0);
-			} else {
-				// mute/unmute off-screen uncontrolled audio if necessary
-				float x, y, z;
-				si->first->getPos(x, y, z);
-				if (engine.version > 2) // TODO: this is because of wrap issues, but we need a better fix
-					si->first->setMute(camera->getMetaRoom() != world.map.metaRoomAt(x, y));
-			}
-		}
+	scriptops = 0;
 
-		si = next;
-	}
+	tickPhysics();
 
-	musicmanager.tick();
-	
 	// Tick all agents, deleting as necessary.	
-	std::list<boost::shared_ptr<Agent> >::iterator i = agents.begin();
-	while (i != agents.end()) {
-		boost::shared_ptr<Agent> a = *i;
-		if (!a) {
-			std::list<boost::shared_ptr<Agent> >::iterator i2 = i;
-			i2++;
-			agents.erase(i);
-			i = i2;
-			continue;
-		}
-		i++;
-		a->tick();
-	}
+	// Agents killed during this loop stay alive until compact(), so there's
+	// no need to hold a reference to each one while it ticks.
+	for (agentRegistry::iterator i = agents.begin(); i != agents.end(); i++)
+		(*i)->tick();
+	agents.compact();
+
+	updateAudio();
 	
 	// Process the script queue.
 	std::list<scriptevent> newqueue;
@@ -272,6 +326,12 @@ void World::tick() {
 	scriptqueue.clear();
 	scriptqueue = newqueue;
 
+	scriptstats.lastops = scriptops;
+	if (scriptops > scriptstats.peakops)
+		scriptstats.peakops = scriptops;
+	if (scriptbudget && scriptops > scriptbudget)
+		scriptstats.overbudgetticks++;
+
 	tickcount++;
 	worldtickcount++;
 
@@ -300,6 +360,53 @@ void World::tick() {
 	world.hand()->vely.setFloat(world.hand()->vely.getFloat() / 2.0f);
 }
 
+/*
+ * Moves every agent which isn't tied to another one (see
+ * Agent::preparePhysicsStep) at the start of the tick, working out where they
+ * all go on physicsthreads threads. The moves are then made, and collision
+ * scripts queued, on this thread in agent order, so the results are the same
+ * however many threads there are. Those agents skip physics in their own tick.
+ *
+ * This isn't quite what the original engines do, which move each agent from
+ * its own tick: here, every agent's scripts see all of these agents already
+ * moved, and a velocity set by a script takes effect on the next tick rather
+ * than perhaps this one. That's why it's only done when asked for.
+ */
+void World::tickPhysics() {
+	if (physicspool && physicspool->size() != physicsthreads) {
+		delete physicspool;
+		physicspool = 0;
+	}
+	if (physicsthreads < 2) return;
+
+	physicsagents.clear();
+	for (agentRegistry::iterator i = agents.begin(); i != agents.end(); i++)
+		if ((*i)->preparePhysicsStep())
+			physicsagents.push_back(i->get());
+
+	if (physicsagents.size() < physicsthreads) {
+		tickPhysicsJob(0, 1); // not worth waking the threads for
+	} else {
+		if (!physicspool)
+			physicspool = new workerPool(physicsthreads);
+		physicspool->run(boost::bind(&World::tickPhysicsJob, this, _1, _2));
+	}
+
+	for (std::vector<Agent *>::iterator i = physicsagents.begin(); i != physicsagents.end(); i++) {
+		(*i)->applyPhysics((*i)->physicsstep);
+		(*i)->physicsdone = true;
+	}
+}
+
+void World::tickPhysicsJob(unsigned int n, unsigned int of) {
+	for (unsigned int i = n; i < physicsagents.size(); i += of) {
+		physicsStep &s = physicsagents[i]->physicsstep;
+		if (s.suffercollisions)
+			physicsagents[i]->collideWithRoomSystem(s.collision);
+		integratePhysics(s);
+	}
+}
+
 Agent *World::agentAt(unsigned int x, unsigned int y, bool obey_all_transparency, bool needs_mouseable) {
 	CompoundPart *p = partAt(x, y, obey_all_transparency, needs_mouseable);
 	if (p)
@@ -308,44 +415,139 @@ Agent *World::agentAt(unsigned int x, unsigned int y, bool obey_all_transparency
 		return 0;
 }
 
-CompoundPart *World::partAt(unsigned int x, unsigned int y, bool obey_all_transparency, bool needs_mouseable, bool needs_clickable) {
-	Agent *transagent = 0;
-	if (!obey_all_transparency)
-		transagent = agentAt(x, y, true, needs_mouseable);
+static const int partindexcellsize = 128;
 
-	MetaRoom *m = world.map.metaRoomAt(x, y); // for wraparound checking
+static int partIndexCell(float v) {
+	return (int)floorf(v / partindexcellsize);
+}
+
+/*
+ * Rebuilds the grid used by partAt. Every part is added to each cell its
+ * bounding box touches, along with its position in the zorder so the
+ * candidates for a point can be checked from top to bottom.
+ *
+ * Sprite parts are added with the largest frame of their sprite, so changing
+ * pose or animating doesn't invalidate the index, but changing the sprite
+ * does; anything else which moves or resizes a part (including a creature's
+ * skeleton changing size) needs to call partsChanged().
+ */
+void World::buildPartIndex() {
+	partindex.clear();
 
-	for (std::multiset<CompoundPart *, partzorder>::iterator i = zorder.begin(); i != zorder.end(); i++) {
+	unsigned int rank = 0;
+	for (std::multiset<CompoundPart *, partzorder>::iterator i = zorder.begin(); i != zorder.end(); i++, rank++) {
 		CompoundPart *p = *i;
 		if (p->getParent() == theHand) continue;
 
-		int ax = (int)(x - p->getParent()->x);
-		int ay = (int)(y - p->getParent()->y);
-
-		// we check the wrap too..
-		if (!m || !m->wraparound() || p->x > ax + (int)m->width() || p->x + (int)p->getWidth() < ax + (int)m->width()) {
-			if (p->x > ax) continue;
-			if (p->x + (int)p->getWidth() < ax) continue;
-		} else {
-			// wrapped!
-			ax += m->width();
+		unsigned int w = p->getWidth(), h = p->getHeight();
+		SpritePart *s = dynamic_cast<SpritePart *>(p);
+		if (s) {
+			w = std::max(w, s->getSprite()->maxWidth());
+			h = std::max(h, s->getSprite()->maxHeight());
 		}
 
-		if (p->y > ay) continue;
-		if (p->y + (int)p->getHeight() < ay) continue;
+		float left = p->getParent()->x + p->x, top = p->getParent()->y + p->y;
+		int x1 = partIndexCell(left - 1), x2 = partIndexCell(left + w + 1);
+		int y1 = partIndexCell(top - 1), y2 = partIndexCell(top + h + 1);
+		for (int cy = y1; cy <= y2; cy++)
+			for (int cx = x1; cx <= x2; cx++)
+				partindex[std::pair<int, int>(cx, cy)].push_back(std::pair<unsigned int, CompoundPart *>(rank, p));
+	}
 
-		SpritePart *s = dynamic_cast<SpritePart *>(p);
-		if (s && s->isTransparent() && obey_all_transparency) {
-			// transparent parts in C1/C2 are scenery
-			// TODO: always true? you can't sekritly set parts to be transparent in C2?
-			if (engine.version < 3 || s->transparentAt(ax - s->x, ay - s->y))
-				continue;
-		}
+	partindexvalid = true;
+}
 
-		if (needs_mouseable && !(p->getParent()->mouseable()))
-			continue;
+/*
+ * Returns the parts which might be at the given point, from top to bottom.
+ */
+void World::partsNear(unsigned int x, unsigned int y, MetaRoom *m, std::vector<CompoundPart *> &parts) {
+	parts.clear();
+
+	// parts tend to move around between queries during a tick, so only bother
+	// building the index once it's been asked for the same state twice
+	if (!partindexvalid && partqueries++ == 0) {
+		parts.insert(parts.end(), zorder.begin(), zorder.end());
+		return;
+	}
+	if (!partindexvalid)
+		buildPartIndex();
+
+	std::vector<std::pair<unsigned int, CompoundPart *> > found;
+	int cy = partIndexCell(y);
+	// on wraparound metarooms, parts can also be hit one metaroom-width along
+	for (unsigned int z = 0; z < ((m && m->wraparound()) ? 2 : 1); z++) {
+		int cx = partIndexCell(z ? x + m->width() : x);
+		std::map<std::pair<int, int>, std::vector<std::pair<unsigned int, CompoundPart *> > >::iterator i = partindex.find(std::pair<int, int>(cx, cy));
+		if (i != partindex.end())
+			found.insert(found.end(), i->second.begin(), i->second.end());
+	}
+
+	if (m && m->wraparound()) {
+		std::sort(found.begin(), found.end());
+		found.erase(std::unique(found.begin(), found.end()), found.end());
+	}
+
+	for (std::vector<std::pair<unsigned int, CompoundPart *> >::iterator i = found.begin(); i != found.end(); i++)
+		parts.push_back(i->second);
+}
+
+bool World::partHit(CompoundPart *p, unsigned int x, unsigned int y, MetaRoom *m, bool obey_all_transparency, bool needs_mouseable, bool needs_clickable) {
+	if (p->getParent() == theHand) return false;
+
+	int ax = (int)(x - p->getParent()->x);
+	int ay = (int)(y - p->getParent()->y);
+
+	// we check the wrap too..
+	if (!m || !m->wraparound() || p->x > ax + (int)m->width() || p->x + (int)p->getWidth() < ax + (int)m->width()) {
+		if (p->x > ax) return false;
+		if (p->x + (int)p->getWidth() < ax) return false;
+	} else {
+		// wrapped!
+		ax += m->width();
+	}
+
+	if (p->y > ay) return false;
+	if (p->y + (int)p->getHeight() < ay) return false;
+
+	SpritePart *s = dynamic_cast<SpritePart *>(p);
+	if (s && s->isTransparent() && obey_all_transparency) {
+		// transparent parts in C1/C2 are scenery
+		// TODO: always true? you can't sekritly set parts to be transparent in C2?
+		if (engine.version < 3 || s->transparentAt(ax - s->x, ay - s->y))
+			return false;
+	}
+
+	if (needs_mouseable && !(p->getParent()->mouseable()))
+		return false;
+
+	if (needs_clickable && !(p->canClick()))
+		return false;
+
+	return true;
+}
+
+CompoundPart *World::partAt(unsigned int x, unsigned int y, bool obey_all_transparency, bool needs_mouseable, bool needs_clickable) {
+	MetaRoom *m = world.map.metaRoomAt(x, y); // for wraparound checking
 
-		if (needs_clickable && !(p->canClick()))
+	std::vector<CompoundPart *> parts;
+	partsNear(x, y, m, parts);
+
+	// if we're not obeying transparency, we only want parts of the agent which is
+	// opaque at this point
+	Agent *transagent = 0;
+	if (!obey_all_transparency) {
+		for (std::vector<CompoundPart *>::iterator i = parts.begin(); i != parts.end(); i++) {
+			if (partHit(*i, x, y, m, true, needs_mouseable, false)) {
+				transagent = (*i)->getParent();
+				break;
+			}
+		}
+		if (!transagent) return 0;
+	}
+
+	for (std::vector<CompoundPart *>::iterator i = parts.begin(); i != parts.end(); i++) {
+		CompoundPart *p = *i;
+		if (!partHit(p, x, y, m, obey_all_transparency, needs_mouseable, needs_clickable))
 			continue;
 
 		if (!obey_all_transparency)
@@ -358,32 +560,22 @@ CompoundPart *World::partAt(unsigned int x, unsigned int y, bool obey_all_transp
 	return 0;
 }
 
+/*
+ * Gives an agent a particular UNID, eg from a saved world; fails (throwing) if
+ * another agent already has it, since references to it would be ambiguous.
+ */
 void World::setUNID(Agent *whofor, int unid) {
-	assert(whofor->shared_from_this() == unidmap[unid].lock() || unidmap[unid].expired());
+	if (!agents.claim(whofor->unid, unid))
+		throw creaturesException(boost::str(boost::format("couldn't give agent %s the UNID %d, which is already in use") % whofor->identify() % unid));
 	whofor->unid = unid;
-	unidmap[unid] = whofor->shared_from_this();
-}
-
-int World::newUNID(Agent *whofor) {
-	do {
-		int unid = rand();
-		if (unid && unidmap[unid].expired()) {
-			setUNID(whofor, unid);
-			return unid;
-		}
-	} while (1);
-}
-
-void World::freeUNID(int unid) {
-	unidmap.erase(unid);
 }
 
 shared_ptr<Agent> World::lookupUNID(int unid) {
-	if (unid == 0) return shared_ptr<Agent>();
-	return unidmap[unid].lock();
+	return agents.lookup(unid);
 }
 
 void World::drawWorld() {
+	remotecameratime = 0;
 	drawWorld(camera, engine.backend->getMainSurface());
 }
 
@@ -453,9 +645,9 @@ void World::drawWorld(Camera *cam, Surface *surface) {
 
 	// render port connection lines. TODO: these should be rendered as some kind
 	// of renderable, not directly like this.
-	for (std::list<boost::shared_ptr<Agent> >::iterator i = world.agents.begin(); i != world.agents.end(); i++) {
-		boost::shared_ptr<Agent> a = *i;
-		if (!a) continue;
+	for (agentRegistry::iterator i = world.agents.begin(); i != world.agents.end(); i++) {
+		Agent *a = i->get();
+		if (a->outports.empty()) continue;
 		for (std::map<unsigned int, boost::shared_ptr<OutputPort> >::iterator p = a->outports.begin();
 		     p != a->outports.end(); p++) {
 			for (PortConnectionList::iterator c = p->second->dests.begin(); c != p->second->dests.end(); c++) {
@@ -564,8 +756,7 @@ void World::executeBootstrap(bool switcher) {
 		fs::path edenpath(data_directories[0] / "/Eden.sfc");
 		if (fs::exists(edenpath) && !fs::is_directory(edenpath)) {
 			SFCFile sfc;
-			std::ifstream f(edenpath.native_directory_string().c_str(), std::ios::binary);
-			f >> std::noskipws;
+			mmapifstream f(edenpath.native_directory_string());
 			sfc.read(&f);
 			sfc.copyToWorld();
 			return;
@@ -646,6 +837,89 @@ std::string World::getUserDataDir() {
 	return (data_directories.end() - 1)->native_directory_string();
 }
 
+std::string World::getWorldDir(const std::string &worldname) {
+	return getUserDataDir() + "/My Worlds/" + (worldname.empty() ? std::string("Default") : worldname);
+}
+
+/*
+ * Called at the start of a tick, so the snapshot is of a consistent world.
+ * Only copying the state happens here; serialising, compressing and writing it
+ * happens on a worker thread (see snapshotWriter) while the world keeps ticking.
+ */
+void World::saveWorld() {
+	// one write at a time, since each save is a delta against the last one (see tick)
+	assert(!savewriter);
+
+	try {
+		unsigned int start = engine.backend->ticks();
+		shared_ptr<mapSnapshot> s(new mapSnapshot());
+		s->copyWorld();
+		int level = variables["engine_zlib_compression"].getInt();
+		s->compression = std::max(0, std::min(level, 9));
+		savestarted = engine.backend->ticks();
+		std::cout << "copied world state for saving in " << (savestarted - start) << "ms" << std::endl;
+
+		savewriter = shared_ptr<snapshotWriter>(new snapshotWriter(s, lastsnapshot, getWorldDir()));
+	} catch (creaturesException &e) {
+		std::cerr << "failed to save world: " << e.prettyPrint() << std::endl;
+	} catch (std::exception &e) {
+		std::cerr << "failed to save world: " << e.what() << std::endl;
+	}
+}
+
+void World::finishSave() {
+	savewriter->join();
+	if (savewriter->succeeded) {
+		lastsnapshot = savewriter->getSnapshot();
+		std::cout << "saved world to " << savewriter->getDir() << " (" << savewriter->written << " of "
+			<< lastsnapshot->size() << " bytes rewritten) after " << (engine.backend->ticks() - savestarted) << "ms" << std::endl;
+	} else {
+		std::cerr << "failed to save world: " << savewriter->error << std::endl;
+	}
+	savewriter.reset();
+}
+
+/*
+ * Reads and deserialises the named world straight away, so a script asking
+ * for a missing or broken one gets an error, and nothing has been touched;
+ * the world is only replaced at the start of the next tick (see loadWorld).
+ */
+void World::requestLoad(std::string worldname) {
+	// a pending save might be writing the very files we're about to read
+	if (savewriter) finishSave();
+
+	shared_ptr<mapSnapshot> s(new mapSnapshot());
+	try {
+		s->read(getWorldDir(worldname));
+		s->stage();
+	} catch (creaturesException &e) {
+		throw;
+	} catch (std::exception &e) {
+		throw creaturesException(std::string("failed to load world '") + worldname + "': " + e.what());
+	}
+
+	pendingload = s;
+	pendingloadname = worldname;
+}
+
+void World::loadWorld() {
+	shared_ptr<mapSnapshot> s = pendingload;
+	pendingload.reset();
+	if (savewriter) finishSave();
+
+	try {
+		s->restore();
+	} catch (creaturesException &e) {
+		std::cerr << "failed to load world '" << pendingloadname << "': " << e.prettyPrint() << std::endl;
+		return;
+	} catch (std::exception &e) {
+		std::cerr << "failed to load world '" << pendingloadname << "': " << e.what() << std::endl;
+		return;
+	}
+	name = pendingloadname;
+	lastsnapshot = s;
+}
+
 void World::selectCreature(boost::shared_ptr<Agent> a) {
 	if (a) {
 		CreatureAgent *c = dynamic_cast<CreatureAgent *>(a.get());
@@ -653,7 +927,7 @@ void World::selectCreature(boost::shared_ptr<Agent> a) {
 	}
 
 	if (selectedcreature != a) {
-		for (std::list<boost::shared_ptr<Agent> >::iterator i = world.agents.begin(); i != world.agents.end(); i++) {
+		for (agentRegistry::iterator i = world.agents.begin(); i != world.agents.end(); i++) {
 			if (!*i) continue;
 			(*i)->queueScript(120, 0, caosVar(a), caosVar(selectedcreature)); // selected creature changed
 		}
@@ -667,11 +941,55 @@ shared_ptr<genomeFile> World::loadGenome(std::string &genefile) {
 	if (possibles.empty()) return shared_ptr<genomeFile>();
 	genefile = possibles[(int)((float)possibles.size() * (rand() / (RAND_MAX + 1.0)))];
 
-	shared_ptr<genomeFile> p(new genomeFile());
-	std::ifstream gfile(genefile.c_str(), std::ios::binary);
-	caos_assert(gfile.is_open());
-	gfile >> std::noskipws;
-	gfile >> *(p.get());
+	// every caller gets its own genomeFile (monikers are tracked by genomeFile),
+	// but the genes themselves are shared with the cached copy
+	return shared_ptr<genomeFile>(new genomeFile(*getParsedGenome(genefile)));
+}
+
+/*
+ * Returns the parsed contents of a genome file, which must not be modified.
+ *
+ * Files are only read again if their timestamp changes, and files with
+ * identical contents (eg, copies of the same genome exported under several
+ * monikers) are only parsed once.
+ */
+shared_ptr<genomeFile> World::getParsedGenome(std::string genefile) {
+	std::time_t mtime = fs::last_write_time(fs::path(genefile, fs::native));
+	std::map<std::string, genomeCacheEntry>::iterator i = genomefiles.find(genefile);
+	if (i != genomefiles.end() && i->second.mtime == mtime)
+		return i->second.genome;
+
+	mmapifstream gfile(genefile);
+	caos_assert(gfile.live);
+	binaryCursor data(gfile);
+
+	// look the contents up by hash (FNV-1a), then compare the bytes themselves
+	unsigned int hash = 2166136261u;
+	for (unsigned int j = 0; j < gfile.filesize; j++) {
+		hash ^= (unsigned char)gfile.map[j];
+		hash *= 16777619u;
+	}
+
+	shared_ptr<genomeFile> p;
+	typedef std::multimap<unsigned int, genomeContentsEntry>::iterator contentsiter;
+	std::pair<contentsiter, contentsiter> r = genomecontents.equal_range(hash);
+	for (contentsiter j = r.first; j != r.second; j++) {
+		if (j->second.data.size() == gfile.filesize && memcmp(j->second.data.data(), gfile.map, gfile.filesize) == 0) {
+			p = j->second.genome;
+			break;
+		}
+	}
+	if (!p) {
+		p = shared_ptr<genomeFile>(new genomeFile());
+		data >> *(p.get());
+		genomeContentsEntry &c = genomecontents.insert(std::make_pair(hash, genomeContentsEntry()))->second;
+		c.data.assign(gfile.map, gfile.filesize);
+		c.genome = p;
+	}
+
+	genomeCacheEntry &e = genomefiles[genefile];
+	e.mtime = mtime;
+	e.genome = p;
 
 	return p;
 }
@@ -709,12 +1027,64 @@ std::string World::generateMoniker(std::string basename) {
 	return x;
 }
 
+// whether a sound at this position is close enough to the camera to be worth hearing
+bool World::soundAudible(float x, float y) {
+	MetaRoom *m = map.metaRoomAt(x, y);
+	if (m && m != camera->getMetaRoom()) return false;
+
+	float dx = fabsf(x - camera->getXCentre()), dy = fabsf(y - camera->getYCentre());
+	if (m && m->wraparound() && dx > m->width() / 2)
+		dx = m->width() - dx;
+
+	// same slack as Agent::updateAudio gives agents just off-screen
+	return dx <= camera->getWidth() / 2 + 500 && dy <= camera->getHeight() / 2 + 500;
+}
+
+void World::updateAudio() {
+	// all the per-tick source changes happen in one batch, so the backend
+	// can apply them together rather than one call at a time
+	engine.audio->begin();
+
+	// Notify the audio backend about our current viewpoint center.
+	engine.audio->setViewpointCenter(camera->getXCentre(), camera->getYCentre());
+	
+	std::list<std::pair<boost::shared_ptr<AudioSource>, bool> >::iterator si = uncontrolled_sounds.begin();
+	while (si != uncontrolled_sounds.end()) {
+		std::list<std::pair<boost::shared_ptr<AudioSource>, bool> >::iterator next = si; next++;
+		if (si->first->getState() != SS_PLAY) {
+			// sound is stopped, so release our reference
+			uncontrolled_sounds.erase(si);
+		} else {
+			if (si->second) {
+				// follow viewport
+				si->first->setPos(camera->getXCentre(), camera->getYCentre(), 0);
+			} else {
+				// mute/unmute off-screen uncontrolled audio if necessary
+				float x, y, z;
+				si->first->getPos(x, y, z);
+				si->first->setMute(!soundAudible(x, y));
+			}
+		}
+
+		si = next;
+	}
+
+	// reposition (or mute) agents' controlled sounds, dropping finished ones
+	for (agentRegistry::iterator i = agents.begin(); i != agents.end(); i++) {
+		Agent *a = i->get();
+		if (!a->sound) continue;
+		if (a->sound->getState() != SS_PLAY)
+			a->sound.reset();
+		else
+			a->updateAudio(a->sound);
+	}
+
+	engine.audio->commit();
+}
+
 boost::shared_ptr<AudioSource> World::playAudio(std::string filename, AgentRef agent, bool controlled, bool loop, bool followviewport) {
 	if (filename.size() == 0) return boost::shared_ptr<AudioSource>();
 
-	boost::shared_ptr<AudioSource> sound = engine.audio->newSource();
-	if (!sound) return boost::shared_ptr<AudioSource>();
-
 	AudioClip clip = engine.audio->loadClip(filename);
 	if (!clip) {
 		// note that more specific error messages can be thrown by implementations of loadClip
@@ -722,6 +1092,9 @@ boost::shared_ptr<AudioSource> World::playAudio(std::string filename, AgentRef a
 		throw creaturesException("failed to load audio clip " + filename);
 	}
 
+	boost::shared_ptr<AudioSource> sound = engine.audio->newSource();
+	if (!sound) return boost::shared_ptr<AudioSource>();
+
 	sound->setClip(clip);
 	
 	if (loop) {
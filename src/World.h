@@ -27,9 +27,12 @@
 #include "caosVar.h"
 #include "historyManager.h"
 #include "imageManager.h"
+#include "agentRegistry.h"
+#include "gameVariables.h"
 #include <set>
 #include <map>
 #include <list>
+#include <ctime>
 #include <boost/filesystem/path.hpp>
 
 class caosVM;
@@ -46,16 +49,70 @@ struct scriptevent {
 	caosVar p[2];
 };
 
+// IMSK flags, as bit numbers
+enum inputmaskbit {
+	IMSK_KEY_DOWN = 0,
+	IMSK_KEY_UP,
+	IMSK_MOUSE_MOVE,
+	IMSK_MOUSE_DOWN,
+	IMSK_MOUSE_UP,
+	IMSK_MOUSE_WHEEL,
+	IMSK_TRANSLATED_CHAR,
+	IMSK_BITS
+};
+
+struct genomeCacheEntry {
+	std::time_t mtime;
+	boost::shared_ptr<class genomeFile> genome;
+};
+
+// a parsed genome and the file contents it was parsed from
+struct genomeContentsEntry {
+	std::string data;
+	boost::shared_ptr<class genomeFile> genome;
+};
+
 class World {
 protected:
 	class PointerAgent *theHand;
 	std::list<scriptevent> scriptqueue;
+	// the agents which set each IMSK flag, so raw input events only go to
+	// those, in the order they subscribed (not agent list order); dead agents
+	// are dropped when an event is sent
+	std::vector<AgentRef> inputsubscribers[IMSK_BITS];
 	
 	std::list<std::pair<boost::shared_ptr<class AudioSource>, bool> > uncontrolled_sounds; // audio, followingviewport
 	
-	std::map<int, boost::weak_ptr<Agent> > unidmap;
 	std::vector<caosVM *> vmpool;
 
+	// grid of part bounding boxes, so partAt only has to look at the parts near a point
+	std::map<std::pair<int, int>, std::vector<std::pair<unsigned int, CompoundPart *> > > partindex;
+	bool partindexvalid;
+	unsigned int partqueries;
+	void buildPartIndex();
+	void partsNear(unsigned int x, unsigned int y, MetaRoom *m, std::vector<CompoundPart *> &parts);
+	bool partHit(CompoundPart *p, unsigned int x, unsigned int y, MetaRoom *m, bool obey_all_transparency, bool needs_mouseable, bool needs_clickable);
+
+	// parsed genome files, by filename and by contents (see loadGenome)
+	std::map<std::string, genomeCacheEntry> genomefiles;
+	std::multimap<unsigned int, genomeContentsEntry> genomecontents; // by hash of the contents
+	boost::shared_ptr<class genomeFile> getParsedGenome(std::string filename);
+
+	boost::shared_ptr<class mapSnapshot> lastsnapshot;
+	boost::shared_ptr<class snapshotWriter> savewriter;
+	unsigned int savestarted, lastautosave;
+	boost::shared_ptr<class mapSnapshot> pendingload; // already read and staged, see requestLoad
+	std::string pendingloadname;
+	void saveWorld();
+	void finishSave();
+	void loadWorld();
+
+	// agents being moved at the start of the tick; see tickPhysics
+	class workerPool *physicspool;
+	std::vector<Agent *> physicsagents;
+	void tickPhysics();
+	void tickPhysicsJob(unsigned int n, unsigned int of);
+
 public:
 	int vmpool_size() const { return vmpool.size(); }
 	bool quitting, saving, paused;
@@ -64,10 +121,10 @@ public:
 
 	std::multiset<CompoundPart *, partzorder> zorder; // sorted from top to bottom
 	std::multiset<renderable *, renderablezorder> renders; // sorted from bottom to top
-	std::list<boost::shared_ptr<Agent> > agents;
+	agentRegistry agents; // also the UNID table
 	
 	std::map<unsigned int, std::map<unsigned int, cainfo> > carates;
-	std::map<std::string, caosVar> variables;
+	gameVariables variables;
 
 	std::vector<boost::filesystem::path> data_directories;
 	Scriptorium scriptorium;
@@ -76,14 +133,32 @@ public:
 	historyManager history;
 		
 	std::string gametype;
+	std::string name;
 	float pace;
 	unsigned int race;
 	unsigned int ticktime, tickcount;
 	unsigned int worldtickcount;
 	unsigned int timeofday, dayofseason, season, year;
 	class MainCamera *camera;
+	unsigned int remotecameratime; // ms spent drawing remote cameras this frame
 	bool showrooms, autokill, autostop;
 
+	// the most CAOS ops to spend ticking agent VMs each tick, or 0 for no
+	// limit; a VM which has started always runs until it yields, so this
+	// can be overrun, but once it's spent the remaining VMs wait a tick.
+	// INST blocks have to run to completion, so they're only bounded by
+	// the VM's 1m op limit; and install/injected scripts aren't counted
+	unsigned int scriptbudget;
+	unsigned int scriptops; // run so far this tick
+	struct {
+		unsigned int lastops, peakops; // per tick
+		unsigned int overbudgetticks, deferrals;
+	} scriptstats;
+	bool scriptBudgetLeft() const { return !scriptbudget || scriptops < scriptbudget; }
+
+	// threads used to move agents at the start of each tick, or 0 to leave it to each agent's own tick
+	unsigned int physicsthreads;
+
 	std::vector<unsigned int> groundlevels;
 
 	AgentRef selectedcreature;
@@ -93,11 +168,15 @@ public:
 
 	Agent *agentAt(unsigned int x, unsigned int y, bool obey_all_transparency = true, bool needs_mouseable = false);
 	CompoundPart *partAt(unsigned int x, unsigned int y, bool obey_all_transparency = true, bool needs_mouseable = false, bool needs_activateable = false);
+	void partsChanged() { partindexvalid = false; partqueries = 0; } // call when parts move or change size
 	class PointerAgent *hand() { return theHand; }
 	
 	caosVM *getVM(Agent *owner);
 	void freeVM(caosVM *);
 	void queueScript(unsigned short event, AgentRef agent, AgentRef from = AgentRef(), caosVar p0 = caosVar(), caosVar p1 = caosVar());
+	void unqueueScripts(Agent *a);
+	void setInputMask(Agent *a, unsigned int oldflags, unsigned int newflags);
+	void queueInputScript(inputmaskbit bit, unsigned short event, caosVar p0 = caosVar(), caosVar p1 = caosVar());
 	
 	World();
 	~World();
@@ -122,12 +201,15 @@ public:
 	int findCategory(unsigned char family, unsigned char genus, unsigned short species);
 	
 	void tick();
+	void updateAudio();
+	bool soundAudible(float x, float y);
+	void requestLoad(std::string worldname);
+	std::string getWorldDir() { return getWorldDir(name); }
+	std::string getWorldDir(const std::string &worldname);
 	void drawWorld();
 	void drawWorld(class Camera *cam, Surface *surface);
 
-	int newUNID(Agent *whofor);
 	void setUNID(Agent *whofor, int unid);
-	void freeUNID(int unid);
 
 	shared_ptr<Agent> lookupUNID(int unid);
 };
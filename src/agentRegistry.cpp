@@ -0,0 +1,174 @@
+/*
+ *  agentRegistry.cpp
+ *  openc2e
+ *
+ *  Created by the openc2e team on Mon Oct 19 2026.
+ *  Copyright (c) 2026 the openc2e team. All rights reserved.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ */
+
+
+#include "agentRegistry.h"
+#include "Agent.h"
+#include "exceptions.h"
+#include <cassert>
+
+// keep this many slots free before reusing any, so that a stale UNID has to
+// survive a lot of kills before its generation can come round again
+#define MIN_FREE_SLOTS 256
+
+unsigned int agentRegistry::allocSlot() {
+	if (freeslots.size() > MIN_FREE_SLOTS || slots.size() >= maxslots) {
+		if (freeslots.empty())
+			throw creaturesException("too many agents");
+		unsigned int index = freeslots.front();
+		freeslots.pop_front();
+		return index;
+	}
+
+	slot s;
+	s.generation = 1;
+	s.pos = 0;
+	s.foreign = 0;
+	s.used = false;
+	slots.push_back(s);
+	return slots.size() - 1;
+}
+
+void agentRegistry::releaseSlot(unsigned int index) {
+	slot &s = slots[index];
+	assert(s.used);
+	s.used = false;
+	if (s.foreign) {
+		foreignids.erase(s.foreign);
+		s.foreign = 0;
+	}
+	s.generation = (s.generation + 1) & generationmask;
+	if (s.generation == 0) s.generation = 1;
+	freeslots.push_back(index);
+}
+
+const agentRegistry::slot *agentRegistry::findSlot(int id) const {
+	if (id <= 0) return 0;
+
+	if (!foreignids.empty()) {
+		std::map<int, unsigned int>::const_iterator f = foreignids.find(id);
+		if (f != foreignids.end()) return &slots[f->second];
+	}
+
+	unsigned int index = indexOf(id);
+	if (index >= slots.size()) return 0;
+	const slot &s = slots[index];
+	if (!s.used || s.foreign || s.generation != generationOf(id)) return 0;
+	return &s;
+}
+
+int agentRegistry::add(boost::shared_ptr<Agent> a) {
+	assert(a);
+	unsigned int index = allocSlot();
+	slot &s = slots[index];
+	// don't hand out a UNID which was claimed by another agent
+	while (foreignids.find(makeID(index, s.generation)) != foreignids.end()) {
+		s.generation = (s.generation + 1) & generationmask;
+		if (s.generation == 0) s.generation = 1;
+	}
+	s.used = true;
+	s.pos = agents.size();
+	assert(a->handle == agentHandles::nohandle);
+	a->handle = agentHandles::alloc(a.get());
+	agents.push_back(a);
+	agentslots.push_back(index);
+	live++;
+	return makeID(index, s.generation);
+}
+
+void agentRegistry::remove(int id) {
+	const slot *s = findSlot(id);
+	assert(s);
+	if (!s) return;
+
+	unsigned int pos = s->pos;
+	agentHandles::release(agents[pos]->handle);
+	agents[pos]->handle = agentHandles::nohandle;
+	graveyard.push_back(agents[pos]);
+	agents[pos].reset();
+	live--; holes++;
+	releaseSlot(agentslots[pos]);
+}
+
+boost::shared_ptr<Agent> agentRegistry::lookup(int id) const {
+	const slot *s = findSlot(id);
+	if (!s) return boost::shared_ptr<Agent>();
+	return agents[s->pos];
+}
+
+bool agentRegistry::claim(int id, int wanted) {
+	if (wanted == id) return true;
+	if (wanted <= 0) return false;
+	const slot *current = findSlot(id);
+	if (!current) return false;
+	if (findSlot(wanted)) return false; // someone else has it
+
+	unsigned int index = agentslots[current->pos];
+	slot &s = slots[index];
+	if (s.foreign)
+		foreignids.erase(s.foreign);
+	s.foreign = wanted;
+	foreignids[wanted] = index;
+	return true;
+}
+
+void agentRegistry::compact() {
+	if (!graveyard.empty()) {
+		// destructors might look at the registry, so get out of the way first
+		std::vector<boost::shared_ptr<Agent> > dead;
+		dead.swap(graveyard);
+	}
+
+	// holes only cost a skip during iteration, so don't shuffle for a handful
+	if (holes == 0 || holes * 8 < agents.size()) return;
+
+	unsigned int w = 0;
+	for (unsigned int r = 0; r < agents.size(); r++) {
+		if (!agents[r]) continue;
+		if (w != r) {
+			agents[w].swap(agents[r]);
+			agentslots[w] = agentslots[r];
+			slots[agentslots[w]].pos = w;
+		}
+		w++;
+	}
+	agents.resize(w);
+	agentslots.resize(w);
+	holes = 0;
+}
+
+void agentRegistry::clear() {
+	std::vector<boost::shared_ptr<Agent> > old, olddead;
+	for (std::vector<boost::shared_ptr<Agent> >::iterator i = agents.begin(); i != agents.end(); i++) {
+		if (!*i) continue;
+		agentHandles::release((*i)->handle);
+		(*i)->handle = agentHandles::nohandle;
+	}
+	old.swap(agents);
+	olddead.swap(graveyard);
+	agentslots.clear();
+	slots.clear();
+	freeslots.clear();
+	foreignids.clear();
+	live = holes = 0;
+	// old and olddead (and so the agents) are destroyed here, after the
+	// registry is already empty
+}
+
+/* vim: set noet: */
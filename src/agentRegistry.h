@@ -0,0 +1,137 @@
+/*
+ *  agentRegistry.h
+ *  openc2e
+ *
+ *  Created by the openc2e team on Mon Oct 19 2026.
+ *  Copyright (c) 2026 the openc2e team. All rights reserved.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ */
+
+
+#ifndef _AGENTREGISTRY_H
+#define _AGENTREGISTRY_H
+
+#include <boost/shared_ptr.hpp>
+#include <deque>
+#include <map>
+#include <vector>
+
+class Agent;
+
+/*
+ * The world's list of live agents, and the UNID table.
+ *
+ * Agents are kept in a contiguous vector in creation order; iteration runs
+ * from the newest agent to the oldest (as the old push_front list did) and
+ * skips agents which have been killed. Killed agents leave a hole and are
+ * kept alive until the next compact(), so that it's always safe to hold a
+ * raw Agent * for the duration of a tick.
+ *
+ * Each agent also owns a slot in a slot map. Its UNID encodes the slot index
+ * and the slot's generation, so lookups are a bounds check and a compare,
+ * and a stale UNID for a reused slot fails the generation check rather than
+ * finding the wrong agent.
+ *
+ * UNIDs from outside (eg, a C1 SFC file) can be anything, so claim() keeps
+ * those in a separate table rather than in the slot map; new native UNIDs
+ * skip any which are in use.
+ */
+class agentRegistry {
+public:
+	enum {
+		indexbits = 20,
+		maxslots = 1 << indexbits,
+		generationmask = 0x7ff // 20 + 11 bits, so UNIDs are always positive
+	};
+
+	class iterator {
+		friend class agentRegistry;
+
+	protected:
+		agentRegistry *r;
+		int pos; // index into r->agents, -1 is end()
+
+		iterator(agentRegistry *reg, int p) : r(reg), pos(p) { }
+
+	public:
+		iterator() : r(0), pos(-1) { }
+
+		boost::shared_ptr<Agent> &operator*() const { return r->agents[pos]; }
+		boost::shared_ptr<Agent> *operator->() const { return &r->agents[pos]; }
+
+		iterator &operator++() {
+			do { pos--; } while (pos >= 0 && !r->agents[pos]);
+			return *this;
+		}
+		iterator &operator--() {
+			do { pos++; } while (pos < (int)r->agents.size() && !r->agents[pos]);
+			return *this;
+		}
+		iterator operator++(int) { iterator i = *this; ++*this; return i; }
+		iterator operator--(int) { iterator i = *this; --*this; return i; }
+
+		bool operator==(const iterator &o) const { return pos == o.pos; }
+		bool operator!=(const iterator &o) const { return pos != o.pos; }
+	};
+
+protected:
+	struct slot {
+		unsigned int generation;
+		unsigned int pos; // index into agents while in use
+		int foreign; // claimed UNID, if any, which replaces the native one
+		bool used;
+	};
+
+	std::vector<boost::shared_ptr<Agent> > agents;
+	std::vector<unsigned int> agentslots; // parallel to agents
+	std::vector<boost::shared_ptr<Agent> > graveyard;
+	std::vector<slot> slots;
+	std::deque<unsigned int> freeslots;
+	std::map<int, unsigned int> foreignids; // claimed UNID -> slot index
+	unsigned int live, holes;
+
+	static int makeID(unsigned int index, unsigned int generation) { return (int)((generation << indexbits) | index); }
+	static unsigned int indexOf(int id) { return (unsigned int)id & (maxslots - 1); }
+	static unsigned int generationOf(int id) { return ((unsigned int)id >> indexbits) & generationmask; }
+
+	unsigned int allocSlot();
+	void releaseSlot(unsigned int index);
+	const slot *findSlot(int id) const;
+
+public:
+	agentRegistry() : live(0), holes(0) { }
+
+	iterator begin() { iterator i(this, agents.size()); return ++i; }
+	iterator end() { return iterator(this, -1); }
+	unsigned int size() const { return live; }
+	bool empty() const { return live == 0; }
+
+	// takes ownership, returns the new agent's UNID
+	int add(boost::shared_ptr<Agent> a);
+	// forget the agent, which stays alive until the next compact()
+	void remove(int id);
+	boost::shared_ptr<Agent> lookup(int id) const;
+	// try to move the agent with UNID 'id' to the UNID 'wanted' (eg, from a
+	// saved world); returns false, changing nothing, if another agent has it
+	bool claim(int id, int wanted);
+
+	// close up holes and release killed agents; invalidates iterators
+	void compact();
+	void clear();
+
+	unsigned int slotCount() const { return slots.size(); }
+	unsigned int holeCount() const { return holes; }
+};
+
+#endif
+/* vim: set noet: */
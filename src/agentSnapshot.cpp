@@ -0,0 +1,438 @@
+/*
+ *  agentSnapshot.cpp
+ *  openc2e
+ *
+ *  Created by the openc2e team on Mon Oct 19 2026.
+ *  Copyright (c) 2026 the openc2e team. All rights reserved.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ */
+
+#include "agentSnapshot.h"
+#include "World.h"
+#include "SimpleAgent.h"
+#include "CompoundAgent.h"
+#include "Vehicle.h"
+#include "CameraPart.h"
+#include "PointerAgent.h"
+#include "creaturesImage.h"
+#include "historyManager.h"
+#include "creatures/genome.h"
+#include <typeinfo>
+#include <iostream>
+
+bool agentSnapshot::covers(Agent *a) {
+	const std::type_info &t = typeid(*a);
+	return t == typeid(SimpleAgent) || t == typeid(CompoundAgent) || t == typeid(Vehicle);
+}
+
+static int unidOf(const AgentRef &r) {
+	Agent *a = r.get();
+	return a ? a->getUNID() : -1;
+}
+
+static void saveValue(savedValue &v, const caosVar &c) {
+	v.value = c;
+	v.isagent = c.hasAgent();
+	v.unid = -1;
+	if (v.isagent) {
+		v.unid = unidOf(c.getAgent());
+		v.value.setAgent(AgentRef());
+	}
+}
+
+void agentSnapshot::savePart(savedPart &p, CompoundPart *part) {
+	SpritePart *sp = dynamic_cast<SpritePart *>(part);
+	assert(sp);
+
+	p.id = part->id;
+	p.x = part->x; p.y = part->y;
+	p.zorder = part->zorder;
+	p.has_alpha = part->has_alpha; p.alpha = part->alpha;
+
+	p.sprite = sp->origsprite->getName();
+	p.firstimg = sp->getFirstImg();
+	p.base = sp->getBase();
+	p.pose = sp->getPose();
+	p.frameno = sp->getFrameNo();
+	p.framerate = sp->framerate;
+	p.is_transparent = sp->is_transparent;
+	p.animation = sp->animation;
+
+	if (CameraPart *c = dynamic_cast<CameraPart *>(part)) {
+		p.kind = camerapart;
+		p.viewwidth = c->viewwidth; p.viewheight = c->viewheight;
+		p.camerawidth = c->camerawidth; p.cameraheight = c->cameraheight;
+		p.refreshdivisor = c->refreshdivisor;
+	} else if (TextPart *t = dynamic_cast<TextPart *>(part)) {
+		if (TextEntryPart *e = dynamic_cast<TextEntryPart *>(part)) {
+			p.kind = textentrypart;
+			p.messageid = e->messageid;
+		} else
+			p.kind = fixedtextpart;
+		// keep the <tint> tags, unless the text has been typed into since
+		p.text = t->rawtextvalid ? t->rawtext : t->text;
+		p.fontsprite = t->textsprite->getName();
+		p.leftmargin = t->leftmargin; p.topmargin = t->topmargin;
+		p.rightmargin = t->rightmargin; p.bottommargin = t->bottommargin;
+		p.linespacing = t->linespacing; p.charspacing = t->charspacing;
+		p.horz_align = t->horz_align; p.vert_align = t->vert_align;
+		p.last_page_scroll = t->last_page_scroll;
+		p.page = t->currpage;
+	} else if (ButtonPart *b = dynamic_cast<ButtonPart *>(part)) {
+		p.kind = buttonpart;
+		p.hoveranimation = b->hoveranimation;
+		p.messageid = b->messageid;
+		p.hitopaquepixelsonly = b->hitopaquepixelsonly;
+	} else if (dynamic_cast<GraphPart *>(part)) {
+		p.kind = graphpart;
+	} else {
+		p.kind = dullpart;
+	}
+}
+
+void agentSnapshot::saveAgent(savedAgent &s, Agent *a, std::vector<savedGenome> &genomes, std::map<genomeFile *, int> &genomeindex) {
+	s.unid = a->getUNID();
+	s.family = a->family; s.genus = a->genus; s.species = a->species;
+	s.zorder = a->zorder;
+	s.x = a->x; s.y = a->y;
+
+	s.attr = a->attr;
+	s.bhvr = (a->cr_can_push ? 1 : 0) | (a->cr_can_pull ? 2 : 0) | (a->cr_can_stop ? 4 : 0) |
+		(a->cr_can_hit ? 8 : 0) | (a->cr_can_eat ? 16 : 0) | (a->cr_can_pickup ? 32 : 0);
+	s.imsk = a->getInputMask();
+	s.paused = a->paused; s.visible = a->visible; s.displaycore = a->displaycore; s.falling = a->falling;
+	for (unsigned int i = 0; i < 3; i++) s.clac[i] = a->clac[i];
+	s.clik = a->clik;
+	s.tickssincelasttimer = a->tickssincelasttimer; s.timerrate = a->timerrate;
+
+	s.velx = a->velx; s.vely = a->vely; s.accg = a->accg; s.aero = a->aero; s.rest = a->rest; s.range = a->range;
+	s.friction = a->friction; s.perm = a->perm; s.elas = a->elas;
+	s.has_custom_core_size = a->has_custom_core_size;
+	s.custom_core_xleft = a->custom_core_xleft; s.custom_core_xright = a->custom_core_xright;
+	s.custom_core_ytop = a->custom_core_ytop; s.custom_core_ybottom = a->custom_core_ybottom;
+	saveValue(s.objp, a->objp);
+	s.babymoniker = a->babymoniker; s.actv = a->actv; s.thrt = a->thrt; s.size = a->size;
+
+	// only the OVs which have been set, to keep them lazily allocated on load
+	for (unsigned int i = 0; i < agentVariables::count; i++) {
+		const caosVar &v = a->var.get(i);
+		if (v.hasInt() && v.getInt() == 0) continue;
+		s.vars.push_back(std::pair<unsigned int, savedValue>(i, savedValue()));
+		saveValue(s.vars.back().second, v);
+	}
+	for (lazyMap<caosVar, caosVar, caosVarCompare>::iterator i = a->name_variables.begin(); i != a->name_variables.end(); i++) {
+		s.namevars.push_back(std::pair<savedValue, savedValue>());
+		saveValue(s.namevars.back().first, i->first);
+		saveValue(s.namevars.back().second, i->second);
+	}
+
+	// genomes are shared between the agents holding them, as in the world
+	for (lazyMap<unsigned int, boost::shared_ptr<genomeFile> >::iterator i = a->genome_slots.begin(); i != a->genome_slots.end(); i++) {
+		if (!i->second) continue;
+		std::map<genomeFile *, int>::iterator g = genomeindex.find(i->second.get());
+		if (g == genomeindex.end()) {
+			savedGenome sg;
+			sg.moniker = world.history.findMoniker(i->second);
+			// our own copy for the writer thread; the genes themselves are shared, and never change
+			sg.genome = boost::shared_ptr<genomeFile>(new genomeFile(*i->second));
+			genomes.push_back(sg);
+			g = genomeindex.insert(std::pair<genomeFile *, int>(i->second.get(), genomes.size() - 1)).first;
+		}
+		s.genomes.push_back(std::pair<unsigned int, int>(i->first, g->second));
+	}
+
+	s.carrying = unidOf(a->carrying);
+	s.carriedby = unidOf(a->carriedby);
+	s.invehicle = unidOf(a->invehicle);
+	s.floatingagent = unidOf(a->floatingagent);
+
+	s.kind = simpleagent;
+	s.parts.push_back(savedPart());
+	savePart(s.parts.back(), a->part(0));
+
+	CompoundAgent *c = dynamic_cast<CompoundAgent *>(a);
+	if (!c) return;
+	s.kind = compoundagent;
+	for (std::vector<CompoundPart *>::iterator i = c->parts.begin(); i != c->parts.end(); i++) {
+		if ((*i)->id == 0) continue;
+		s.parts.push_back(savedPart());
+		savePart(s.parts.back(), *i);
+	}
+	for (unsigned int i = 0; i < 6; i++) {
+		s.hotspots[i][0] = c->hotspots[i].left; s.hotspots[i][1] = c->hotspots[i].top;
+		s.hotspots[i][2] = c->hotspots[i].right; s.hotspots[i][3] = c->hotspots[i].bottom;
+		s.hotspotfunctions[i] = c->hotspotfunctions[i].hotspot;
+		s.hotspotmessages[i] = c->hotspotfunctions[i].message;
+		s.hotspotmasks[i] = c->hotspotfunctions[i].mask;
+	}
+
+	Vehicle *v = dynamic_cast<Vehicle *>(a);
+	if (!v) return;
+	s.kind = vehicleagent;
+	s.capacity = v->capacity; s.bump = v->bump;
+	s.xvec = v->xvec; s.yvec = v->yvec;
+	s.cabinleft = v->cabinleft; s.cabintop = v->cabintop; s.cabinright = v->cabinright; s.cabinbottom = v->cabinbottom;
+	s.cabinplane = v->cabinplane;
+	for (std::vector<AgentRef>::iterator i = v->passengers.begin(); i != v->passengers.end(); i++)
+		s.passengers.push_back(unidOf(*i));
+}
+
+/*
+ * Copies every agent the snapshot covers, oldest first (so a restore hands
+ * out new UNIDs in the same order). Must be called on the main thread.
+ */
+void agentSnapshot::capture() {
+	agents.clear();
+	genomes.clear();
+	unsigned int skipped = 0;
+
+	std::vector<Agent *> all;
+	for (agentRegistry::iterator i = world.agents.begin(); i != world.agents.end(); i++)
+		all.push_back(i->get());
+
+	std::map<genomeFile *, int> genomeindex;
+	for (std::vector<Agent *>::reverse_iterator i = all.rbegin(); i != all.rend(); i++) {
+		Agent *a = *i;
+		if (!covers(a)) {
+			if (a != world.hand()) skipped++;
+			continue;
+		}
+		agents.push_back(savedAgent());
+		saveAgent(agents.back(), a, genomes, genomeindex);
+	}
+
+	if (skipped)
+		std::cout << "warning: " << skipped << " agent(s) can't be saved yet (creatures and other special agents), and were left out" << std::endl;
+}
+
+CompoundPart *agentSnapshot::buildPart(CompoundAgent *a, const savedPart &p) {
+	switch (p.kind) {
+		case buttonpart:
+			return new ButtonPart(a, p.id, p.sprite, p.firstimg, p.x, p.y, p.zorder, p.hoveranimation, p.messageid, p.hitopaquepixelsonly ? 1 : 0);
+		case fixedtextpart:
+			return new FixedTextPart(a, p.id, p.sprite, p.firstimg, p.x, p.y, p.zorder, p.fontsprite);
+		case textentrypart:
+			return new TextEntryPart(a, p.id, p.sprite, p.firstimg, p.x, p.y, p.zorder, p.messageid, p.fontsprite);
+		case graphpart:
+			return new GraphPart(a, p.id, p.sprite, p.firstimg, p.x, p.y, p.zorder, 0);
+		case camerapart:
+			return new CameraPart(a, p.id, p.sprite, p.firstimg, p.x, p.y, p.zorder, p.viewwidth, p.viewheight, p.camerawidth, p.cameraheight);
+		default:
+			return new DullPart(a, p.id, p.sprite, p.firstimg, p.x, p.y, p.zorder);
+	}
+}
+
+void agentSnapshot::restorePart(CompoundPart *part, const savedPart &p) {
+	part->has_alpha = p.has_alpha;
+	part->alpha = p.alpha;
+
+	SpritePart *sp = dynamic_cast<SpritePart *>(part);
+	assert(sp);
+	sp->is_transparent = p.is_transparent;
+	sp->setFramerate(p.framerate);
+	sp->setBase(p.base);
+	sp->setPose(p.pose);
+	sp->animation = p.animation;
+	if (!p.animation.empty() && p.frameno < p.animation.size())
+		sp->setFrameNo(p.frameno);
+
+	if (TextPart *t = dynamic_cast<TextPart *>(part)) {
+		t->setFormat(p.leftmargin, p.topmargin, p.rightmargin, p.bottommargin, p.linespacing, p.charspacing,
+			(horizontalalign)p.horz_align, (verticalalign)p.vert_align, p.last_page_scroll);
+		t->setText(p.text);
+		if (p.page < t->noPages()) t->setPage(p.page);
+	}
+
+	if (CameraPart *c = dynamic_cast<CameraPart *>(part))
+		c->setRefreshDivisor(p.refreshdivisor);
+}
+
+Agent *agentSnapshot::buildAgent(const savedAgent &s) {
+	if (s.parts.empty())
+		throw creaturesException("saved agent has no parts");
+	const savedPart &p0 = s.parts[0];
+
+	if (s.kind == simpleagent)
+		return new SimpleAgent(s.family, s.genus, s.species, s.zorder, p0.sprite, p0.firstimg, 0);
+
+	CompoundAgent *c;
+	if (s.kind == vehicleagent)
+		c = new Vehicle(s.family, s.genus, s.species, s.zorder, p0.sprite, p0.firstimg, 0);
+	else
+		c = new CompoundAgent(s.family, s.genus, s.species, s.zorder, p0.sprite, p0.firstimg, 0);
+	try {
+		for (unsigned int i = 1; i < s.parts.size(); i++)
+			c->addPart(buildPart(c, s.parts[i]));
+	} catch (...) {
+		delete c;
+		throw;
+	}
+	return c;
+}
+
+/*
+ * Constructs the saved agents (which is what needs the sprites, and so can
+ * fail), without adding them to the world yet. Throws, leaving the world
+ * alone, if any of them can't be built.
+ */
+void agentSnapshot::build() {
+	discard();
+	try {
+		for (std::vector<savedAgent>::iterator i = agents.begin(); i != agents.end(); i++)
+			built.push_back(buildAgent(*i));
+	} catch (...) {
+		discard();
+		throw;
+	}
+}
+
+void agentSnapshot::discard() {
+	for (std::vector<Agent *>::iterator i = built.begin(); i != built.end(); i++)
+		delete *i; // null once restore() has handed it to the world
+	built.clear();
+}
+
+/*
+ * Replaces the agents the snapshot covers with the ones built by build(),
+ * then puts the links between agents (and from game variables) back.
+ */
+void agentSnapshot::restore() {
+	if (built.size() != agents.size())
+		build();
+
+	unsigned int kept = 0;
+	for (agentRegistry::iterator i = world.agents.begin(); i != world.agents.end(); i++) {
+		boost::shared_ptr<Agent> a = *i;
+		if (covers(a.get()))
+			a->kill();
+		else if (a.get() != world.hand())
+			kept++;
+	}
+	if (kept)
+		std::cout << "warning: kept " << kept << " agent(s) which can't be saved yet (creatures and other special agents)" << std::endl;
+
+	// saved UNID -> restored agent; anything else is looked up among the agents we kept
+	std::map<int, Agent *> restored;
+	for (unsigned int n = 0; n < agents.size(); n++) {
+		const savedAgent &s = agents[n];
+		Agent *a = built[n];
+
+		a->finishInit();
+		built[n] = 0; // owned by the world now
+		world.unqueueScripts(a); // the constructor ran when the agent was first made
+		boost::shared_ptr<Agent> holder = world.lookupUNID(s.unid);
+		if (!holder)
+			world.setUNID(a, s.unid);
+		else if (holder.get() != a)
+			std::cout << "warning: restored agent " << a->identify() << " lost its UNID " << s.unid << " to an agent which wasn't saved" << std::endl;
+		restored[s.unid] = a;
+
+		a->attr = s.attr;
+		a->cr_can_push = s.bhvr & 1; a->cr_can_pull = s.bhvr & 2; a->cr_can_stop = s.bhvr & 4;
+		a->cr_can_hit = s.bhvr & 8; a->cr_can_eat = s.bhvr & 16; a->cr_can_pickup = s.bhvr & 32;
+		a->setInputMask(s.imsk); // so the world's input subscriber lists know
+		a->paused = s.paused; a->visible = s.visible; a->displaycore = s.displaycore; a->falling = s.falling;
+		for (unsigned int i = 0; i < 3; i++) a->clac[i] = s.clac[i];
+		a->clik = s.clik;
+		a->tickssincelasttimer = s.tickssincelasttimer; a->timerrate = s.timerrate;
+
+		a->velx = s.velx; a->vely = s.vely; a->accg = s.accg; a->aero = s.aero; a->rest = s.rest; a->range = s.range;
+		a->friction = s.friction; a->perm = s.perm; a->elas = s.elas;
+		a->has_custom_core_size = s.has_custom_core_size;
+		a->custom_core_xleft = s.custom_core_xleft; a->custom_core_xright = s.custom_core_xright;
+		a->custom_core_ytop = s.custom_core_ytop; a->custom_core_ybottom = s.custom_core_ybottom;
+		a->babymoniker = s.babymoniker; a->actv = s.actv; a->thrt = s.thrt; a->size = s.size;
+
+		for (unsigned int i = 0; i < s.genomes.size(); i++)
+			a->genome_slots[s.genomes[i].first] = genomes[s.genomes[i].second].genome;
+
+		restorePart(a->part(0), s.parts[0]);
+		CompoundAgent *c = dynamic_cast<CompoundAgent *>(a);
+		if (c) {
+			for (unsigned int i = 1; i < s.parts.size(); i++)
+				restorePart(c->part(s.parts[i].id), s.parts[i]);
+			for (unsigned int i = 0; i < 6; i++) {
+				c->setHotspotLoc(i, s.hotspots[i][0], s.hotspots[i][1], s.hotspots[i][2], s.hotspots[i][3]);
+				c->hotspotfunctions[i].hotspot = s.hotspotfunctions[i];
+				c->setHotspotFuncDetails(i, s.hotspotmessages[i], s.hotspotmasks[i]);
+			}
+		}
+		if (Vehicle *v = dynamic_cast<Vehicle *>(a)) {
+			v->capacity = s.capacity; v->bump = s.bump;
+			v->xvec = s.xvec; v->yvec = s.yvec;
+			v->setCabinRect(s.cabinleft, s.cabintop, s.cabinright, s.cabinbottom);
+			v->cabinplane = s.cabinplane;
+		}
+
+		a->moveTo(s.x, s.y, true);
+	}
+	built.clear();
+
+	// second pass, now every agent exists
+	for (unsigned int n = 0; n < agents.size(); n++) {
+		const savedAgent &s = agents[n];
+		Agent *a = restored[s.unid];
+
+		for (unsigned int i = 0; i < s.vars.size(); i++)
+			a->var[s.vars[i].first] = resolve(s.vars[i].second, restored);
+		for (unsigned int i = 0; i < s.namevars.size(); i++)
+			a->name_variables[resolve(s.namevars[i].first, restored)] = resolve(s.namevars[i].second, restored);
+
+		a->objp = resolve(s.objp, restored);
+		a->carrying = resolve(s.carrying, restored);
+		a->carriedby = resolve(s.carriedby, restored);
+		a->invehicle = resolve(s.invehicle, restored);
+		// agents we kept (the hand, say) don't know they were carrying this one
+		if (a->carriedby && !a->carriedby->carrying)
+			a->carriedby->carrying = a;
+
+		a->floatingagent = resolve(s.floatingagent, restored);
+		if (a->floatable()) a->floatSetup();
+
+		if (Vehicle *v = dynamic_cast<Vehicle *>(a)) {
+			for (unsigned int i = 0; i < s.passengers.size(); i++) {
+				AgentRef p = resolve(s.passengers[i], restored);
+				if (p) v->passengers.push_back(p);
+			}
+		}
+	}
+
+	for (std::map<std::string, int>::iterator i = variablelinks.begin(); i != variablelinks.end(); i++)
+		world.variables[i->first].setAgent(resolve(i->second, restored));
+
+	// the moniker history is kept across a load, so only needs to know where the genomes are now
+	for (unsigned int i = 0; i < genomes.size(); i++) {
+		if (genomes[i].moniker.empty()) continue;
+		Agent *holder = 0;
+		for (unsigned int n = 0; n < agents.size() && !holder; n++)
+			for (unsigned int j = 0; j < agents[n].genomes.size(); j++)
+				if (agents[n].genomes[j].second == (int)i) { holder = restored[agents[n].unid]; break; }
+		world.history.restoreMoniker(genomes[i].moniker, genomes[i].genome, holder);
+	}
+}
+
+AgentRef agentSnapshot::resolve(int unid, std::map<int, Agent *> &restored) {
+	if (unid == -1) return AgentRef();
+	std::map<int, Agent *>::iterator i = restored.find(unid);
+	if (i != restored.end()) return AgentRef(i->second);
+	return AgentRef(world.lookupUNID(unid));
+}
+
+caosVar agentSnapshot::resolve(const savedValue &v, std::map<int, Agent *> &restored) {
+	caosVar c = v.value;
+	if (v.isagent)
+		c.setAgent(resolve(v.unid, restored));
+	return c;
+}
+
+/* vim: set noet: */
@@ -0,0 +1,184 @@
+/*
+ *  agentSnapshot.h
+ *  openc2e
+ *
+ *  Created by the openc2e team on Mon Oct 19 2026.
+ *  Copyright (c) 2026 the openc2e team. All rights reserved.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ */
+
+#ifndef _AGENTSNAPSHOT_H
+#define _AGENTSNAPSHOT_H
+
+#include "caosVar.h"
+#include "openc2e.h"
+#include <map>
+#include <string>
+#include <vector>
+
+class Agent;
+class CompoundAgent;
+class CompoundPart;
+class genomeFile;
+
+/*
+ * A caosVar with any agent in it replaced by the agent's UNID, so it can be
+ * saved and then pointed at the right agent again after a load.
+ */
+struct savedValue {
+	caosVar value; // with the agent (if any) dropped
+	bool isagent;
+	int unid; // -1 for a null agent
+
+	savedValue() { isagent = false; unid = -1; }
+};
+
+enum savedPartKind { dullpart, buttonpart, fixedtextpart, textentrypart, graphpart, camerapart };
+
+struct savedPart {
+	int kind; // savedPartKind
+	unsigned int id;
+	int x, y;
+	unsigned int zorder; // relative to the agent
+	std::string sprite;
+	unsigned int firstimg, base, pose, frameno;
+	unsigned char framerate;
+	bool is_transparent;
+	bool has_alpha;
+	unsigned char alpha;
+	bytestring_t animation;
+
+	// buttons
+	bytestring_t hoveranimation;
+	int messageid;
+	bool hitopaquepixelsonly;
+
+	// text
+	std::string text, fontsprite;
+	int leftmargin, topmargin, rightmargin, bottommargin, linespacing, charspacing;
+	int horz_align, vert_align;
+	bool last_page_scroll;
+	unsigned int page;
+
+	// cameras
+	unsigned int viewwidth, viewheight, camerawidth, cameraheight, refreshdivisor;
+
+	savedPart() {
+		kind = dullpart; id = 0; x = y = 0; zorder = 0;
+		firstimg = base = pose = frameno = 0; framerate = 1;
+		is_transparent = false; has_alpha = false; alpha = 0;
+		messageid = 0; hitopaquepixelsonly = false;
+		leftmargin = topmargin = rightmargin = bottommargin = 8; linespacing = charspacing = 0;
+		horz_align = vert_align = 0; last_page_scroll = false; page = 0;
+		viewwidth = viewheight = camerawidth = cameraheight = 0; refreshdivisor = 1;
+	}
+};
+
+enum savedAgentKind { simpleagent, compoundagent, vehicleagent };
+
+struct savedAgent {
+	int kind; // savedAgentKind
+	int unid;
+	unsigned char family, genus;
+	unsigned short species;
+	unsigned int zorder;
+	float x, y;
+
+	unsigned int attr, bhvr, imsk;
+	bool paused, visible, displaycore, falling;
+	int clac[3], clik;
+	unsigned int tickssincelasttimer, timerrate;
+
+	caosVar velx, vely, accg, aero, rest, range;
+	unsigned int friction;
+	int perm, elas;
+	bool has_custom_core_size;
+	float custom_core_xleft, custom_core_xright, custom_core_ytop, custom_core_ybottom;
+	savedValue objp;
+	caosVar babymoniker, actv, thrt, size;
+
+	std::vector<std::pair<unsigned int, savedValue> > vars; // the OVxx which are set
+	std::vector<std::pair<savedValue, savedValue> > namevars;
+	std::vector<std::pair<unsigned int, int> > genomes; // slot, index into agentSnapshot::genomes
+
+	int carrying, carriedby, invehicle, floatingagent; // UNIDs, or -1
+
+	std::vector<savedPart> parts; // part 0 first
+
+	// C1/C2 compound agents
+	int hotspots[6][4];
+	int hotspotfunctions[6], hotspotmessages[6], hotspotmasks[6];
+
+	// vehicles
+	unsigned int capacity, bump;
+	caosVar xvec, yvec;
+	int cabinleft, cabintop, cabinright, cabinbottom, cabinplane;
+	std::vector<int> passengers;
+};
+
+struct savedGenome {
+	std::string moniker;
+	boost::shared_ptr<genomeFile> genome;
+};
+
+/*
+ * Plain copies of the world's agents, with the links between them (and from
+ * game variables) kept as UNIDs, and the genomes they hold. Taken on the
+ * main thread by capture(), after which nothing in here refers back to the
+ * world, so it can be serialised on another thread while the world carries
+ * on: the records are copies, each genomeFile is a copy of the agent's, and
+ * what they still share with the world (strings in caosVars, and genes) is
+ * never modified once created.
+ *
+ * Only plain simple and compound agents and vehicles are covered so far.
+ * Everything else (creatures, the hand, and the C1/C2 lifts, call buttons,
+ * blackboards and bubbles) is left out, and restore() leaves those in the
+ * world as they are; links to them are kept by UNID, and still work if the
+ * agent is around after the load. Running scripts aren't saved either, so
+ * restored agents start out idle, as after an SFC import.
+ */
+class agentSnapshot {
+protected:
+	std::vector<Agent *> built; // by build(), not in the world yet
+
+	// not copyable, since it owns the built agents
+	agentSnapshot(const agentSnapshot &);
+	agentSnapshot &operator=(const agentSnapshot &);
+
+	static void savePart(savedPart &p, CompoundPart *part);
+	static void saveAgent(savedAgent &s, Agent *a, std::vector<savedGenome> &genomes, std::map<genomeFile *, int> &genomeindex);
+	static CompoundPart *buildPart(CompoundAgent *a, const savedPart &p);
+	static void restorePart(CompoundPart *part, const savedPart &p);
+	static Agent *buildAgent(const savedAgent &s);
+
+	AgentRef resolve(int unid, std::map<int, Agent *> &restored);
+	caosVar resolve(const savedValue &v, std::map<int, Agent *> &restored);
+
+public:
+	std::vector<savedAgent> agents; // oldest first
+	std::vector<savedGenome> genomes;
+	std::map<std::string, int> variablelinks; // game variables holding agents, to their UNIDs
+
+	agentSnapshot() { }
+	~agentSnapshot() { discard(); }
+
+	void capture();
+	void build();
+	void discard();
+	void restore();
+
+	static bool covers(Agent *a);
+};
+
+#endif
+/* vim: set noet: */
@@ -0,0 +1,98 @@
+/*
+ *  agentVariables.h
+ *  openc2e
+ *
+ *  Created by the openc2e team on Mon Oct 19 2026.
+ *  Copyright (c) 2026 the openc2e team. All rights reserved.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ */
+
+
+#ifndef _AGENTVARIABLES_H
+#define _AGENTVARIABLES_H
+
+#include "caosVar.h"
+#include <cassert>
+
+/*
+ * Storage for an agent's OVxx variables.
+ *
+ * The hundred variables are split into chunks of ten which are only
+ * allocated when a variable in them is written (or taken by non-const
+ * reference), so an agent which never touches its OVs costs one pointer,
+ * and the common case of OV00-OV09 costs a single chunk. Unallocated
+ * variables read as integer zero, exactly like a fresh caosVar.
+ *
+ * Chunks are never freed or moved while the agent is alive, so references
+ * returned by operator[] stay valid.
+ */
+class agentVariables {
+public:
+	enum { count = 100, chunksize = 10, chunks = count / chunksize };
+
+protected:
+	caosVar **table;
+
+	static const caosVar &zero() { static const caosVar z; return z; }
+
+	// not copyable
+	agentVariables(const agentVariables &);
+	agentVariables &operator=(const agentVariables &);
+
+public:
+	agentVariables() : table(0) { }
+	~agentVariables() {
+		if (!table) return;
+		for (unsigned int i = 0; i < chunks; i++)
+			delete[] table[i];
+		delete[] table;
+	}
+
+	caosVar &operator[](unsigned int i) {
+		assert(i < count);
+		if (!table) {
+			table = new caosVar *[chunks];
+			for (unsigned int j = 0; j < chunks; j++)
+				table[j] = 0;
+		}
+		caosVar *&c = table[i / chunksize];
+		if (!c) c = new caosVar[chunksize];
+		return c[i % chunksize];
+	}
+
+	// read without allocating
+	const caosVar &get(unsigned int i) const {
+		assert(i < count);
+		if (!table) return zero();
+		const caosVar *c = table[i / chunksize];
+		if (!c) return zero();
+		return c[i % chunksize];
+	}
+	const caosVar &operator[](unsigned int i) const { return get(i); }
+
+	unsigned int allocatedChunks() const {
+		if (!table) return 0;
+		unsigned int n = 0;
+		for (unsigned int i = 0; i < chunks; i++)
+			if (table[i]) n++;
+		return n;
+	}
+
+	unsigned int heapBytes() const {
+		if (!table) return 0;
+		return chunks * sizeof(caosVar *) + allocatedChunks() * chunksize * sizeof(caosVar);
+	}
+};
+
+#endif
+/* vim: set noet: */
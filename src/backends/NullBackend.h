@@ -28,6 +28,7 @@ public:
 	virtual void renderLine(int x1, int y1, int x2, int y2, unsigned int colour) { }
 	virtual void renderText(int x, int y, std::string text, unsigned int colour, unsigned int bgcolour) { }
 	virtual void blitSurface(Surface *src, int x, int y, int w, int h)  { }
+	virtual void renderSurface(Surface *src, int x, int y, bool trans = false, unsigned char transparency = 0) { }
 	virtual unsigned int getWidth() const { return 800; }
 	virtual unsigned int getHeight() const { return 600; }
 	virtual void renderDone() { }
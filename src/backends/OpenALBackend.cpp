@@ -20,6 +20,7 @@
 #include "OpenALBackend.h"
 #include <alut.h>
 #include <iostream>
+#include <sstream>
 #include <boost/format.hpp>
 #include <boost/thread.hpp>
 #include <boost/foreach.hpp>
@@ -36,6 +37,9 @@
 // seconds
 #define BUFFER_LEN 0.25
 
+// most implementations manage at least this many; if not, we find out from alGenSources
+#define MAX_SOURCES 64
+
 #ifndef NDEBUG
 #define CHECK_BACKEND_LIFE do { this->backend(); } while(0)
 #else
@@ -100,6 +104,12 @@ void OpenALBackend::init() {
 	}
 	alcMakeContextCurrent(context);
 
+	allocatedSources = 0;
+	maxSources = MAX_SOURCES;
+	stolenSources = 0;
+	playcounter = 0;
+	clipCacheBytes = clipHits = clipMisses = 0;
+
 	setMute(false);
 
 	static const ALfloat init_ori[6] = {
@@ -137,12 +147,23 @@ void OpenALBackend::shutdown() {
 
 	bgmSource.reset();
 
+	// drop our references first, so that unused clips are freed normally
+	clipCache.clear();
+	clipLRU.clear();
+	clipCacheBytes = 0;
+
 	OpenALSource::SourceList sl = activeSources;
 	std::for_each(sl.begin(), sl.end(), boost::lambda::bind(&OpenALSource::forceCleanup, *boost::lambda::_1));
 
 	// beware, forceCleanup will release most(/all?) buffers
 	OpenALBuffer::BufferList bl = activeBuffers;
 	std::for_each(bl.begin(), bl.end(), boost::lambda::bind(&OpenALBuffer::destroy, *boost::lambda::_1));
+
+	// all the sources have been returned to the pool by forceCleanup
+	if (!freeSources.empty())
+		alDeleteSources(freeSources.size(), &freeSources[0]);
+	freeSources.clear();
+	allocatedSources = 0;
 	
 	alcMakeContextCurrent(NULL);
 	alcDestroyContext(context);
@@ -165,10 +186,10 @@ void OpenALSource::setFollowingView(bool f) {
 		return; // nothing to do
 	if (f) {
 		setPos(0, 0, 0);
-		alSourcei(source, AL_SOURCE_RELATIVE, 1);
+		if (source) alSourcei(source, AL_SOURCE_RELATIVE, 1);
 	} else {
 		setPos(bp->ListenerPos[0], bp->ListenerPos[1], bp->ListenerPos[2]);
-		alSourcei(source, AL_SOURCE_RELATIVE, 0);
+		if (source) alSourcei(source, AL_SOURCE_RELATIVE, 0);
 	}
 	followview = f;
 }
@@ -177,10 +198,82 @@ boost::shared_ptr<AudioSource> OpenALBackend::newSource() {
 	return boost::shared_ptr<AudioSource>(new OpenALSource(shared_from_this()));
 }
 
+ALuint OpenALBackend::acquireSource(int priority) {
+	if (!freeSources.empty()) {
+		ALuint s = freeSources.back();
+		freeSources.pop_back();
+		return s;
+	}
+
+	if (allocatedSources < maxSources) {
+		ALuint s = 0;
+		alGetError();
+		alGenSources(1, &s);
+		if (alGetError() == AL_NO_ERROR) {
+			allocatedSources++;
+			return s;
+		}
+		// the implementation has run out, so don't bother asking again
+		maxSources = allocatedSources;
+	}
+
+	// steal from the least important source which has one, oldest first;
+	// finished sounds go first, and streams (music) are never interrupted
+	OpenALSource *victim = NULL;
+	int victimpriority = 0;
+	for (OpenALSource::SourceList::iterator i = activeSources.begin(); i != activeSources.end(); i++) {
+		OpenALSource *s = *i;
+		if (!s->source) continue;
+		int p = s->priority();
+		ALint state;
+		alGetSourcei(s->source, AL_SOURCE_STATE, &state);
+		if (state == AL_STOPPED || state == AL_INITIAL) p = 0;
+		if (p > priority || p >= 3) continue;
+		if (!victim || p < victimpriority || (p == victimpriority && s->playstarted < victim->playstarted)) {
+			victim = s;
+			victimpriority = p;
+		}
+	}
+	if (!victim) return 0;
+
+	stolenSources++;
+	victim->unbindSource(); // returns its source to the pool
+	ALuint s = freeSources.back();
+	freeSources.pop_back();
+	return s;
+}
+
+void OpenALBackend::trimClipCache() {
+	unsigned int budget = 16384; // KB
+	static unsigned int budgetslot = world.variables.slot("engine_sound_cache_size");
+	const caosVar *v = world.variables.find(budgetslot);
+	if (v && v->hasInt() && v->getInt() >= 0)
+		budget = v->getInt();
+	budget *= 1024;
+
+	// never evict the clip we just loaded; clips which are still playing stay
+	// alive through their sources, we just stop sharing them
+	while (clipCacheBytes > budget && clipLRU.size() > 1) {
+		std::map<std::string, cachedClip>::iterator i = clipCache.find(clipLRU.front());
+		assert(i != clipCache.end());
+		clipCacheBytes -= i->second.bytes;
+		clipCache.erase(i);
+		clipLRU.pop_front();
+	}
+}
+
 AudioClip OpenALBackend::loadClip(const std::string &filename) {
 	std::string fname = world.findFile(std::string("/Sounds/") + filename + ".wav");
 	if (fname.size() == 0) return AudioClip();
 
+	std::map<std::string, cachedClip>::iterator i = clipCache.find(fname);
+	if (i != clipCache.end()) {
+		clipHits++;
+		clipLRU.splice(clipLRU.end(), clipLRU, i->second.lru);
+		return AudioClip(i->second.clip.get());
+	}
+	clipMisses++;
+
 	alGetError();
 	ALuint buf = alutCreateBufferFromFile(fname.c_str());
 	if (!buf) {
@@ -190,8 +283,27 @@ AudioClip OpenALBackend::loadClip(const std::string &filename) {
 					));
 	}
 
-	AudioClip clip(new OpenALBuffer(shared_from_this(), buf));
-	return clip;
+	OpenALClip clip(new OpenALBuffer(shared_from_this(), buf));
+
+	ALint size = 0;
+	alGetBufferi(buf, AL_SIZE, &size);
+	cachedClip &c = clipCache[fname];
+	c.clip = clip;
+	c.bytes = size;
+	c.lru = clipLRU.insert(clipLRU.end(), fname);
+	clipCacheBytes += size;
+	trimClipCache();
+
+	return AudioClip(clip.get());
+}
+
+std::string OpenALBackend::getStatistics() {
+	std::ostringstream oss;
+	oss << "sources: " << allocatedSources << " allocated (of at most " << maxSources << "), " << freeSources.size() << " free" << std::endl;
+	oss << "sources stolen from quieter sounds: " << stolenSources << std::endl;
+	oss << "clip cache: " << clipCache.size() << " clips, " << clipCacheBytes / 1024 << " KB" << std::endl;
+	oss << "clip cache hits: " << clipHits << ", misses: " << clipMisses << std::endl;
+	return oss.str();
 }
 
 void OpenALBackend::begin() {
@@ -203,15 +315,57 @@ void OpenALBackend::commit() {
 }
 
 void OpenALSource::forceCleanup() {
+	if (cleanedup)
+		return;
 	boost::shared_ptr<OpenALBackend> bp = backend_weak.lock();
 	if (!bp)
 		return;
+	stop(); // gives our AL source back to the pool
 	bp->activeSources.erase(slit);
-	stop();
-	alDeleteSources(1, &source);
 	bp.reset();
 	clip = NULL;
 	stream.reset();
+	cleanedup = true;
+}
+
+bool OpenALSource::bindSource() {
+	if (source) return true;
+
+	source = backend()->acquireSource(priority());
+	if (!source) return false;
+
+	// the pooled source could have been anything before, so set everything
+	alSourcef(source, AL_PITCH, 1.0f);
+	alSourcef(source, AL_GAIN, getEffectiveVolume());
+	alSourcei(source, AL_SOURCE_RELATIVE, followview ? 1 : 0);
+	alSource3f(source, AL_POSITION, x * scale, y * scale, z * plnemul);
+	alSourcefv(source, AL_VELOCITY, null_vec);
+	alSourcei(source, AL_LOOPING, looping ? AL_TRUE : AL_FALSE);
+	if (clip)
+		alSourcei(source, AL_BUFFER, clip->buffer);
+	return true;
+}
+
+void OpenALSource::unbindSource() {
+	if (!source) return;
+
+	alSourceStop(source);
+	alSourcei(source, AL_BUFFER, 0); // remove all queued buffers
+
+	if (stream) {
+		streambuffers.clear();
+		unusedbuffers.clear();
+		backend()->stopPolling(this);
+	}
+
+	backend()->releaseSource(source);
+	source = 0;
+}
+
+int OpenALSource::priority() const {
+	if (stream) return 3; // music
+	if (looping) return 2;
+	return 1;
 }
 
 boost::shared_ptr<class OpenALBackend> OpenALSource::backend() const {
@@ -224,15 +378,10 @@ boost::shared_ptr<class OpenALBackend> OpenALSource::backend() const {
 OpenALSource::OpenALSource(boost::shared_ptr<class OpenALBackend> backend) {
 	assert(backend);
 	this->backend_weak = backend;
-	alGetError();
-	alGenSources(1, &source);
-	alSourcef(source, AL_PITCH, 1.0f);
-	alSourcef(source, AL_GAIN, 1.0f);
-	alSourcefv(source, AL_POSITION, null_vec);
+	source = 0; // we only take one from the pool when we start playing
+	playstarted = 0;
+	cleanedup = false;
 	x = y = z = 0;
-	alSourcefv(source, AL_VELOCITY, null_vec);
-	alSourcei(source, AL_LOOPING, 0);
-	al_throw_maybe();
 	slit = backend->activeSources.insert(backend->activeSources.end(), this);
 }
 
@@ -295,7 +444,6 @@ void OpenALSource::setClip(const AudioClip &clip_) {
 	stop();
 	this->stream = AudioStream();
 	this->clip = OpenALClip(obp);
-	alSourcei(source, AL_BUFFER, clip->buffer);
 }
 
 AudioStream OpenALSource::getStream() const {
@@ -314,6 +462,7 @@ void OpenALSource::setStream(const AudioStream &stream) {
 SourceState OpenALSource::getState() const {
 	int state;
 	CHECK_BACKEND_LIFE; // make sure we're alive
+	if (!source) return SS_STOP;
 	alGetSourcei(source, AL_SOURCE_STATE, &state);
 	switch (state) {
 		case AL_INITIAL: case AL_STOPPED: return SS_STOP;
@@ -331,19 +480,21 @@ SourceState OpenALSource::getState() const {
 void OpenALSource::play() {
 	assert( (!!clip) != (!!stream) ); // clip OR stream, not both, not neither
 	CHECK_BACKEND_LIFE; // make sure we're alive
+	if (!bindSource()) return; // everything is busy playing something more important
+	playstarted = backend()->playcounter++;
 	if (stream) {
 		streambuffers.clear();
 		unusedbuffers.clear();
 		buf_est_ms = 0;
 		drain = false;
 		backend()->startPolling(this);
-		bufferdata();
+		if (!bufferdata()) return; // stream was empty, and we've stopped already
 	}
 	alSourcePlay(source);
 }
 
 bool OpenALSource::poll() {
-	if (!stream)
+	if (!stream || !source)
 		return false;
 	return bufferdata();
 }
@@ -438,19 +589,12 @@ bool OpenALSource::bufferdata() {
 
 void OpenALSource::stop() {
 	CHECK_BACKEND_LIFE;
-	alSourceStop(source);
-	alSourcei(source, AL_BUFFER, NULL); // remove all queued buffers
-
-	if (stream) {
-		streambuffers.clear();
-		unusedbuffers.clear();
-		backend()->stopPolling(this);
-	}
+	unbindSource();
 }
 
 void OpenALSource::pause() {
 	CHECK_BACKEND_LIFE;
-	alSourcePause(source);
+	if (source) alSourcePause(source);
 }
 
 static void fadeSource(boost::weak_ptr<AudioSource> s) {
@@ -480,7 +624,7 @@ void OpenALSource::realSetPos(float x, float y, float plane) {
 	CHECK_BACKEND_LIFE;
 	if (this->x == x && this->y == y && this->z == plane) return;
 	this->SkeletonAudioSource::setPos(x, y, plane);
-	alSource3f(source, AL_POSITION, x * scale, y * scale, plane * plnemul);
+	if (source) alSource3f(source, AL_POSITION, x * scale, y * scale, plane * plnemul);
 }
 
 void OpenALSource::setPos(float x, float y, float plane) {
@@ -494,33 +638,32 @@ void OpenALSource::setVelocity(float x, float y) {
 	CHECK_BACKEND_LIFE;
 	// experiment with this later
 	x = y = 0;
-	alSource3f(source, AL_VELOCITY, x * scale, y * scale, 0);
+	if (source) alSource3f(source, AL_VELOCITY, x * scale, y * scale, 0);
 }
 
 bool OpenALSource::isLooping() const {
-	int l;
 	CHECK_BACKEND_LIFE;
-	alGetSourcei(source, AL_LOOPING, &l);
-	return l == AL_TRUE;
+	return looping;
 }
 
 void OpenALSource::setLooping(bool l) {
 	CHECK_BACKEND_LIFE;
-	alSourcei(source, AL_LOOPING, l ? AL_TRUE : AL_FALSE);
+	looping = l;
+	if (source) alSourcei(source, AL_LOOPING, l ? AL_TRUE : AL_FALSE);
 }
 
 void OpenALSource::setVolume(float v) {
 	CHECK_BACKEND_LIFE;
 	if (v == this->volume) return;
 	this->SkeletonAudioSource::setVolume(v);
-	alSourcef(source, AL_GAIN, getEffectiveVolume());
+	if (source) alSourcef(source, AL_GAIN, getEffectiveVolume());
 }
 
 void OpenALSource::setMute(bool m) {
 	CHECK_BACKEND_LIFE;
 	if (m == muted) return;
 	this->SkeletonAudioSource::setMute(m);
-	alSourcef(source, AL_GAIN, getEffectiveVolume());
+	if (source) alSourcef(source, AL_GAIN, getEffectiveVolume());
 }
 
 void OpenALBackend::poll() {
@@ -99,7 +99,13 @@ protected:
 
 	OpenALClip clip;
 	AudioStream stream;
-	ALuint source;
+	ALuint source; // borrowed from the backend's pool while playing, otherwise 0
+	unsigned int playstarted;
+	bool cleanedup;
+
+	bool bindSource();
+	void unbindSource();
+	int priority() const;
 
 	bool poll();
 	bool bufferdata();
@@ -112,7 +118,7 @@ protected:
 
 	void forceCleanup();
 public:
-	~OpenALSource() { forceCleanup(); stop(); alDeleteSources(1, &source); }
+	~OpenALSource() { forceCleanup(); }
 
 	virtual AudioClip getClip() const;
 	virtual void setClip(const AudioClip &); /* Valid only in STOP state */
@@ -150,6 +156,25 @@ protected:
 	OpenALSource::SourceList activeSources;
 	OpenALBuffer::BufferList activeBuffers;
 
+	// AL sources are only held by OpenALSources while they're playing, and
+	// are recycled through this pool rather than being generated every time
+	std::vector<ALuint> freeSources;
+	unsigned int allocatedSources, maxSources, stolenSources;
+	unsigned int playcounter;
+	ALuint acquireSource(int priority);
+	void releaseSource(ALuint s) { freeSources.push_back(s); }
+
+	// decoded clips by resolved filename, so agents playing the same sound share a buffer
+	struct cachedClip {
+		OpenALClip clip;
+		unsigned int bytes;
+		std::list<std::string>::iterator lru;
+	};
+	std::map<std::string, cachedClip> clipCache;
+	std::list<std::string> clipLRU; // least recently used first
+	unsigned int clipCacheBytes, clipHits, clipMisses;
+	void trimClipCache();
+
 	ALCdevice *device;
 	ALCcontext *context;
 
@@ -181,6 +206,8 @@ public:
 	void begin();
 	void commit();
 	void poll();
+
+	std::string getStatistics();
 };
 
 #endif
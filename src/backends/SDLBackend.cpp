@@ -23,11 +23,18 @@
 #include "openc2e.h"
 #include "Engine.h"
 #include "creaturesImage.h"
+#include <boost/bind.hpp>
+#include <stdlib.h> // strtoul
 
 SDLBackend *g_backend;
 
+const unsigned int maxnetconnections = 16;
+
 SDLBackend::SDLBackend() : mainsurface(this) {
 	networkingup = false;
+	listensocket = 0;
+	socketset = 0;
+	sender = 0;
 	basicfont = 0;
 
 	// reasonable defaults
@@ -97,18 +104,38 @@ int SDLBackend::networkInit() {
 	if (!listensocket)
 		throw creaturesException(std::string("Failed to open a port to listen on."));
 
+	socketset = SDLNet_AllocSocketSet(maxnetconnections);
+	if (!socketset)
+		throw creaturesException(std::string("SDL_net error allocating socket set: ") + SDLNet_GetError());
+
+	sender = new SDLNetSender();
+
 	return listenport;
 }
 
 void SDLBackend::shutdown() {
+	flushTextCache();
 	if (TTF_WasInit()) {
 		if (basicfont) {
 			TTF_CloseFont(basicfont);
 		}
 		TTF_Quit();
 	}
-	if (networkingup && listensocket)
-		SDLNet_TCP_Close(listensocket);
+	if (networkingup) {
+		// don't hang on exit for a client which isn't reading its reply, but
+		// make sure the sender is finished with the sockets before closing them
+		if (sender)
+			sender->stop();
+		for (std::list<SDLNetConnection>::iterator i = connections.begin(); i != connections.end(); i++)
+			closeConnection(*i);
+		connections.clear();
+		delete sender;
+		sender = 0;
+		if (socketset)
+			SDLNet_FreeSocketSet(socketset);
+		if (listensocket)
+			SDLNet_TCP_Close(listensocket);
+	}
 	SDLNet_Quit();
 	SDL_Quit();
 }
@@ -118,9 +145,12 @@ void SDLBackend::handleEvents() {
 		handleNetworking();
 }
 
-void SDLBackend::handleNetworking() {
+void SDLBackend::acceptConnections() {
 	// handle incoming network connections
-	while (TCPsocket connection = SDLNet_TCP_Accept(listensocket)) {
+	while (connections.size() < maxnetconnections) {
+		TCPsocket connection = SDLNet_TCP_Accept(listensocket);
+		if (!connection) break;
+
 		// check this connection is coming from localhost
 		IPaddress *remote_ip = SDLNet_TCP_GetPeerAddress(connection);
 		unsigned char *rip = (unsigned char *)&remote_ip->host;
@@ -129,26 +159,230 @@ void SDLBackend::handleNetworking() {
 			SDLNet_TCP_Close(connection);
 			continue;
 		}
-			
-		// read the data from the socket
-		std::string data;
-		bool done = false;
-		while (!done) {
-			char buffer;
-			int i = SDLNet_TCP_Recv(connection, &buffer, 1);
-			if (i == 1) {
-				data = data + buffer;
-				// TODO: maybe we should check for rscr\n like c2e seems to
-				if ((data.size() > 3) && (data.find("rscr\n", data.size() - 5) != data.npos)) done = true;
-			} else done = true;
+
+		SDLNetConnection c;
+		c.socket = connection;
+		c.session = false;
+		c.closed = false;
+		connections.push_back(c);
+		SDLNet_TCP_AddSocket(socketset, connection);
+	}
+}
+
+// how much we send to one client before giving the others a turn
+const std::string::size_type netsendchunk = 16384;
+
+SDLNetSender::SDLNetSender() {
+	sending = 0;
+	stopping = false;
+	thread = new boost::thread(boost::bind(&SDLNetSender::run, this));
+}
+
+SDLNetSender::~SDLNetSender() {
+	stop();
+}
+
+std::list<SDLNetSender::outbox>::iterator SDLNetSender::find(TCPsocket s) {
+	std::list<outbox>::iterator i = queue.begin();
+	while (i != queue.end() && i->socket != s) i++;
+	return i;
+}
+
+void SDLNetSender::run() {
+	boost::mutex::scoped_lock l(lock);
+	while (true) {
+		while (queue.empty() && !stopping)
+			wake.wait(l);
+		if (stopping) return;
+
+		// take a chunk from the client at the front, and send it its turn to the back
+		outbox &o = queue.front();
+		TCPsocket s = o.socket;
+		std::string data = o.data.substr(0, netsendchunk);
+		o.data.erase(0, data.size());
+		if (o.data.empty())
+			queue.pop_front();
+		else
+			queue.splice(queue.end(), queue, queue.begin());
+
+		sending = s;
+		l.unlock();
+		int sent = SDLNet_TCP_Send(s, (void *)data.c_str(), data.size());
+		l.lock();
+		sending = 0;
+		if (sent < (int)data.size()) {
+			failedsockets.insert(s);
+			std::list<outbox>::iterator i = find(s);
+			if (i != queue.end()) queue.erase(i);
+		}
+		wake.notify_all(); // for stop() and forget()
+	}
+}
+
+void SDLNetSender::send(TCPsocket s, const std::string &data) {
+	boost::mutex::scoped_lock l(lock);
+	if (stopping || failedsockets.count(s)) return;
+	std::list<outbox>::iterator i = find(s);
+	if (i == queue.end()) {
+		outbox o;
+		o.socket = s;
+		i = queue.insert(queue.end(), o);
+	}
+	i->data += data;
+	wake.notify_all();
+}
+
+bool SDLNetSender::idle(TCPsocket s) {
+	boost::mutex::scoped_lock l(lock);
+	return sending != s && find(s) == queue.end();
+}
+
+bool SDLNetSender::failed(TCPsocket s) {
+	boost::mutex::scoped_lock l(lock);
+	return failedsockets.count(s) != 0;
+}
+
+void SDLNetSender::forget(TCPsocket s) {
+	boost::mutex::scoped_lock l(lock);
+	std::list<outbox>::iterator i = find(s);
+	if (i != queue.end()) queue.erase(i);
+	failedsockets.erase(s);
+	// the socket is about to be closed, so it mustn't be in use
+	while (sending == s)
+		wake.wait(l);
+}
+
+void SDLNetSender::stop() {
+	if (!thread) return;
+	{
+		boost::mutex::scoped_lock l(lock);
+		stopping = true;
+		queue.clear();
+		wake.notify_all();
+	}
+	thread->join(); // only waits for the chunk being sent, if any
+	delete thread;
+	thread = 0;
+}
+
+/*
+ * Works out whether a session's buffer starts with a whole request, which is
+ * its length in bytes on a line of its own followed by the CAOS itself.
+ */
+static bool sessionRequestReady(const std::string &buffer, std::string::size_type &start, std::string::size_type &len, bool &malformed) {
+	malformed = false;
+	std::string::size_type eol = buffer.find('\n');
+	if (eol == std::string::npos) {
+		malformed = (buffer.size() > 10); // no length needs that many digits
+		return false;
+	}
+
+	char *end;
+	len = strtoul(buffer.c_str(), &end, 10);
+	if (eol == 0 || end != buffer.c_str() + eol) {
+		malformed = true;
+		return false;
+	}
+
+	start = eol + 1;
+	return buffer.size() - start >= len;
+}
+
+/*
+ * Runs the first complete request buffered on the connection, if any, and
+ * queues the reply. Returns false if there was nothing to do.
+ */
+bool SDLBackend::handleNetworkRequest(SDLNetConnection &c) {
+	if (!c.session && c.buffer.compare(0, 5, "sesn\n") == 0) {
+		c.session = true;
+		c.buffer.erase(0, 5);
+	}
+
+	std::string data;
+	if (c.session) {
+		std::string::size_type start, len;
+		bool malformed;
+		if (!sessionRequestReady(c.buffer, start, len, malformed)) {
+			if (malformed) {
+				std::cout << "Dropping network session which sent a bad request length" << std::endl;
+				c.buffer.clear();
+				c.closed = true;
+			}
+			return false;
+		}
+		data = c.buffer.substr(start, len);
+		c.buffer.erase(0, start + len);
+	} else if (c.buffer.size() >= 5 && c.buffer.compare(c.buffer.size() - 5, 5, "rscr\n") == 0) {
+		// only a trailing rscr ends the request; one earlier on starts a removal script
+		data.swap(c.buffer);
+	} else if (c.closed && !c.buffer.empty()) {
+		// the client gave up on sending rscr, so run what we've got
+		data.swap(c.buffer);
+	} else {
+		return false;
+	}
+
+	// pass the data onto the engine, and queue our response
+	std::string tosend = engine.executeNetwork(data);
+	if (c.session)
+		tosend = boost::str(boost::format("%d\n") % tosend.size()) + tosend;
+	sender->send(c.socket, tosend);
+
+	// non-session connections get closed after one request
+	if (!c.session)
+		c.closed = true;
+
+	return true;
+}
+
+void SDLBackend::closeConnection(SDLNetConnection &c) {
+	sender->forget(c.socket);
+	SDLNet_TCP_DelSocket(socketset, c.socket);
+	SDLNet_TCP_Close(c.socket);
+}
+
+void SDLBackend::handleNetworking() {
+	acceptConnections();
+	if (connections.empty()) return;
+
+	// read whatever's arrived, without blocking
+	if (SDLNet_CheckSockets(socketset, 0) > 0) {
+		for (std::list<SDLNetConnection>::iterator i = connections.begin(); i != connections.end(); i++) {
+			if (i->closed || !SDLNet_SocketReady(i->socket)) continue;
+
+			char buffer[4096];
+			int len = SDLNet_TCP_Recv(i->socket, buffer, sizeof(buffer));
+			if (len <= 0)
+				i->closed = true;
+			else
+				i->buffer.append(buffer, len);
+		}
+	}
+
+	// run requests; by default only one per connection per tick, so that polling
+	// tools can't steal too much tick time, but --netbatch runs everything pending
+	for (std::list<SDLNetConnection>::iterator i = connections.begin(); i != connections.end(); i++) {
+		if (sender->failed(i->socket)) {
+			// nobody's listening for the replies any more
+			i->closed = true;
+			i->buffer.clear();
+			continue;
+		}
+		while (handleNetworkRequest(*i)) {
+			if (!engine.networkbatch) break;
 		}
+	}
 
-		// pass the data onto the engine, and send back our response
-		std::string tosend = engine.executeNetwork(data);
-		SDLNet_TCP_Send(connection, (void *)tosend.c_str(), tosend.size());
-		
-		// and finally, close the connection
-		SDLNet_TCP_Close(connection);
+	// and finally, close finished connections once their replies are out
+	std::list<SDLNetConnection>::iterator i = connections.begin();
+	while (i != connections.end()) {
+		std::string::size_type start, len;
+		bool malformed;
+		bool pending = i->session && sessionRequestReady(i->buffer, start, len, malformed);
+		if (i->closed && !pending && sender->idle(i->socket)) {
+			closeConnection(*i);
+			i = connections.erase(i);
+		} else i++;
 	}
 }
 
@@ -266,12 +500,12 @@ void SDLSurface::renderText(int x, int y, std::string text, unsigned int colour,
 	SDL_Surface *textsurf;
 
 	if (bgcolour == 0) { // transparent
-		textsurf = TTF_RenderText_Solid(parent->basicfont, text.c_str(), sdlcolour);
+		textsurf = parent->getTextSurface(text, sdlcolour, 0);
 	} else {
 		SDL_Color sdlbgcolour;
 		if (engine.version == 1) sdlbgcolour = palette[bgcolour];
 		else sdlbgcolour = getColourFromRGBA(bgcolour);
-		textsurf = TTF_RenderText_Shaded(parent->basicfont, text.c_str(), sdlcolour, sdlbgcolour);
+		textsurf = parent->getTextSurface(text, sdlcolour, &sdlbgcolour);
 	}
 
 	if (!textsurf) return; // thanks, SDL_ttf, we love you too
@@ -279,7 +513,54 @@ void SDLSurface::renderText(int x, int y, std::string text, unsigned int colour,
 	SDL_Rect destrect;
 	destrect.x = x; destrect.y = y;	
 	SDL_BlitSurface(textsurf, NULL, surface, &destrect);
-	SDL_FreeSurface(textsurf);
+}
+
+#define TEXT_CACHE_SIZE 64
+
+/*
+ * Returns a rendered surface for the given text, which remains owned by the
+ * cache; the least recently used entries are freed once the cache is full.
+ */
+SDL_Surface *SDLBackend::getTextSurface(std::string text, SDL_Color colour, SDL_Color *bgcolour) {
+	SDLTextCacheKey key;
+	key.text = text;
+	key.colour = (colour.r << 16) | (colour.g << 8) | colour.b;
+	// the top byte distinguishes a transparent background from a black one
+	key.bgcolour = bgcolour ? ((1 << 24) | (bgcolour->r << 16) | (bgcolour->g << 8) | bgcolour->b) : 0;
+
+	std::map<SDLTextCacheKey, SDLTextCacheEntry>::iterator i = textcache.find(key);
+	if (i != textcache.end()) {
+		textcachelru.splice(textcachelru.begin(), textcachelru, i->second.lru);
+		return i->second.surface;
+	}
+
+	SDL_Surface *textsurf;
+	if (bgcolour)
+		textsurf = TTF_RenderText_Shaded(basicfont, text.c_str(), colour, *bgcolour);
+	else
+		textsurf = TTF_RenderText_Solid(basicfont, text.c_str(), colour);
+	if (!textsurf) return 0;
+
+	while (textcache.size() >= TEXT_CACHE_SIZE) {
+		std::map<SDLTextCacheKey, SDLTextCacheEntry>::iterator old = textcache.find(textcachelru.back());
+		assert(old != textcache.end());
+		SDL_FreeSurface(old->second.surface);
+		textcache.erase(old);
+		textcachelru.pop_back();
+	}
+
+	textcachelru.push_front(key);
+	SDLTextCacheEntry &e = textcache[key];
+	e.surface = textsurf;
+	e.lru = textcachelru.begin();
+	return textsurf;
+}
+
+void SDLBackend::flushTextCache() {
+	for (std::map<SDLTextCacheKey, SDLTextCacheEntry>::iterator i = textcache.begin(); i != textcache.end(); i++)
+		SDL_FreeSurface(i->second.surface);
+	textcache.clear();
+	textcachelru.clear();
 }
 
 //*** code to mirror 16bpp surface - slow, we should cache this!
@@ -438,10 +719,29 @@ void SDLSurface::blitSurface(Surface *s, int x, int y, int w, int h) {
 	SDL_SoftStretch(src->surface, 0, surface, &r);
 }
 
+void SDLSurface::renderSurface(Surface *s, int x, int y, bool trans, unsigned char transparency) {
+	SDLSurface *src = dynamic_cast<SDLSurface *>(s);
+	assert(src);
+
+	if (x >= (int)width || y >= (int)height) return;
+	if (x + (int)src->width <= 0 || y + (int)src->height <= 0) return;
+
+	SDL_SetColorKey(src->surface, SDL_SRCCOLORKEY, 0);
+	if (trans)
+		SDL_SetAlpha(src->surface, SDL_SRCALPHA, 255 - transparency);
+	else
+		SDL_SetAlpha(src->surface, 0, 255);
+
+	SDL_Rect destrect;
+	destrect.x = x; destrect.y = y;
+	SDL_BlitSurface(src->surface, 0, surface, &destrect);
+}
+
 Surface *SDLBackend::newSurface(unsigned int w, unsigned int h) {
 	SDL_Surface *surf = mainsurface.surface;
 	SDL_Surface* underlyingsurf = SDL_CreateRGBSurface(SDL_HWSURFACE, w, h, surf->format->BitsPerPixel, surf->format->Rmask, surf->format->Gmask, surf->format->Bmask, surf->format->Amask);
 	assert(underlyingsurf);
+	SDL_FillRect(underlyingsurf, 0, 0); // colour 0 is transparent to renderSurface
 	SDLSurface *newsurf = new SDLSurface(this);
 	newsurf->surface = underlyingsurf;
 	newsurf->width = w;
@@ -23,6 +23,13 @@
 #include "SDL.h"
 #include <SDL_net.h>
 #include "Backend.h"
+#include <list>
+#include <map>
+#include <set>
+#include <string>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition.hpp>
 
 class SDLSurface : public Surface {
 	friend class SDLBackend;
@@ -40,11 +47,81 @@ public:
 	void renderLine(int x1, int y1, int x2, int y2, unsigned int colour);
 	void renderText(int x, int y, std::string text, unsigned int colour, unsigned int bgcolour);
 	void blitSurface(Surface *src, int x, int y, int w, int h);
+	void renderSurface(Surface *src, int x, int y, bool trans = false, unsigned char transparency = 0);
 	unsigned int getWidth() const { return width; }
 	unsigned int getHeight() const { return height; }
 	void renderDone();
 };
 
+/*
+ * Sends replies to network clients on a single thread of its own, since
+ * SDLNet_TCP_Send blocks until everything is written and a slow client
+ * mustn't stall the main loop. Each client has at most one outbox in the
+ * queue; replies are sent a chunk at a time, taking turns between clients, so
+ * one slow client only holds up the others for a chunk.
+ */
+class SDLNetSender {
+protected:
+	struct outbox {
+		TCPsocket socket;
+		std::string data;
+	};
+
+	boost::mutex lock;
+	boost::condition wake;
+	std::list<outbox> queue;
+	std::set<TCPsocket> failedsockets;
+	TCPsocket sending; // the client a chunk is being sent to, if any
+	bool stopping;
+	boost::thread *thread;
+
+	void run();
+	std::list<outbox>::iterator find(TCPsocket s);
+
+public:
+	SDLNetSender();
+	~SDLNetSender();
+
+	void send(TCPsocket s, const std::string &data);
+	bool idle(TCPsocket s); // nothing queued or being sent to this client
+	bool failed(TCPsocket s);
+	void forget(TCPsocket s); // the client's gone, so drop anything left for it
+	void stop(); // drop anything queued, and wait for the chunk being sent
+};
+
+/*
+ * A debug/injection client connection. A request is everything received up to
+ * a trailing "rscr\n" (like c2e); we reply and close the connection. Clients
+ * which start with a "sesn\n" line get a persistent session instead, where
+ * each request and each reply is prefixed by its length in bytes and a newline.
+ */
+struct SDLNetConnection {
+	TCPsocket socket;
+	std::string buffer;
+	bool session;
+	bool closed;
+};
+
+/*
+ * Rendered strings are cached by text and (resolved) colours, since bubbles
+ * and blackboards redraw the same few strings every frame.
+ */
+struct SDLTextCacheKey {
+	std::string text;
+	unsigned int colour, bgcolour;
+
+	bool operator < (const SDLTextCacheKey &o) const {
+		if (colour != o.colour) return colour < o.colour;
+		if (bgcolour != o.bgcolour) return bgcolour < o.bgcolour;
+		return text < o.text;
+	}
+};
+
+struct SDLTextCacheEntry {
+	SDL_Surface *surface;
+	std::list<SDLTextCacheKey>::iterator lru;
+};
+
 class SDLBackend : public Backend {
 	friend class SDLSurface;
 
@@ -53,10 +130,21 @@ protected:
 
 	SDLSurface mainsurface;
 	TCPsocket listensocket;
+	SDLNet_SocketSet socketset;
+	std::list<SDLNetConnection> connections;
+	SDLNetSender *sender;
 
 	struct _TTF_Font *basicfont;
 
+	std::map<SDLTextCacheKey, SDLTextCacheEntry> textcache;
+	std::list<SDLTextCacheKey> textcachelru;
+	SDL_Surface *getTextSurface(std::string text, SDL_Color colour, SDL_Color *bgcolour);
+	void flushTextCache();
+
 	void handleNetworking();
+	void acceptConnections();
+	bool handleNetworkRequest(SDLNetConnection &c);
+	void closeConnection(SDLNetConnection &c);
 	void resizeNotify(int _w, int _h);
 	int translateKey(int key);
 
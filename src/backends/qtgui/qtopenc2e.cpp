@@ -453,7 +453,7 @@ void QtOpenc2e::selectCreature() {
 
 	Agent *a = (Agent *)srcaction->data().value<void *>();
 
-	for (std::list<boost::shared_ptr<Agent> >::iterator i = world.agents.begin(); i != world.agents.end(); i++) {
+	for (agentRegistry::iterator i = world.agents.begin(); i != world.agents.end(); i++) {
 		boost::shared_ptr<Agent> p = *i;
 		if (!p) continue; // grr, but needed
 
@@ -469,7 +469,7 @@ void QtOpenc2e::selectCreature() {
 void QtOpenc2e::updateCreaturesMenu() {
 	creaturesMenu->clear();
 
-	for (std::list<boost::shared_ptr<Agent> >::iterator i = world.agents.begin(); i != world.agents.end(); i++) {
+	for (agentRegistry::iterator i = world.agents.begin(); i != world.agents.end(); i++) {
 		boost::shared_ptr<Agent> p = *i;
 		if (!p) continue; // grr, but needed
 
@@ -674,7 +674,7 @@ void QtOpenc2e::updateAppletStatus() {
 
 		// update 'next creature' button depending on whether there's any creatures we can select
 		bool are_there_creatures_present = false;
-		for (std::list<boost::shared_ptr<Agent> >::iterator i = world.agents.begin(); i != world.agents.end(); i++) {
+		for (agentRegistry::iterator i = world.agents.begin(); i != world.agents.end(); i++) {
 			boost::shared_ptr<Agent> p = *i;
 			if (!p) continue; // grr, but needed
 
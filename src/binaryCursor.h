@@ -0,0 +1,99 @@
+/*
+ *  binaryCursor.h
+ *  openc2e
+ *
+ *  Created by the openc2e team on Mon Oct 19 2026.
+ *  Copyright (c) 2026 the openc2e team. All rights reserved.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ */
+
+
+#ifndef _BINARYCURSOR_H
+#define _BINARYCURSOR_H
+
+#include "endianlove.h"
+#include "exceptions.h"
+#include "mmapifstream.h"
+#include <string>
+#include <string.h>
+
+/*
+ * A read cursor over a block of memory (typically an mmapifstream), for
+ * parsing binary files without going through iostreams.
+ *
+ * Every read is bounds-checked and throws a creaturesException if it would
+ * run off the end of the data. The cursor doesn't own the data, so it must
+ * outlive any cursor (and any pointer returned by skip()) made from it.
+ */
+class binaryCursor {
+protected:
+	const unsigned char *data;
+	unsigned int datasize, pos;
+
+	void need(unsigned int n) const {
+		if (n > datasize - pos)
+			throw creaturesException("unexpected end of data while reading file");
+	}
+
+public:
+	binaryCursor(const char *d, unsigned int n) { data = (const unsigned char *)d; datasize = n; pos = 0; }
+	binaryCursor(const std::string &s) { data = (const unsigned char *)s.data(); datasize = s.size(); pos = 0; }
+	binaryCursor(mmapifstream &s) { data = (const unsigned char *)s.map; datasize = (s.live ? s.filesize : 0); pos = 0; }
+
+	unsigned int tell() const { return pos; }
+	unsigned int size() const { return datasize; }
+	unsigned int remaining() const { return datasize - pos; }
+	bool eof() const { return pos >= datasize; }
+	void seek(unsigned int p) { if (p > datasize) throw creaturesException("seek past end of data"); pos = p; }
+
+	uint8 read8() { need(1); return data[pos++]; }
+	uint16 read16(bool littleend = true) {
+		need(2);
+		uint16 v = littleend ? (data[pos] | (data[pos + 1] << 8)) : ((data[pos] << 8) | data[pos + 1]);
+		pos += 2;
+		return v;
+	}
+	uint32 read32() {
+		need(4);
+		uint32 v = data[pos] | (data[pos + 1] << 8) | (data[pos + 2] << 16) | ((uint32)data[pos + 3] << 24);
+		pos += 4;
+		return v;
+	}
+
+	void read(void *out, unsigned int n) { need(n); memcpy(out, data + pos, n); pos += n; }
+	std::string readBytes(unsigned int n) { need(n); std::string s((const char *)data + pos, n); pos += n; return s; }
+	// returns a pointer to the next n bytes, without copying them
+	const char *skip(unsigned int n) { need(n); const char *p = (const char *)data + pos; pos += n; return p; }
+
+	// reads up to the next newline (which is dropped, along with any \r); false at the end of the data
+	bool readLine(std::string &line) {
+		if (eof()) return false;
+		const unsigned char *start = data + pos;
+		const unsigned char *end = (const unsigned char *)memchr(start, '\n', datasize - pos);
+		unsigned int len = end ? (end - start) : (datasize - pos);
+		pos += len + (end ? 1 : 0);
+		if (len && start[len - 1] == '\r') len--;
+		line.assign((const char *)start, len);
+		return true;
+	}
+
+	binaryCursor &operator >> (uint8 &v) { v = read8(); return *this; }
+	binaryCursor &operator >> (char &v) { v = (char)read8(); return *this; }
+};
+
+// for code which also reads from streams, see streamutils.h
+inline uint16 read16(binaryCursor &c, bool littleend = true) { return c.read16(littleend); }
+inline uint32 read32(binaryCursor &c) { return c.read32(); }
+
+#endif
+/* vim: set noet: */
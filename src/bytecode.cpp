@@ -70,6 +70,22 @@ std::string dumpOp(const Dialect *d, caosOp op) {
 			return str(format("YIELD %d") % arg);
 		case CAOS_STACK_ROT:
 			return str(format("STACK ROT %d") % arg);
+		case CAOS_GAMEVAR:
+			return str(format("GAMEVAR %d") % arg);
+		case CAOS_SAVE_GAMEVAR:
+			return str(format("GAMEVAR SAVE %d") % arg);
+		case CAOS_VAXX:
+			return str(format("VAXX %d") % arg);
+		case CAOS_SETV_VAXX:
+			return str(format("SETV VAXX %d") % arg);
+		case CAOS_ADDV_VAXX:
+			return str(format("ADDV VAXX %d") % arg);
+		case CAOS_COND_INT:
+			return str(format("COND INT %s %s") % (arg & CAND ? "AND" : "OR") % cnams[arg & CMASK]);
+		case CAOS_SETV_VAXX_INT:
+			return str(format("SETV VAXX INT %d") % arg);
+		case CAOS_ADDV_VAXX_INT:
+			return str(format("ADDV VAXX INT %d") % arg);
 
 		case CAOS_CJMP:
 			return str(format("CJMP %08d") % arg);
@@ -81,6 +97,8 @@ std::string dumpOp(const Dialect *d, caosOp op) {
 			return str(format("GSUB %08d") % arg);
 		case CAOS_ENUMPOP:
 			return str(format("ENUMPOP %08d") % arg);
+		case CAOS_CJMPZ:
+			return str(format("CJMPZ %08d") % arg);
 		default:
 			return str(format("UNKNOWN %02x %06x") % arg);
 	}
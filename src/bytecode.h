@@ -94,6 +94,44 @@ enum opcode_t {
 	 * Argument: How many places to move it down
 	 */
 	CAOS_STACK_ROT,
+	/* Push the GAME variable named by a string constant; this is what
+	 * GAME with a literal name compiles to. The name is interned into a
+	 * slot of the variable store the first time the op runs.
+	 * Argument: An index into the constants table
+	 */
+	CAOS_GAMEVAR,
+	/* Pop a value and store it in the GAME variable named by a string
+	 * constant, as for CAOS_GAMEVAR.
+	 * Argument: An index into the constants table
+	 */
+	CAOS_SAVE_GAMEVAR,
+	/* Push the value of a script-local variable; this is what a read of
+	 * VAxx with a literal index is optimised into.
+	 * Argument: The (remapped) variable index
+	 */
+	CAOS_VAXX,
+	/* Pop a value and SETV the given script-local variable to it.
+	 * Argument: The (remapped) variable index
+	 */
+	CAOS_SETV_VAXX,
+	/* Pop a value and ADDV it to the given script-local variable.
+	 * Argument: The (remapped) variable index
+	 */
+	CAOS_ADDV_VAXX,
+	/* As CAOS_COND, for when the compiler has proven that both values and
+	 * the flag are integers.
+	 * Argument: A comparison flag
+	 */
+	CAOS_COND_INT,
+	/* As CAOS_SETV_VAXX, for a value which is known to be an integer.
+	 * Argument: The (remapped) variable index
+	 */
+	CAOS_SETV_VAXX_INT,
+	/* As CAOS_ADDV_VAXX, for when both the variable and the value are
+	 * known to be integers.
+	 * Argument: The (remapped) variable index
+	 */
+	CAOS_ADDV_VAXX_INT,
 	/* Pseudo-instructions; marks the beginning of relocated ops. */
 	CAOS_NONRELOC_END,
 	CAOS_RELOCATABLE_BEGIN = 0x40,
@@ -125,6 +163,11 @@ enum opcode_t {
 	 * Cost: 0
 	 */
 	CAOS_ENUMPOP,
+	/* Pop an integer off the stack. Jump to the given location if it's zero.
+	 * Argument: A bytecode location (relocated).
+	 * Cost: 0
+	 */
+	CAOS_CJMPZ,
 
 	CAOS_INVALID
 }; 
@@ -173,5 +216,25 @@ std::string dumpOp(const class Dialect *d, caosOp op);
 
 extern const char *cnams[];
 
+// CAOS_COND on integers; the optimiser and CAOS_COND_INT rely on this
+// giving the same answers as CAOS_COND does
+static inline int int_condition(int accum, int v1, int v2, int flags) {
+	int result = 0;
+	switch (flags & ~CAND) {
+		case CEQ: result = (v1 == v2); break;
+		case CNE: result = !(v1 == v2); break;
+		case CLT: result = (v1 < v2); break;
+		case CGE: result = !(v1 < v2); break;
+		case CGT: result = (v1 > v2); break;
+		case CLE: result = !(v1 > v2); break;
+		case CBT: result = (v2 == (v1 & v2)); break;
+		case CBF: result = (0 == (v1 & v2)); break;
+	}
+	if (flags & CAND)
+		return (accum && result);
+	else
+		return (accum || result);
+}
+
 #endif
 /* vim: set noet: */
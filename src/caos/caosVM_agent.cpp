@@ -87,7 +87,7 @@ void caosVM::c_RTAR() {
 
 	/* XXX: maybe use a map of classifier -> agents? */
 	std::vector<boost::shared_ptr<Agent> > temp;
-	for (std::list<boost::shared_ptr<Agent> >::iterator i
+	for (agentRegistry::iterator i
 		= world.agents.begin(); i != world.agents.end(); i++) {
 		
 		Agent *a = i->get();
@@ -124,7 +124,7 @@ void caosVM::c_TTAR() {
 
 	/* XXX: maybe use a map of classifier -> agents? */
 	std::vector<boost::shared_ptr<Agent> > temp;
-	for (std::list<boost::shared_ptr<Agent> >::iterator i
+	for (agentRegistry::iterator i
 		= world.agents.begin(); i != world.agents.end(); i++) {
 		
 		Agent *a = i->get();
@@ -900,7 +900,7 @@ void caosVM::v_TOTL() {
 	VM_PARAM_INTEGER(family) caos_assert(family >= 0); caos_assert(family <= 255);
 
 	unsigned int x = 0;
-	for (std::list<boost::shared_ptr<Agent> >::iterator i = world.agents.begin(); i != world.agents.end(); i++) {
+	for (agentRegistry::iterator i = world.agents.begin(); i != world.agents.end(); i++) {
 		if (!*i) continue;
 		if ((*i)->family == family || family == 0)
 			if ((*i)->genus == genus || genus == 0)
@@ -1599,7 +1599,7 @@ AgentRef findNextAgent(AgentRef previous, unsigned char family, unsigned char ge
 	AgentRef firstagent;
 	bool foundagent = false;
 
-	std::list<boost::shared_ptr<Agent> >::iterator i;
+	agentRegistry::iterator i;
 	if (forward)
 		i = world.agents.begin();
 	else {
@@ -476,6 +476,39 @@ void caosVM::v_BKGD() {
 	result.setString(""); // TODO
 }
 
+/**
+ CMRD (command) divisor (integer)
+ %status ok
+
+ Sets how often the remote camera chosen with SCAM redraws its view: at most once every
+ 'divisor' ticks, or whenever the camera moves. 1 redraws every tick. New remote cameras
+ start with the value of the engine_remote_camera_divisor game variable.
+
+ This is an openc2e extension.
+*/
+void caosVM::c_CMRD() {
+	VM_PARAM_INTEGER(divisor)
+
+	caos_assert(divisor > 0);
+	PartCamera *c = dynamic_cast<PartCamera *>(getCamera());
+	caos_assert(c); // only remote cameras have a divisor
+	c->getPart()->setRefreshDivisor(divisor);
+}
+
+/**
+ CMRD (integer)
+ %status ok
+
+ Returns the refresh divisor of the remote camera chosen with SCAM (see the CMRD command).
+
+ This is an openc2e extension.
+*/
+void caosVM::v_CMRD() {
+	PartCamera *c = dynamic_cast<PartCamera *>(getCamera());
+	caos_assert(c);
+	result.setInt(c->getPart()->getRefreshDivisor());
+}
+
 /**
  FRSH (command)
  %status stub
@@ -303,6 +303,7 @@ void caosVM::c_PAT_MOVE() {
 
 	p->x = x;
 	p->y = y;
+	world.partsChanged();
 }
 
 /**
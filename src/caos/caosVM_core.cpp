@@ -144,9 +144,7 @@ CAOS_LVALUE(EAME, VM_PARAM_VALUE(name),
 void caosVM::c_DELG() {
 	VM_PARAM_STRING(name)
 
-	std::map<std::string, caosVar>::iterator i = world.variables.find(name);
-	if (i != world.variables.end())
-		world.variables.erase(i);
+	world.variables.erase(name);
 }
 
 /**
@@ -20,13 +20,19 @@
 #include "caosVM.h"
 #include "openc2e.h"
 #include "Agent.h"
+#include "SimpleAgent.h"
+#include "CompoundAgent.h"
 #include "World.h"
+#include "Engine.h"
+#include "AudioBackend.h"
+#include "mapSnapshot.h"
 #include <iostream>
 #include "cmddata.h"
 #include <cctype>
 #include "dialect.h"
 #include <algorithm>
 #include "caosScript.h"
+#include "caosAOT.h"
 
 // #include "malloc.h" <- unportable horror!
 #include <sstream>
@@ -293,24 +299,78 @@ void caosVM::v_DBG_IDNT() {
 		result.setString(a->identify());
 }
 
+static bool hotterScript(const shared_ptr<script> &a, const shared_ptr<script> &b) {
+	return a->profops > b->profops;
+}
+
 /**
  DBG: PROF (command)
- %status stub
+ %status maybe
 
  Dumps the current agent profiling information to the output stream, in CSV format.
+
+ In openc2e, this lists every installed script which has run since the last DBG: CPRO,
+ hottest (most ops run) first, with its classifier, how many times it was started and
+ how many ops it ran.
 */
 void caosVM::c_DBG_PROF() {
-	// TODO
+	caos_assert(outputstream);
+
+	std::vector<shared_ptr<script> > scripts;
+	world.scriptorium.getAllScripts(scripts);
+	std::sort(scripts.begin(), scripts.end(), hotterScript);
+
+	*outputstream << "family,genus,species,event,runs,ops,ops per run" << std::endl;
+	for (std::vector<shared_ptr<script> >::iterator i = scripts.begin(); i != scripts.end(); i++) {
+		script &s = **i;
+		if (!s.profruns && !s.profops)
+			continue;
+		*outputstream << boost::format("%d,%d,%d,%d,%u,%lu,%lu")
+			% s.fmly % s.gnus % s.spcs % s.scrp % s.profruns % s.profops
+			% (s.profruns ? s.profops / s.profruns : s.profops) << std::endl;
+	}
 }
 
 /**
  DBG: CPRO (command)
- %status stub
+ %status maybe
 
  Clears the current agent profiling information.
 */
 void caosVM::c_DBG_CPRO() {
-	// TODO
+	std::vector<shared_ptr<script> > scripts;
+	world.scriptorium.getAllScripts(scripts);
+	for (std::vector<shared_ptr<script> >::iterator i = scripts.begin(); i != scripts.end(); i++) {
+		(*i)->profruns = 0;
+		(*i)->profops = 0;
+	}
+}
+
+/**
+ DBG: AOTC count (integer)
+ %status maybe
+
+ Writes C++ to the output stream for natively compiled versions of the 'count' hottest
+ scripts, as listed by DBG: PROF. Build it into a module and load it with --aot to run
+ those scripts without the interpreter's dispatch.
+
+ This is an openc2e extension.
+*/
+void caosVM::c_DBG_AOTC() {
+	VM_PARAM_INTEGER(count)
+
+	caos_assert(outputstream);
+	caos_assert(count >= 0);
+
+	std::vector<shared_ptr<script> > scripts, hottest;
+	world.scriptorium.getAllScripts(scripts);
+	std::sort(scripts.begin(), scripts.end(), hotterScript);
+	for (unsigned int i = 0; i < scripts.size() && (int)hottest.size() < count; i++) {
+		if (scripts[i]->profops)
+			hottest.push_back(scripts[i]);
+	}
+
+	writeNativeScripts(*outputstream, hottest);
 }
 
 /**
@@ -352,6 +412,55 @@ void caosVM::v_DBG_TSLC() {
 	result.setInt(timeslice);
 }
 
+/**
+ DBG: BUDG (command) ops (integer)
+ %status ok
+ %pragma variants all
+
+ Sets the per-tick budget of CAOS ops for agent scripts, or 0 for no limit (the default).
+ Once a tick's budget is spent, the agents whose scripts haven't run yet wait until the
+ next tick, when they go first regardless of the budget.
+*/
+void caosVM::c_DBG_BUDG() {
+	VM_PARAM_INTEGER(ops)
+	caos_assert(ops >= 0);
+	world.scriptbudget = ops;
+}
+
+/**
+ DBG: BUDG (string)
+ %status ok
+ %pragma variants all
+
+ Returns a human-readable summary of the per-tick script budget and how agent scripts
+ have fared against it.
+*/
+void caosVM::v_DBG_BUDG() {
+	std::ostringstream oss;
+	if (world.scriptbudget)
+		oss << "budget: " << world.scriptbudget << " ops per tick" << std::endl;
+	else
+		oss << "budget: unlimited" << std::endl;
+	oss << "ops last tick: " << world.scriptstats.lastops << std::endl;
+	oss << "most ops in a tick: " << world.scriptstats.peakops << std::endl;
+	oss << "ticks over budget: " << world.scriptstats.overbudgetticks << std::endl;
+	oss << "agent ticks deferred: " << world.scriptstats.deferrals << std::endl;
+	result.setString(oss.str());
+}
+
+/**
+ DBG: SOUN (string)
+ %status ok
+ %pragma variants all
+
+ Returns a human-readable summary of the sound backend's source pool and clip cache: how
+ many sources are in use, how often a sound had to steal one, and the cache's hit rate.
+ Empty if the sound backend doesn't keep any statistics.
+*/
+void caosVM::v_DBG_SOUN() {
+	result.setString(engine.audio->getStatistics());
+}
+
 /**
 DBG: SIZO (string)
  %status ok
@@ -366,6 +475,9 @@ void caosVM::v_DBG_SIZO() {
 	SIZEOF_OUT(caosVM);
 	SIZEOF_OUT(caosVar);
 	SIZEOF_OUT(Agent);
+	SIZEOF_OUT(SimpleAgent);
+	SIZEOF_OUT(CompoundAgent);
+	SIZEOF_OUT(agentVariables);
 	SIZEOF_OUT(std::string);
 	SIZEOF_OUT(AgentRef);
 	SIZEOF_OUT(Vector<float>);
@@ -375,9 +487,44 @@ void caosVM::v_DBG_SIZO() {
 	oss << "This build of openc2e does not have allocation profiling enabled." << std::endl;
 #endif
 	oss << "caosVMs in pool: " << world.vmpool_size() << std::endl;
+
+	// per-agent storage which only exists once something is put into it
+	unsigned int agents = 0, withovs = 0, ovchunks = 0, withnames = 0, withports = 0, lazybytes = 0;
+	for (agentRegistry::iterator i = world.agents.begin(); i != world.agents.end(); i++) {
+		Agent *a = i->get();
+		if (!a) continue;
+		agents++;
+		if (a->var.allocatedChunks()) withovs++;
+		ovchunks += a->var.allocatedChunks();
+		if (!a->name_variables.empty()) withnames++;
+		if (!a->inports.empty() || !a->outports.empty()) withports++;
+		lazybytes += a->var.heapBytes() + a->name_variables.heapBytes()
+			+ a->inports.heapBytes() + a->outports.heapBytes()
+			+ a->carry_points.heapBytes() + a->carried_points.heapBytes()
+			+ a->genome_slots.heapBytes();
+	}
+	oss << "agents: " << agents << " (" << world.agents.slotCount() << " UNID slots, " << world.agents.holeCount() << " holes)" << std::endl;
+	oss << "agents with OVxx storage: " << withovs << " (" << ovchunks << " chunks of " << (unsigned int)agentVariables::chunksize << ")" << std::endl;
+	oss << "agents with NAME variables: " << withnames << std::endl;
+	oss << "agents with ports: " << withports << std::endl;
+	if (agents)
+		oss << "average lazily allocated bytes per agent: " << lazybytes / agents << std::endl;
 #undef SIZEOF_OUT
 
 	result.setString(oss.str());
 }
 
+/**
+DBG: SNAP (string)
+ %status ok
+ %pragma variants all
+
+ Snapshots the current map, scripts and game variables (everything SAVE
+ covers) using both the binary and the text archive formats, and returns a
+ human-readable comparison of their save/load times and sizes.
+ */
+void caosVM::v_DBG_SNAP() {
+	result.setString(mapSnapshot::benchmark());
+}
+
 /* vim: set noet: */
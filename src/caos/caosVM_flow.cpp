@@ -222,7 +222,7 @@ void caosVM::c_ENUM() {
 	caosVar nullv; nullv.reset();
 	valueStack.push_back(nullv);
 	
-	for (std::list<boost::shared_ptr<Agent> >::iterator i
+	for (agentRegistry::iterator i
 			= world.agents.begin(); i != world.agents.end(); i++) {
 		boost::shared_ptr<Agent> a = (*i);
 		if (!a) continue;
@@ -286,7 +286,7 @@ void caosVM::c_ETCH() {
 	caosVar nullv; nullv.reset();
 	valueStack.push_back(nullv);
 	
-	for (std::list<boost::shared_ptr<Agent> >::iterator i
+	for (agentRegistry::iterator i
 			= world.agents.begin(); i != world.agents.end(); i++) {
 		boost::shared_ptr<Agent> a = (*i);
 		if (!a) continue;
@@ -112,25 +112,18 @@ void caosVM::c_IMSK() {
 	VM_PARAM_INTEGER(flags)
 
 	valid_agent(targ);
-	targ->imsk_key_down = (flags & 1);
-	targ->imsk_key_up = (flags & 2);
-	targ->imsk_mouse_move = (flags & 4);
-	targ->imsk_mouse_down = (flags & 8);
-	targ->imsk_mouse_up = (flags & 16);
-	targ->imsk_mouse_wheel = (flags & 32);
-	targ->imsk_translated_char = (flags & 64);
-	// TODO
+	targ->setInputMask(flags);
 }
 
 /**
  IMSK (integer)
- %status stub
+ %status maybe
 
  Returns the input event flags for the target agent. See the IMSK command for details.
 */
 void caosVM::v_IMSK() {
 	valid_agent(targ);
-	result.setInt(0); // TODO
+	result.setInt(targ->getInputMask());
 }
 
 /**
@@ -286,6 +286,7 @@ void caosVM::c_DOOR() {
 		RoomDoor *door = r1->doors[r2];
 		door->perm = perm;
 	}
+	world.map.roomSystemChanged();
 }
 
 /**
@@ -974,6 +975,7 @@ void caosVM::c_SETV_DOOR() {
 		RoomDoor *door = r1->doors[r2];
 		door->perm = perm;
 	}
+	world.map.roomSystemChanged();
 }
 
 /**
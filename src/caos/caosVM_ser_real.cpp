@@ -19,14 +19,23 @@
 
 #include <boost/archive/text_oarchive.hpp>
 #include <boost/archive/text_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
+#include <boost/archive/binary_iarchive.hpp>
 
 #include "caosVM.h"
-//#include "ser/s_map.h"
+#include "ser/s_map.h"
 #include "ser/s_Scriptorium.h"
+#include "ser/s_agentSnapshot.h"
 #include "serialization.h"
 #include "World.h"
+#include "Agent.h"
+#include "Engine.h"
+#include "Backend.h"
+#include "mapSnapshot.h"
+#include "agentSnapshot.h"
 
 #include <fstream>
+#include <sstream>
 
 // Note: this file may require an exorbitant amount of RAM to compile
 // You have been warned.
@@ -90,3 +99,230 @@ void caosVM::c_SERL_SCRP() {
 	}
 }
 
+/*
+ * World snapshots (see mapSnapshot.h). Each section is a separate archive.
+ */
+
+struct worldClock {
+	unsigned int ticktime, tickcount, worldtickcount;
+	unsigned int timeofday, dayofseason, season, year;
+};
+
+SERIALIZE(worldClock) {
+	ar & obj.ticktime & obj.tickcount & obj.worldtickcount;
+	ar & obj.timeofday & obj.dayofseason & obj.season & obj.year;
+}
+
+template <class Archive>
+static void saveSection(Archive &ar, const std::string &name, const Map &map, const Scriptorium &scriptorium, const std::map<std::string, caosVar> &variables, const worldClock &c, const agentSnapshot &agents) {
+	if (name == "world") {
+		ar << c;
+		ar << variables;
+	} else if (name == "map") {
+		ar << map;
+	} else if (name == "scripts") {
+		ar << scriptorium;
+	} else if (name == "agents") {
+		ar << agents.agents;
+		ar << agents.variablelinks;
+	} else if (name == "genomes") {
+		ar << agents.genomes;
+	}
+}
+
+template <class Archive>
+static void loadSection(Archive &ar, const std::string &name, Map &map, Scriptorium &scriptorium, std::map<std::string, caosVar> &variables, worldClock &c, agentSnapshot &agents) {
+	if (name == "world") {
+		ar >> c;
+		ar >> variables;
+	} else if (name == "map") {
+		ar >> map;
+	} else if (name == "scripts") {
+		ar >> scriptorium;
+	} else if (name == "agents") {
+		ar >> agents.agents;
+		ar >> agents.variablelinks;
+	} else if (name == "genomes") {
+		ar >> agents.genomes;
+	}
+}
+
+static const char *snapshotsections[] = { "world", "map", "scripts", "agents", "genomes", 0 };
+
+// serialising scripts fills in a shared table of command names (see s_caosScript.h)
+static boost::mutex serialiselock;
+
+struct mapSnapshot::stagedState {
+	Map map;
+	Scriptorium scriptorium;
+	std::map<std::string, caosVar> variables;
+	worldClock clock;
+	agentSnapshot agents;
+	bool hasworld, hasmap, hasscripts, hasagents, hasgenomes;
+
+	stagedState() { hasworld = hasmap = hasscripts = hasagents = hasgenomes = false; }
+	~stagedState() { map.Reset(); }
+};
+
+/*
+ * Takes a private copy of everything a snapshot covers, which capture() can
+ * then serialise on another thread while the world carries on ticking.
+ *
+ * Scripts are shared rather than copied, since they're never modified once
+ * installed. Agents are copied into plain records (see agentSnapshot), and
+ * agent references in game variables are swapped for UNIDs here rather than
+ * by the serialiser, so no agents are touched off the main thread.
+ */
+void mapSnapshot::copyWorld() {
+	shared_ptr<stagedState> st(new stagedState());
+
+	tick = world.worldtickcount;
+	worldClock &c = st->clock;
+	c.ticktime = world.ticktime; c.tickcount = world.tickcount; c.worldtickcount = world.worldtickcount;
+	c.timeofday = world.timeofday; c.dayofseason = world.dayofseason; c.season = world.season; c.year = world.year;
+	world.variables.save(st->variables);
+	for (std::map<std::string, caosVar>::iterator i = st->variables.begin(); i != st->variables.end(); i++) {
+		if (!i->second.hasAgent()) continue;
+		Agent *a = i->second.getAgent().get();
+		st->agents.variablelinks[i->first] = a ? a->getUNID() : -1;
+		i->second.setAgent(AgentRef());
+	}
+	world.map.copyTo(st->map);
+	st->scriptorium = world.scriptorium;
+	st->agents.capture();
+	st->hasworld = st->hasmap = st->hasscripts = st->hasagents = st->hasgenomes = true;
+
+	staged = st;
+}
+
+/*
+ * Serialises the copy taken by copyWorld() (taking one first if need be) into
+ * the sections. Safe to call off the main thread once copyWorld() is done.
+ */
+void mapSnapshot::capture(bool textarchive) {
+	if (!staged)
+		copyWorld();
+	shared_ptr<stagedState> st = staged;
+	staged.reset();
+
+	text = textarchive;
+	sections.clear();
+
+	boost::mutex::scoped_lock l(serialiselock);
+	for (unsigned int i = 0; snapshotsections[i]; i++) {
+		std::ostringstream o(std::ios::binary);
+		if (text) {
+			boost::archive::text_oarchive oa(o);
+			saveSection(oa, snapshotsections[i], st->map, st->scriptorium, st->variables, st->clock, st->agents);
+		} else {
+			boost::archive::binary_oarchive oa(o);
+			saveSection(oa, snapshotsections[i], st->map, st->scriptorium, st->variables, st->clock, st->agents);
+		}
+		sections[snapshotsections[i]] = o.str();
+	}
+}
+
+/*
+ * Deserialises every section into scratch objects, ready for restore(). Throws
+ * (leaving the world alone) if any of them can't be loaded.
+ */
+void mapSnapshot::stage() {
+	shared_ptr<stagedState> st(new stagedState());
+
+	boost::mutex::scoped_lock l(serialiselock);
+	for (std::map<std::string, std::string>::iterator i = sections.begin(); i != sections.end(); i++) {
+		std::istringstream in(i->second, std::ios::binary);
+		if (text) {
+			boost::archive::text_iarchive ia(in);
+			loadSection(ia, i->first, st->map, st->scriptorium, st->variables, st->clock, st->agents);
+		} else {
+			boost::archive::binary_iarchive ia(in);
+			loadSection(ia, i->first, st->map, st->scriptorium, st->variables, st->clock, st->agents);
+		}
+		if (i->first == "world") st->hasworld = true;
+		else if (i->first == "map") st->hasmap = true;
+		else if (i->first == "scripts") st->hasscripts = true;
+		else if (i->first == "agents") st->hasagents = true;
+		else if (i->first == "genomes") st->hasgenomes = true;
+	}
+	if (st->hasagents != st->hasgenomes)
+		throw creaturesException("saved world has agents without their genomes, or the other way round");
+
+	staged = st;
+}
+
+/*
+ * Swaps the state loaded by stage() into the world. The agents are built
+ * first, since that's the part which can still fail (on a missing sprite,
+ * say), and then replace the world's. Snapshots from before agents were
+ * saved leave the world's agents alone.
+ */
+void mapSnapshot::restore() {
+	if (!staged)
+		stage();
+	shared_ptr<stagedState> st = staged;
+	staged.reset();
+
+	if (st->hasagents)
+		st->agents.build(); // throws, leaving the world alone
+
+	if (st->hasmap)
+		world.map.swap(st->map); // the old map goes away with st
+	if (st->hasscripts)
+		world.scriptorium = st->scriptorium;
+	if (st->hasworld) {
+		worldClock &c = st->clock;
+		world.ticktime = c.ticktime; world.tickcount = c.tickcount; world.worldtickcount = c.worldtickcount;
+		world.timeofday = c.timeofday; world.dayofseason = c.dayofseason; world.season = c.season; world.year = c.year;
+		world.variables.load(st->variables);
+	}
+	if (st->hasagents)
+		st->agents.restore();
+}
+
+bool mapSnapshot::supported() {
+	return true;
+}
+
+/*
+ * Compares save/load time and size of the binary and text archives, using
+ * the current world. Loading is done into scratch objects.
+ */
+std::string mapSnapshot::benchmark() {
+	std::ostringstream out;
+
+	for (unsigned int pass = 0; pass < 2; pass++) {
+		bool usetext = (pass == 1);
+		mapSnapshot s;
+
+		unsigned int start = engine.backend->ticks();
+		s.capture(usetext);
+		unsigned int savetime = engine.backend->ticks() - start;
+
+		Map map; Scriptorium scriptorium; std::map<std::string, caosVar> variables; worldClock c; agentSnapshot agents;
+		start = engine.backend->ticks();
+		for (std::map<std::string, std::string>::iterator i = s.sections.begin(); i != s.sections.end(); i++) {
+			std::istringstream in(i->second, std::ios::binary);
+			if (usetext) {
+				boost::archive::text_iarchive ia(in);
+				loadSection(ia, i->first, map, scriptorium, variables, c, agents);
+			} else {
+				boost::archive::binary_iarchive ia(in);
+				loadSection(ia, i->first, map, scriptorium, variables, c, agents);
+			}
+		}
+		unsigned int loadtime = engine.backend->ticks() - start;
+		map.Reset();
+
+		out << (usetext ? "text" : "binary") << ": save " << savetime << "ms, load " << loadtime << "ms, " << s.size() << " bytes (";
+		for (std::map<std::string, std::string>::iterator i = s.sections.begin(); i != s.sections.end(); i++) {
+			if (i != s.sections.begin()) out << ", ";
+			out << i->first << " " << i->second.size();
+		}
+		out << ")" << std::endl;
+	}
+
+	return out.str();
+}
+
+/* vim: set noet: */
@@ -18,6 +18,8 @@
  */
 
 #include "caosVM.h"
+#include "mapSnapshot.h"
+#include "exceptions.h"
 
 /**
  * SERS MAPP (command) filename (string)
@@ -65,3 +67,27 @@
 		VM_PARAM_STRING(filename)
 		STUB;
 	}
+
+void mapSnapshot::copyWorld() {
+	throw creaturesException("This build of openc2e does not have serialization support.");
+}
+
+void mapSnapshot::capture(bool textarchive) {
+	throw creaturesException("This build of openc2e does not have serialization support.");
+}
+
+void mapSnapshot::stage() {
+	throw creaturesException("This build of openc2e does not have serialization support.");
+}
+
+void mapSnapshot::restore() {
+	throw creaturesException("This build of openc2e does not have serialization support.");
+}
+
+std::string mapSnapshot::benchmark() {
+	return "This build of openc2e does not have serialization support.\n";
+}
+
+bool mapSnapshot::supported() {
+	return false;
+}
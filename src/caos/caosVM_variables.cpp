@@ -69,7 +69,7 @@ CAOS_LVALUE(VAxx,
  */
 CAOS_LVALUE_WITH(MVxx, owner,
 		VM_PARAM_INTEGER(index); caos_assert(index >= 0 && index < 100),
-		owner->var[index],
+		owner->var.get(index),
 		owner->var[index] = newvalue)
 
 /**
@@ -116,18 +116,22 @@ void caosVM::c_SETV() {
 	//VM_PARAM_DECIMAL(value)
 	VM_PARAM_VALUE(value)
 	VM_PARAM_VARIABLE(var)
-	var->reset();
+	setVariable(*var, value);
+}
+
+void caosVM::setVariable(caosVar &var, const caosVar &value) {
+	var.reset();
 	
 	// TODO: hackery for c2
 	if (value.hasAgent()) {
-		var->setAgent(value.getAgent());
+		var.setAgent(value.getAgent());
 		return;
 	} else caos_assert(value.hasDecimal());
 
 	if (value.hasFloat()) {
-		var->setFloat(value.getFloat());
+		var.setFloat(value.getFloat());
 	} else { // VM_PARAM_DECIMAL guarantees us float || int
-		var->setInt(value.getInt());
+		var.setInt(value.getInt());
 	}
 }
 
@@ -155,7 +159,7 @@ void caosVM::c_SETA() {
  */
 CAOS_LVALUE_TARG(OVxx, 
 		VM_PARAM_INTEGER(index); caos_assert(index >= 0 && index < 100),
-		targ->var[index],
+		targ->var.get(index),
 		targ->var[index] = newvalue)
 
 /**
@@ -270,14 +274,18 @@ void caosVM::c_ADDV() {
 	VM_VERIFY_SIZE(2)
 	VM_PARAM_DECIMAL(add)
 	VM_PARAM_VARIABLE(v)
-	if (v->hasFloat())
-		v->setFloat(v->getFloat() + (add.hasFloat() ? add.getFloat() : add.getInt()));
-	else if (v->hasInt())
-		v->setInt((int)(v->getInt() + (add.hasFloat() ? add.getFloat() : add.getInt())));
+	addVariable(*v, add);
+}
+
+void caosVM::addVariable(caosVar &v, const caosVar &add) {
+	if (v.hasFloat())
+		v.setFloat(v.getFloat() + (add.hasFloat() ? add.getFloat() : add.getInt()));
+	else if (v.hasInt())
+		v.setInt((int)(v.getInt() + (add.hasFloat() ? add.getFloat() : add.getInt())));
 	else if (add.hasFloat())
-		v->setFloat(add.getFloat()); // default back to zero
+		v.setFloat(add.getFloat()); // default back to zero
 	else
-		v->setInt(add.getInt()); // default back to zero
+		v.setInt(add.getInt()); // default back to zero
 }
 
 /**
@@ -607,7 +615,7 @@ CAOS_LVALUE(AVAR,
 		caos_assert(index >= 0 && index < 100);
 		valid_agent(agent)
 	,
-		agent->var[index]
+		agent->var.get(index)
 	,
 		agent->var[index] = newvalue
 )
@@ -978,18 +986,10 @@ void caosVM::v_GAMN() {
 
 	// TODO: we assume that GAME variables don't have an empty string
 	if (previous.empty()) {
-		if (world.variables.size() == 0)
-			result.setString("");
-		else
-			result.setString(world.variables.begin()->first);
+		result.setString(world.variables.first());
 	} else {
-		std::map<std::string, caosVar>::iterator i = world.variables.find(previous);
-		caos_assert(i != world.variables.end()); // TODO: this probably isn't correct behaviour
-		i++;
-		if (i == world.variables.end())
-			result.setString("");
-		else
-			result.setString(i->first);
+		caos_assert(world.variables.find(previous)); // TODO: this probably isn't correct behaviour
+		result.setString(world.variables.next(previous));
 	}
 }
 
@@ -100,7 +100,7 @@ void caosVM::c_GPAS() {
 	// TODO: see other GPAS below
 	// TODO: are we sure c2e grabs passengers by agent rect?
 	// TODO: do we need to check greedycabin attr for anything?
-	for (std::list<boost::shared_ptr<Agent> >::iterator i = world.agents.begin(); i != world.agents.end(); i++) {
+	for (agentRegistry::iterator i = world.agents.begin(); i != world.agents.end(); i++) {
 		boost::shared_ptr<Agent> a = (*i);
 		if (!a) continue;
 		if (a.get() == v) continue;
@@ -127,7 +127,7 @@ void caosVM::c_GPAS_c2() {
 
 	// TODO: are we sure c1/c2 grab passengers by agent rect?
 	// TODO: do we need to check greedycabin attr for anything?
-	for (std::list<boost::shared_ptr<Agent> >::iterator i = world.agents.begin(); i != world.agents.end(); i++) {
+	for (agentRegistry::iterator i = world.agents.begin(); i != world.agents.end(); i++) {
 		boost::shared_ptr<Agent> a = (*i);
 		if (!a) continue;
 		if (a.get() == v) continue;
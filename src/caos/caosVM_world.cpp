@@ -22,25 +22,37 @@
 
 /**
  LOAD (command) worldname (string)
- %status stub
+ %status maybe
+
+ Load the named world at the start of the next tick. The saved world is read
+ straight away, so this fails (leaving the world alone) if it's missing or
+ broken.
+
+ The map, scripts, game variables, clock, agents and genomes are all replaced.
+ Agents which can't be saved yet (creatures, and the C1/C2 lifts, call
+ buttons, blackboards and bubbles) are kept as they are, and loaded agents
+ start out idle, since running scripts aren't saved.
 */
 void caosVM::c_LOAD() {
 	VM_PARAM_STRING(worldname)
 
-	// TODO
+	world.requestLoad(worldname);
 }
 
 /**
  SAVE (command)
- %status stub
+ %status maybe
 
  Save the world at the start of the next tick. Beware; if you don't put this
  in an INST, it might save directly after your SAVE call (meaning upon loading,
  the script will execute the next instruction, often QUIT or LOAD, which is
  bad).
+
+ The map, scripts, game variables, clock, agents and their genomes are saved.
+ Creatures (and the C1/C2 lifts, call buttons, blackboards and bubbles) can't
+ be saved yet, and running scripts aren't saved, so loaded agents start idle.
 */
 void caosVM::c_SAVE() {
-	// note, world.saving doesn't mean anything yet
 	world.saving = true;
 }
 
@@ -0,0 +1,228 @@
+/*
+ *  caosAOT.cpp
+ *  openc2e
+ *
+ *  Created by the openc2e team on Mon Oct 19 2026.
+ *  Copyright (c) 2026 the openc2e team. All rights reserved.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ */
+
+#include "caosAOT.h"
+#include "cmddata.h"
+#include "dialect.h"
+#include "exceptions.h"
+#include "SDL.h" // SDL_LoadObject
+#include <map>
+#include <iostream>
+#include <boost/format.hpp>
+
+static std::map<unsigned int, const aotEntry *> nativescripts;
+
+// FNV-1a
+static void hashBytes(unsigned int &h, const void *data, unsigned int len) {
+	const unsigned char *p = (const unsigned char *)data;
+	for (unsigned int i = 0; i < len; i++) {
+		h ^= p[i];
+		h *= 16777619u;
+	}
+}
+
+static void hashString(unsigned int &h, const std::string &s) {
+	unsigned int len = s.size();
+	hashBytes(h, &len, sizeof(len));
+	hashBytes(h, s.data(), len);
+}
+
+static void hashInt(unsigned int &h, int i) {
+	hashBytes(h, &i, sizeof(i));
+}
+
+/*
+ * Commands are hashed by the name of their handler rather than by their index
+ * in the dialect's command table, since the generated code calls them by name
+ * and the indexes change whenever a command is added.
+ */
+unsigned int nativeScriptHash(const script &s) {
+	unsigned int h = 2166136261u;
+	hashString(h, s.dialect->name);
+	hashInt(h, s.varsNeeded());
+	for (int i = 0; i < s.scriptLength(); i++) {
+		caosOp op = s.getOp(i);
+		hashInt(h, op.opcode);
+		if (op.opcode == CAOS_CMD)
+			hashString(h, s.dialect->getcmd(op.argument)->implementation);
+		else if (op.opcode == CAOS_SAVE_CMD)
+			hashString(h, s.dialect->getcmd(op.argument)->saveimpl);
+		else
+			hashInt(h, op.argument);
+	}
+	for (unsigned int i = 0; i < s.consts.size(); i++)
+		hashString(h, s.consts[i].dump());
+	for (unsigned int i = 0; i < s.bytestrs.size(); i++) {
+		const bytestring_t &b = *s.bytestrs[i];
+		hashInt(h, b.size());
+		if (b.size())
+			hashBytes(h, &b[0], b.size());
+	}
+	return h;
+}
+
+/*
+ * Loads a module generated by DBG: AOTC. Modules are never unloaded, since
+ * scripts keep pointers into them.
+ */
+void loadNativeScripts(const std::string &filename) {
+	void *module = SDL_LoadObject(filename.c_str());
+	if (!module)
+		throw creaturesException(std::string("Couldn't load AOT module ") + filename + ": " + SDL_GetError());
+	aotModuleEntry entry = (aotModuleEntry)SDL_LoadFunction(module, "openc2e_aot_scripts");
+	if (!entry) {
+		SDL_UnloadObject(module);
+		throw creaturesException(std::string("AOT module ") + filename + " doesn't have any scripts in it");
+	}
+
+	unsigned int count, abi;
+	const aotEntry *e = entry(&count, &abi);
+	if (abi != nativeScriptABI()) {
+		SDL_UnloadObject(module);
+		throw creaturesException(std::string("AOT module ") + filename + " was built for a different version of openc2e");
+	}
+
+	for (unsigned int i = 0; i < count; i++)
+		nativescripts[e[i].hash] = &e[i];
+	std::cout << "* Loaded " << count << " natively compiled scripts from " << filename << std::endl;
+}
+
+nativeScript findNativeScript(const script &s) {
+	if (nativescripts.empty()) return 0;
+	std::map<unsigned int, const aotEntry *>::iterator i = nativescripts.find(nativeScriptHash(s));
+	if (i == nativescripts.end() || i->second->length != s.scriptLength())
+		return 0;
+	return i->second->run;
+}
+
+// "caosVM::c_TARG" -> "c_TARG"
+static std::string handlerName(const char *impl) {
+	std::string name = impl;
+	std::string::size_type colons = name.rfind("::");
+	if (colons != std::string::npos)
+		name.erase(0, colons + 2);
+	return name;
+}
+
+static bool validJump(const script &s, int dest) {
+	return dest >= 0 && dest < s.scriptLength();
+}
+
+static void writeOp(std::ostream &out, const script &s, int i) {
+	caosOp op = s.getOp(i);
+	int arg = op.argument; // boost::format can't take bitfields
+	int next = i + 1;
+	std::string carryon = boost::str(boost::format(" if (!aotCarryOn(vm, s, %d)) return;") % next);
+
+	out << boost::format("op_%d:\taotStep(vm, %d);") % i % i;
+	switch (op.opcode) {
+		case CAOS_NOP:
+			break;
+		case CAOS_STOP:
+			out << " vm->stop(); return;";
+			break;
+		case CAOS_CMD:
+			out << " vm->" << handlerName(s.dialect->getcmd(arg)->implementation) << "(); aotResult(vm);" << carryon;
+			break;
+		case CAOS_SAVE_CMD:
+			out << " vm->" << handlerName(s.dialect->getcmd(arg)->saveimpl) << "();" << carryon;
+			break;
+		case CAOS_YIELD:
+			out << boost::format(" if (!vm->inst) { vm->timeslice -= %d; if (vm->timeslice <= 0) return; }") % arg;
+			break;
+		case CAOS_CONSTINT:
+			out << boost::format(" vm->valueStack.push_back(vmStackItem(caosVar(%d)));") % arg;
+			break;
+		case CAOS_VAXX:
+			if (arg < 0 || arg >= 100) goto fallback;
+			out << boost::format(" vm->valueStack.push_back(vm->var[%d]);") % arg;
+			break;
+		case CAOS_SETV_VAXX_INT:
+			if (arg < 0 || arg >= 100) goto fallback;
+			out << boost::format(" VM_STACK_CHECK(vm); vm->var[%d].setInt(vm->valueStack.back().getInt()); vm->valueStack.pop_back();") % arg;
+			break;
+		case CAOS_ADDV_VAXX_INT:
+			if (arg < 0 || arg >= 100) goto fallback;
+			out << boost::format(" { VM_STACK_CHECK(vm); caosVar &v = vm->var[%d]; caos_assert(v.hasInt());"
+				" v.setInt(v.getInt() + vm->valueStack.back().getInt()); vm->valueStack.pop_back(); }") % arg;
+			break;
+		case CAOS_COND_INT:
+			out << boost::format(" aotCondInt(vm, %d);") % arg;
+			break;
+		case CAOS_JMP:
+			if (!validJump(s, arg)) goto fallback;
+			out << boost::format(" goto op_%d;") % arg;
+			break;
+		case CAOS_CJMP:
+			if (!validJump(s, arg)) goto fallback;
+			out << boost::format(" { VM_PARAM_VALUE(v) if (v.getInt() != 0) goto op_%d; }") % arg;
+			break;
+		case CAOS_CJMPZ:
+			if (!validJump(s, arg)) goto fallback;
+			out << boost::format(" { VM_PARAM_VALUE(v) if (v.getInt() == 0) goto op_%d; }") % arg;
+			break;
+		case CAOS_DECJNZ:
+			if (!validJump(s, arg)) goto fallback;
+			out << boost::format(" { VM_PARAM_INTEGER(counter) if (--counter) { vm->valueStack.push_back(caosVar(counter)); goto op_%d; } }") % arg;
+			break;
+		default:
+		fallback:
+			// everything else is rare enough to leave to the interpreter
+			out << boost::format(" vm->runOpAt(s, %d);") % i << carryon;
+			break;
+	}
+	out << "\n";
+}
+
+static void writeScript(std::ostream &out, const script &s, unsigned int n) {
+	out << boost::format("// %d %d %d %d, from %s\n") % s.fmly % s.gnus % s.spcs % s.scrp % s.filename;
+	out << boost::format("static void script_%d(caosVM *vm, script *s) {\n") % n;
+	out << "\tswitch (vm->nip) {\n";
+	for (int i = 0; i < s.scriptLength(); i++)
+		out << boost::format("\t\tcase %d: goto op_%d;\n") % i % i;
+	out << "\t\tdefault: return;\n";
+	out << "\t}\n\n";
+	for (int i = 0; i < s.scriptLength(); i++)
+		writeOp(out, s, i);
+	out << "\treturn;\n";
+	out << "}\n\n";
+}
+
+void writeNativeScripts(std::ostream &out, const std::vector<shared_ptr<script> > &scripts) {
+	out << "// natively compiled CAOS scripts, generated by openc2e's DBG: AOTC\n";
+	out << "// build as a shared library against the openc2e source and build trees, and load with --aot\n\n";
+	out << "#include \"caosAOT.h\"\n\n";
+
+	for (unsigned int i = 0; i < scripts.size(); i++)
+		writeScript(out, *scripts[i], i);
+
+	out << "static const aotEntry scripts[] = {\n";
+	for (unsigned int i = 0; i < scripts.size(); i++)
+		out << boost::format("\t{ 0x%08xu, %d, script_%d },\n") % nativeScriptHash(*scripts[i]) % scripts[i]->scriptLength() % i;
+	out << "\t{ 0, 0, 0 }\n";
+	out << "};\n\n";
+
+	out << "extern \"C\" const aotEntry *openc2e_aot_scripts(unsigned int *count, unsigned int *abi) {\n";
+	out << boost::format("\t*count = %d;\n") % scripts.size();
+	out << "\t*abi = nativeScriptABI();\n";
+	out << "\treturn scripts;\n";
+	out << "}\n";
+}
+
+/* vim: set noet: */
@@ -0,0 +1,105 @@
+/*
+ *  caosAOT.h
+ *  openc2e
+ *
+ *  Created by the openc2e team on Mon Oct 19 2026.
+ *  Copyright (c) 2026 the openc2e team. All rights reserved.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ */
+
+#ifndef _CAOSAOT_H
+#define _CAOSAOT_H
+
+#include "openc2e.h"
+#include "exceptions.h"
+#include "caosVM.h"
+#include "caosScript.h"
+#include "bytecode.h"
+#include <ostream>
+#include <string>
+#include <vector>
+
+/*
+ * Ahead-of-time compilation of hot scripts to native code.
+ *
+ * DBG: AOTC writes C++ for the hottest scripts (see DBG: PROF), with one
+ * function per script which calls the caosVM handlers directly instead of
+ * going through the interpreter's dispatch. That gets built as a shared
+ * library against this build of openc2e, and loaded at startup with --aot.
+ *
+ * Native scripts are found by a hash of their linked bytecode, so a script
+ * which has changed since the module was generated (or one which isn't in it)
+ * just keeps running in the interpreter.
+ *
+ * The generated code runs ops from the VM's nip, and returns to the
+ * interpreter loop whenever it would have something to check: after commands
+ * (which might block, stop or replace the script, or jump, as RETN does), when
+ * the timeslice runs out, and for the rarer ops, which it hands back to
+ * caosVM::runOpAt(). Jumps within the script are just gotos.
+ */
+
+// bump this whenever the generated code would need to change
+#define OPENC2E_AOT_VERSION 1
+
+struct aotEntry {
+	unsigned int hash; // see nativeScriptHash()
+	int length; // number of ops, as a check on the hash
+	nativeScript run;
+};
+
+// modules export this, as openc2e_aot_scripts
+typedef const aotEntry *(*aotModuleEntry)(unsigned int *count, unsigned int *abi);
+
+// modules must be built against the same caosVM and script as the engine
+static inline unsigned int nativeScriptABI() {
+	return (OPENC2E_AOT_VERSION << 24) ^ (sizeof(caosVM) << 12) ^ sizeof(script);
+}
+
+unsigned int nativeScriptHash(const script &s);
+void loadNativeScripts(const std::string &filename); // throws creaturesException
+nativeScript findNativeScript(const script &s);
+void writeNativeScripts(std::ostream &out, const std::vector<shared_ptr<script> > &scripts);
+
+// helpers for the generated code
+
+static inline void aotStep(caosVM *vm, int cip) {
+	vm->cip = cip;
+	vm->nip = cip + 1;
+	if (++vm->runops > 1000000) throw creaturesException("script exceeded 1m ops");
+}
+
+// whether the interpreter loop would carry on with the op at 'next'
+static inline bool aotCarryOn(caosVM *vm, script *s, int next) {
+	return vm->nip == next && vm->currentscript.get() == s && !vm->blocking
+		&& !vm->stop_loop && (vm->timeslice > 0 || vm->inst);
+}
+
+static inline void aotResult(caosVM *vm) {
+	if (!vm->result.isNull()) {
+		vm->valueStack.push_back(vm->result);
+		vm->result.reset();
+	}
+}
+
+static inline void aotCondInt(caosVM *vm, int flags) {
+	caos_assert(vm->valueStack.size() >= 3);
+	int top = vm->valueStack.size() - 1;
+	int result = int_condition(vm->valueStack[top - 2].getInt(),
+		vm->valueStack[top - 1].getInt(), vm->valueStack[top].getInt(), flags);
+	vm->valueStack.pop_back();
+	vm->valueStack.pop_back();
+	vm->valueStack.back() = vmStackItem(caosVar(result));
+}
+
+#endif
+/* vim: set noet: */
@@ -29,10 +29,12 @@
 #include "token.h"
 #include "dialect.h"
 #include "util.h"
+#include "caosAOT.h"
 #include <iostream>
 #include <sstream>
 #include <algorithm>
 #include <cstring>
+#include <climits>
 #include <boost/format.hpp>
 #include <boost/scoped_ptr.hpp>
 
@@ -60,11 +62,379 @@ void script::link() {
 		if (op_is_relocatable(ops[i].opcode) && ops[i].argument < 0)
 			ops[i].argument = relocations[-ops[i].argument];
 	}
+	optimise();
 	linked = true;
 //	std::cout << "Post-link:" << std::endl << dump();
 	relocations.clear();
 }
 
+// is op an invocation (or writeback, for CAOS_SAVE_CMD) of the given handler?
+static bool isCmd(const Dialect *d, caosOp op, opcode_t opcode, void (caosVM::*handler)()) {
+	if (op.opcode != opcode)
+		return false;
+#ifndef VCPP_BROKENNESS
+	const cmdinfo *ci = d->getcmd(op.argument);
+	return (opcode == CAOS_SAVE_CMD ? ci->savehandler : ci->handler) == handler;
+#else
+	return false;
+#endif
+}
+
+// commands which only exist to mark flow control and do nothing when run
+static bool isNoopCmd(const Dialect *d, caosOp op) {
+	return isCmd(d, op, CAOS_CMD, &caosVM::c_DOIF)
+		|| isCmd(d, op, CAOS_CMD, &caosVM::c_ELIF)
+		|| isCmd(d, op, CAOS_CMD, &caosVM::c_ELSE)
+		|| isCmd(d, op, CAOS_CMD, &caosVM::c_ENDI)
+		|| isCmd(d, op, CAOS_CMD, &caosVM::c_LOOP)
+		|| isCmd(d, op, CAOS_CMD, &caosVM::c_UNTL)
+		|| isCmd(d, op, CAOS_CMD, &caosVM::c_REPE);
+}
+
+// peephole-optimise the linked bytecode, until there's nothing left to do
+void script::optimise() {
+	assert(!linked);
+	unoptimisedlength = ops.size();
+	while (optimisePass())
+		;
+	specialiseTypes();
+}
+
+/*
+ * One left-to-right pass over the bytecode, returning whether it shrank.
+ *
+ * This only folds the obvious things the compiler emits: constant
+ * conditions, VAxx reads and SETV/ADDV of VAxx with a simple value, the
+ * no-op flow control commands and the CJMP/JMP pairs around DOIF and UNTL.
+ * Ops which something jumps to are never folded into the op before them,
+ * and the jump addresses are fixed up afterwards.
+ */
+bool script::optimisePass() {
+	unsigned int n = ops.size();
+	std::vector<bool> target(n + 1, false);
+	for (unsigned int i = 0; i < n; i++) {
+		int arg = ops[i].argument;
+		if (op_is_relocatable(ops[i].opcode) && arg >= 0 && (unsigned int)arg <= n)
+			target[arg] = true;
+	}
+
+	std::vector<caosOp> out;
+	std::vector<int> newaddr(n + 1, 0);
+	out.push_back(ops[0]); // reserved NOP
+	unsigned int i = 1;
+	while (i < n) {
+		unsigned int start = out.size();
+		unsigned int len = 1;
+		// how many ops from i are available to fold together
+		unsigned int avail = 1;
+		while (i + avail < n && avail < 7 && !target[i + avail])
+			avail++;
+
+		caosOp op = ops[i];
+		opcode_t next = avail >= 2 ? ops[i + 1].opcode : CAOS_INVALID;
+
+		if (avail >= 7 && op.opcode == CAOS_CONSTINT
+				&& ops[i + 1].opcode == CAOS_PUSH_AUX && ops[i + 1].argument == 0
+				&& isCmd(dialect, ops[i + 2], CAOS_CMD, &caosVM::v_VAxx)
+				&& (ops[i + 3].opcode == CAOS_CONSTINT || ops[i + 3].opcode == CAOS_CONST
+					|| ops[i + 3].opcode == CAOS_VAXX || ops[i + 3].opcode == CAOS_GAMEVAR)
+				&& (isCmd(dialect, ops[i + 4], CAOS_CMD, &caosVM::c_SETV)
+					|| isCmd(dialect, ops[i + 4], CAOS_CMD, &caosVM::c_ADDV))
+				&& ops[i + 5].opcode == CAOS_RESTORE_AUX && ops[i + 5].argument == 1
+				&& isCmd(dialect, ops[i + 6], CAOS_SAVE_CMD, &caosVM::s_VAxx)) {
+			// SETV/ADDV VAxx <simple value>
+			bool setv = isCmd(dialect, ops[i + 4], CAOS_CMD, &caosVM::c_SETV);
+			out.push_back(ops[i + 3]);
+			out.push_back(caosOp(setv ? CAOS_SETV_VAXX : CAOS_ADDV_VAXX, op.argument, ops[i + 4].traceindex));
+			len = 7;
+		} else if (op.opcode == CAOS_CONSTINT && next == CAOS_CMD
+				&& isCmd(dialect, ops[i + 1], CAOS_CMD, &caosVM::v_VAxx)) {
+			out.push_back(caosOp(CAOS_VAXX, op.argument, ops[i + 1].traceindex));
+			len = 2;
+		} else if (avail >= 4 && op.opcode == CAOS_CONSTINT
+				&& ops[i + 1].opcode == CAOS_CONSTINT && ops[i + 2].opcode == CAOS_CONSTINT
+				&& ops[i + 3].opcode == CAOS_COND) {
+			int r = int_condition(op.argument, ops[i + 1].argument, ops[i + 2].argument, ops[i + 3].argument);
+			out.push_back(caosOp(CAOS_CONSTINT, r, ops[i + 3].traceindex));
+			len = 4;
+		} else if (op.opcode == CAOS_CONSTINT && (next == CAOS_CJMP || next == CAOS_CJMPZ)) {
+			// a branch on a constant either always or never happens
+			bool taken = (op.argument != 0) == (next == CAOS_CJMP);
+			if (taken)
+				out.push_back(caosOp(CAOS_JMP, ops[i + 1].argument, ops[i + 1].traceindex));
+			len = 2;
+		} else if (op.opcode == CAOS_CJMP && next == CAOS_JMP
+				&& op.argument == (int)(i + 2)) {
+			// CJMP over a JMP, as DOIF and UNTL compile to
+			out.push_back(caosOp(CAOS_CJMPZ, ops[i + 1].argument, op.traceindex));
+			len = 2;
+		} else if (op.opcode == CAOS_JMP && op.argument == (int)(i + 1)) {
+			// jump to the next op; drop it
+		} else if (isNoopCmd(dialect, op)) {
+			// drop it; any cost it has is a separate YIELD
+		} else {
+			out.push_back(op);
+		}
+
+		for (unsigned int j = i; j < i + len; j++)
+			newaddr[j] = start;
+		i += len;
+	}
+	newaddr[n] = out.size();
+
+	for (unsigned int j = 0; j < out.size(); j++) {
+		int arg = out[j].argument;
+		if (op_is_relocatable(out[j].opcode) && arg >= 0 && (unsigned int)arg <= n)
+			out[j].argument = newaddr[arg];
+	}
+
+	bool shrunk = out.size() < n;
+	ops.swap(out);
+	return shrunk;
+}
+
+// what the type inference knows about a value
+enum valueType { VT_UNKNOWN = 0, VT_INT, VT_FLOAT };
+
+/*
+ * The types of the value stack and of the VAxx variables at some point in
+ * a script. Only the top of the stack is tracked; anything below the
+ * bottom of 'stack' is unknown.
+ */
+struct typeState {
+	bool reached;
+	std::vector<valueType> stack;
+	valueType vars[100];
+
+	typeState() : reached(false) { forgetVars(); }
+
+	void forgetVars() {
+		for (int i = 0; i < 100; i++)
+			vars[i] = VT_UNKNOWN;
+	}
+
+	valueType top(unsigned int depth = 0) const {
+		return depth < stack.size() ? stack[stack.size() - depth - 1] : VT_UNKNOWN;
+	}
+
+	valueType pop() {
+		valueType t = top();
+		if (!stack.empty())
+			stack.pop_back();
+		return t;
+	}
+
+	void push(valueType t) { stack.push_back(t); }
+
+	// combine with the state along another path; returns whether we changed
+	bool merge(const typeState &o) {
+		if (!reached) {
+			*this = o;
+			return true;
+		}
+		bool changed = false;
+		if (o.stack.size() < stack.size()) {
+			stack.erase(stack.begin(), stack.begin() + (stack.size() - o.stack.size()));
+			changed = true;
+		}
+		unsigned int skip = o.stack.size() - stack.size();
+		for (unsigned int i = 0; i < stack.size(); i++) {
+			if (stack[i] != VT_UNKNOWN && stack[i] != o.stack[i + skip]) {
+				stack[i] = VT_UNKNOWN;
+				changed = true;
+			}
+		}
+		for (int i = 0; i < 100; i++) {
+			if (vars[i] != VT_UNKNOWN && vars[i] != o.vars[i]) {
+				vars[i] = VT_UNKNOWN;
+				changed = true;
+			}
+		}
+		return changed;
+	}
+};
+
+/*
+ * Work out which values are always integers, and use the typed ops (which
+ * don't need to check or convert anything) for those. This is a forward
+ * dataflow pass over the linked bytecode; the only sources of known types
+ * are constants, conditions and SETV/ADDV of VAxx, since nothing else
+ * promises what type it returns. Ops are replaced one-for-one, so no
+ * addresses change.
+ */
+void script::specialiseTypes() {
+	unsigned int n = ops.size();
+	std::vector<typeState> in(n);
+	std::vector<unsigned int> work;
+	in[0].reached = true;
+	work.push_back(0);
+
+	while (!work.empty()) {
+		unsigned int i = work.back();
+		work.pop_back();
+		typeState st = in[i];
+		caosOp op = ops[i];
+		int arg = op.argument;
+		// where control can go from here, and the state it gets there with
+		std::vector<std::pair<unsigned int, typeState> > succ;
+		bool fallthrough = true;
+
+		switch (op.opcode) {
+			case CAOS_DIE:
+			case CAOS_STOP:
+				fallthrough = false;
+				break;
+			case CAOS_CMD:
+			case CAOS_SAVE_CMD:
+				{
+					const cmdinfo *ci = dialect->getcmd(arg);
+					int delta = ci->stackdelta - (op.opcode == CAOS_SAVE_CMD ? 2 : 0);
+					if (ci->stackdelta >= INT_MAX - 1) {
+						st.stack.clear();
+					} else {
+						// the arguments come off, and whatever's left goes on
+						// (lvalues and the result) is unknown
+						int pops = 0;
+						while (ci->argtypes[pops] != CI_END)
+							pops++;
+						if (op.opcode == CAOS_SAVE_CMD)
+							pops++; // the new value
+						int pushes = pops + delta;
+						if (pushes < 0) {
+							pops -= pushes;
+							pushes = 0;
+						}
+						for (int j = 0; j < pops; j++)
+							st.pop();
+						for (int j = 0; j < pushes; j++)
+							st.push(VT_UNKNOWN);
+					}
+					// VAxx is only written by s_VAxx, and we don't know which
+					if (isCmd(dialect, op, CAOS_SAVE_CMD, &caosVM::s_VAxx))
+						st.forgetVars();
+					break;
+				}
+			case CAOS_COND:
+			case CAOS_COND_INT:
+				st.pop(); st.pop(); st.pop();
+				st.push(VT_INT);
+				break;
+			case CAOS_CONST:
+				{
+					const caosVar &v = getConstant(arg);
+					st.push(v.hasInt() ? VT_INT : v.hasFloat() ? VT_FLOAT : VT_UNKNOWN);
+					break;
+				}
+			case CAOS_CONSTINT:
+				st.push(VT_INT);
+				break;
+			case CAOS_BYTESTR:
+			case CAOS_GAMEVAR:
+				st.push(VT_UNKNOWN);
+				break;
+			case CAOS_SAVE_GAMEVAR:
+				st.pop();
+				break;
+			case CAOS_RESTORE_AUX:
+				for (int j = 0; j < arg; j++)
+					st.push(VT_UNKNOWN);
+				break;
+			case CAOS_STACK_ROT:
+				{
+					valueType t = st.pop();
+					std::vector<valueType> under;
+					for (int j = 0; j < arg; j++)
+						under.push_back(st.pop());
+					st.push(t);
+					for (int j = arg - 1; j >= 0; j--)
+						st.push(under[j]);
+					break;
+				}
+			case CAOS_VAXX:
+				st.push(arg >= 0 && arg < 100 ? st.vars[arg] : VT_UNKNOWN);
+				break;
+			case CAOS_SETV_VAXX:
+			case CAOS_SETV_VAXX_INT:
+				{
+					valueType t = st.pop();
+					if (arg >= 0 && arg < 100)
+						st.vars[arg] = t;
+					break;
+				}
+			case CAOS_ADDV_VAXX:
+			case CAOS_ADDV_VAXX_INT:
+				// see caosVM::addVariable: a numeric variable keeps its type,
+				// and we can't say anything about any other
+				st.pop();
+				break;
+			case CAOS_CJMP:
+			case CAOS_CJMPZ:
+			case CAOS_ENUMPOP:
+				st.pop();
+				succ.push_back(std::make_pair((unsigned int)arg, st));
+				break;
+			case CAOS_JMP:
+				succ.push_back(std::make_pair((unsigned int)arg, st));
+				fallthrough = false;
+				break;
+			case CAOS_DECJNZ:
+				{
+					st.pop();
+					typeState taken = st;
+					taken.push(VT_INT);
+					succ.push_back(std::make_pair((unsigned int)arg, taken));
+					break;
+				}
+			case CAOS_GSUB:
+				{
+					// the subroutine starts with an empty stack, and may
+					// change any variable before it returns here
+					typeState sub = st;
+					sub.stack.clear();
+					succ.push_back(std::make_pair((unsigned int)arg, sub));
+					st.forgetVars();
+					break;
+				}
+			default:
+				break;
+		}
+		if (fallthrough)
+			succ.push_back(std::make_pair(i + 1, st));
+
+		for (unsigned int j = 0; j < succ.size(); j++) {
+			unsigned int to = succ[j].first;
+			if (to >= n)
+				continue;
+			succ[j].second.reached = true;
+			if (in[to].merge(succ[j].second))
+				work.push_back(to);
+		}
+	}
+
+	for (unsigned int i = 0; i < n; i++) {
+		const typeState &st = in[i];
+		if (!st.reached)
+			continue;
+		caosOp &op = ops[i];
+		switch (op.opcode) {
+			case CAOS_COND:
+				if (st.top(0) == VT_INT && st.top(1) == VT_INT && st.top(2) == VT_INT)
+					op.opcode = CAOS_COND_INT;
+				break;
+			case CAOS_SETV_VAXX:
+				if (st.top() == VT_INT)
+					op.opcode = CAOS_SETV_VAXX_INT;
+				break;
+			case CAOS_ADDV_VAXX:
+				if (st.top() == VT_INT && st.vars[op.argument] == VT_INT)
+					op.opcode = CAOS_ADDV_VAXX_INT;
+				break;
+			default:
+				break;
+		}
+	}
+}
+
 script::script(const Dialect *v, const std::string &fn)
 	: fmly(-1), gnus(-1), spcs(-1), scrp(-1),
 		dialect(v), filename(fn)
@@ -75,6 +445,11 @@ script::script(const Dialect *v, const std::string &fn)
 	memset(varRemap, 0xFF, 100);
 	varUsed = 0;
 	linked = false;
+	unoptimisedlength = 0;
+	profruns = 0;
+	profops = 0;
+	native = 0;
+	nativechecked = false;
 }
 	
 script::script(const Dialect *v, const std::string &fn,
@@ -87,10 +462,18 @@ script::script(const Dialect *v, const std::string &fn,
 	memset(varRemap, 0xFF, 100);
 	varUsed = 0;
 	linked = false;
+	unoptimisedlength = 0;
+	profruns = 0;
+	profops = 0;
+	native = 0;
+	nativechecked = false;
 }
 
 std::string script::dump() {
 	std::ostringstream oss;
+	if (unoptimisedlength)
+		oss << boost::format("Ops: %d (%d before optimisation)") % ops.size() % unoptimisedlength
+			<< std::endl;
 	oss << "Relocations:" << std::endl;
 	for (unsigned int i = 1; i < relocations.size(); i++) {
 		oss << boost::format("%08d -> %08d") % i % relocations[i]
@@ -110,6 +493,7 @@ caosScript::caosScript(const std::string &dialect, const std::string &fn) {
 	d = dialects[dialect].get();
 	if (!d)
 		throw parseException(std::string("Unknown dialect ") + dialect);
+	gamecmd = d->find_command("expr game");
 	current = installer = shared_ptr<script> (new script(d, fn));
 	filename = fn;
 }
@@ -148,6 +532,11 @@ void saveVisit::operator()(const CAOSCmd &cmd) const {
 	if (cmd.op->rettype != CI_VARIABLE) {
 		throw parseException(std::string("RValue ") + cmd.op->fullname + " used where LValue expected");
 	}
+	int gameconst = scr->literalGameVar(cmd);
+	if (gameconst != -1) {
+		scr->emitOp(CAOS_SAVE_GAMEVAR, gameconst);
+		return;
+	}
 	scr->emitOp(CAOS_RESTORE_AUX, cmd.arguments.size());
 	scr->emitOp(CAOS_SAVE_CMD, scr->d->cmd_index(cmd.op));
 }
@@ -159,6 +548,14 @@ evalVisit::evalVisit(caosScript *s, bool save_here_)
 
 
 void evalVisit::operator()(const CAOSCmd &cmd) const {
+	int gameconst = scr->literalGameVar(cmd);
+	if (gameconst != -1) {
+		// there are no arguments on the stack, so nothing to stash for saving
+		scr->traceindex = cmd.traceidx - 1;
+		scr->emitOp(CAOS_GAMEVAR, gameconst);
+		return;
+	}
+
 	for (size_t i = 0; i < cmd.arguments.size(); i++) {
 		bool save_there = (cmd.op->argtypes[i] == CI_VARIABLE);
 		cmd.arguments[i]->eval(scr, save_there);
@@ -210,8 +607,40 @@ void caosScript::emitConst(const caosVar &v) {
 	emitOp(CAOS_CONST, current->consts.size() - 1);
 }
 
+/*
+ * GAME with a literal name skips the command entirely and accesses the
+ * variable by slot; returns the index of the name in the constants table,
+ * or -1 if this isn't such a GAME.
+ */
+int caosScript::literalGameVar(const CAOSCmd &cmd) {
+	if (cmd.op != gamecmd || cmd.arguments.size() != 1)
+		return -1;
+	const caosVar *name = boost::get<caosVar>(&cmd.arguments[0]->value);
+	if (!name || !name->hasString())
+		return -1;
+	current->consts.push_back(*name);
+	return current->consts.size() - 1;
+}
+
+unsigned int script::getGameSlot(int idx) {
+	if (gameslots.size() != consts.size())
+		gameslots.resize(consts.size(), -1);
+	const caosVar &name = getConstant(idx); // range check
+	if (gameslots[idx] == -1)
+		gameslots[idx] = world.variables.slot(name.getString());
+	return gameslots[idx];
+}
+
+nativeScript script::getNative() {
+	if (!nativechecked) {
+		native = findNativeScript(*this);
+		nativechecked = true;
+	}
+	return native;
+}
+
 void evalVisit::operator()(const bytestring_t &bs) const {
-	scr->current->bytestrs.push_back(bs);
+	scr->current->bytestrs.push_back(shared_ptr<bytestring_t>(new bytestring_t(bs)));
 	scr->emitOp(CAOS_BYTESTR, scr->current->bytestrs.size() - 1);
 }
 
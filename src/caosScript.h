@@ -36,6 +36,10 @@
 
 
 class Agent;
+struct script;
+
+// a script compiled ahead of time into native code (see caosAOT.h)
+typedef void (*nativeScript)(class caosVM *vm, script *s);
 
 struct toktrace {
 	unsigned short width;
@@ -63,9 +67,20 @@ struct script {
 			memset(varRemap, 0xFF, 100);
 			varUsed = 0;
 			linked = false;
+			unoptimisedlength = 0;
+			profruns = 0;
+			profops = 0;
+			native = 0;
+			nativechecked = false;
 		}
 		// remapping array for VAxx
 		unsigned char varRemap[100], varUsed;
+		// number of ops before optimise() ran, for dump(); 0 if unknown
+		int unoptimisedlength;
+
+		void optimise();
+		bool optimisePass();
+		void specialiseTypes();
 	public:
 		// ops[0] is initted to a nop, as address 0 is reserved for a flag value
 		// in the relocation vector
@@ -75,8 +90,11 @@ struct script {
 		// mostly for strings and floats
 		std::vector<caosVar> consts;
 		// because caosVar doesn't store bytestrings, we store them in a separate
-		// table
-		std::vector<bytestring_t> bytestrs;
+		// table; they're shared with the VM stack when pushed
+		std::vector<shared_ptr<bytestring_t> > bytestrs;
+		// GAME variable slots for the string constants used by CAOS_GAMEVAR,
+		// filled in as they're first used (-1 until then); not serialised
+		std::vector<int> gameslots;
 		// a normalized copy of the script source. this is used for error tracing
 		shared_str code;
 		shared_ptr<std::vector<toktrace> > tokinfo;
@@ -87,6 +105,17 @@ struct script {
 		
 		std::string filename;
 
+		// how often this script has been started, and how many ops it has
+		// run, for DBG: PROF; not serialised
+		unsigned int profruns;
+		unsigned long profops;
+
+		// the natively compiled version of this script from an AOT module, if
+		// there is one; looked up the first time it's needed, not serialised
+		nativeScript native;
+		bool nativechecked;
+		nativeScript getNative();
+
 		caosOp getOp(int idx) const {
 			assert (idx >= 0);
 			return (size_t)idx >= ops.size() ? caosOp(CAOS_DIE, -1, -1) : ops[idx];
@@ -96,7 +125,7 @@ struct script {
 			return ops.size();
 		}
 
-		caosVar getConstant(int idx) const {
+		const caosVar &getConstant(int idx) const {
 			if (idx < 0 || (size_t)idx >= consts.size()) {
 				throw caosException(boost::str(
 						boost::format("Internal error: const %d out of range") % idx
@@ -105,7 +134,9 @@ struct script {
 			return consts[idx];
 		}
 
-		bytestring_t getBytestr(int idx) const {
+		unsigned int getGameSlot(int idx);
+
+		const shared_ptr<bytestring_t> &getBytestr(int idx) const {
 			if (idx < 0 || (size_t)idx >= bytestrs.size()) {
 				throw caosException(boost::str(
 						boost::format("Internal error: const %d out of range") % idx
@@ -240,13 +271,14 @@ struct evalVisit : public boost::static_visitor<void> {
 class caosScript { //: Collectable {
 public:
 	const Dialect *d;
+	const cmdinfo *gamecmd; // GAME, if this dialect has it
 	std::string filename;
 	shared_ptr<script> installer, removal;
 	std::vector<shared_ptr<script> > scripts;
 	shared_ptr<script> current;
 
 	caosScript(const std::string &dialect, const std::string &fn);
-	caosScript() { d = NULL; }
+	caosScript() { d = NULL; gamecmd = NULL; }
 	void parse(std::istream &in);
 	~caosScript();
 	void installScripts();
@@ -257,6 +289,7 @@ protected:
 	void emitOp(opcode_t op, int argument);
 	void emitCmd(const char *name);
 	void emitConst(const caosVar &);
+	int literalGameVar(const CAOSCmd &cmd);
 	boost::shared_ptr<CAOSExpression> readExpr(const enum ci_type xtype);
 	void emitExpr(boost::shared_ptr<CAOSExpression> ce);
 	const cmdinfo *readCommand(class token *t, const std::string &prefix, bool except = true);
@@ -248,6 +248,66 @@ inline void caosVM::runOpCore(script *s, caosOp op) {
 				}
 				break;
 			}
+		case CAOS_GAMEVAR:
+			{
+				valueStack.push_back(vmStackItem(world.variables.get(s->getGameSlot(op.argument))));
+				break;
+			}
+		case CAOS_SAVE_GAMEVAR:
+			{
+				VM_PARAM_VALUE(v);
+				world.variables.get(s->getGameSlot(op.argument)) = v;
+				break;
+			}
+		case CAOS_VAXX:
+			{
+				caos_assert(op.argument >= 0 && op.argument < 100);
+				valueStack.push_back(var[op.argument]);
+				break;
+			}
+		case CAOS_SETV_VAXX:
+			{
+				caos_assert(op.argument >= 0 && op.argument < 100);
+				VM_PARAM_VALUE(value);
+				setVariable(var[op.argument], value);
+				break;
+			}
+		case CAOS_ADDV_VAXX:
+			{
+				caos_assert(op.argument >= 0 && op.argument < 100);
+				VM_PARAM_DECIMAL(add);
+				addVariable(var[op.argument], add);
+				break;
+			}
+		case CAOS_COND_INT:
+			{
+				caos_assert(valueStack.size() >= 3);
+				int top = valueStack.size() - 1;
+				int result = int_condition(valueStack[top - 2].getInt(),
+					valueStack[top - 1].getInt(), valueStack[top].getInt(), op.argument);
+				valueStack.pop_back();
+				valueStack.pop_back();
+				valueStack.back() = vmStackItem(caosVar(result));
+				break;
+			}
+		case CAOS_SETV_VAXX_INT:
+			{
+				caos_assert(op.argument >= 0 && op.argument < 100);
+				VM_STACK_CHECK(vm);
+				var[op.argument].setInt(valueStack.back().getInt());
+				valueStack.pop_back();
+				break;
+			}
+		case CAOS_ADDV_VAXX_INT:
+			{
+				caos_assert(op.argument >= 0 && op.argument < 100);
+				VM_STACK_CHECK(vm);
+				caosVar &v = var[op.argument];
+				caos_assert(v.hasInt());
+				v.setInt(v.getInt() + valueStack.back().getInt());
+				valueStack.pop_back();
+				break;
+			}
 		case CAOS_CJMP:
 			{
 				VM_PARAM_VALUE(v);
@@ -255,6 +315,13 @@ inline void caosVM::runOpCore(script *s, caosOp op) {
 					safeJMP(op.argument);
 				break;
 			}
+		case CAOS_CJMPZ:
+			{
+				VM_PARAM_VALUE(v);
+				if (v.getInt() == 0)
+					safeJMP(op.argument);
+				break;
+			}
 		case CAOS_JMP:
 			{
 				safeJMP(op.argument);
@@ -303,8 +370,11 @@ inline void caosVM::runOp() {
 	runops++;
 	if (runops > 1000000) throw creaturesException("script exceeded 1m ops");
 
-	shared_ptr<script> scr = currentscript;
-	caosOp op = currentscript->getOp(cip);
+	// our callers hold a reference to the script, so that it survives
+	// the op stopping or replacing it without us taking one on every op
+	script *scr = currentscript.get();
+	scr->profops++;
+	caosOp op = scr->getOp(cip);
 	
 	try {
 		if (trace) {
@@ -315,7 +385,7 @@ inline void caosVM::runOp() {
 				dumpStack(this);
 			}
 		}
-		runOpCore(scr.get(), op);
+		runOpCore(scr, op);
 	} catch (caosException &e) {
 		e.trace(currentscript, op.traceindex);
 		stop();
@@ -327,6 +397,34 @@ inline void caosVM::runOp() {
 	
 }
 
+void caosVM::runOpAt(script *s, int idx) {
+	runOpCore(s, s->getOp(idx));
+}
+
+/*
+ * Runs ops from nip with the script's natively compiled code, which returns
+ * whenever the interpreter loop would need to look at things (blocking, the
+ * timeslice running out, the script changing, or a jump it can't follow).
+ */
+void caosVM::runNative(script *s) {
+	int before = runops;
+	try {
+		s->native(this, s);
+	} catch (caosException &e) {
+		e.trace(currentscript, s->getOp(cip).traceindex);
+		stop();
+		throw;
+	} catch (creaturesException &e) {
+		stop();
+		throw;
+	}
+	s->profops += runops - before;
+
+	// if it couldn't start at nip (eg, past the end), let the interpreter deal with it
+	if (runops == before)
+		runOp();
+}
+
 void caosVM::stop() {
 	lock = false;
 	currentscript.reset();
@@ -338,9 +436,18 @@ void caosVM::runEntirely(shared_ptr<script> s) {
 	cip = nip = runops = 0;
 	currentscript = s;
 	var.ensure(currentscript->varsNeeded());
+	s->profruns++;
 
+	nativeScript native = s->getNative();
 	while (true) {
-		runOp();
+		if (s != currentscript) {
+			s = currentscript; // see tick()
+			native = s->getNative();
+		}
+		if (native && !trace)
+			runNative(s.get());
+		else
+			runOp();
 		if (!currentscript) break;
 		if (blocking) {
 			delete blocking;
@@ -359,6 +466,7 @@ bool caosVM::fireScript(shared_ptr<script> s, bool nointerrupt, Agent *frm) {
 	resetScriptState();
 	currentscript = s;
 	var.ensure(currentscript->varsNeeded());
+	s->profruns++;
 	targ = owner;
 	from.setAgent(frm);
 	timeslice = 1;
@@ -405,9 +513,18 @@ void caosVM::resetCore() {
 void caosVM::tick() {
 	stop_loop = false;
 	runops = 0;
+	shared_ptr<script> scr; // keeps the running script alive for runOp
+	nativeScript native = 0;
 	while (currentscript && !stop_loop && (timeslice > 0 || inst)) {
 		if (isBlocking()) return;
-		runOp();
+		if (scr != currentscript) {
+			scr = currentscript;
+			native = scr->getNative();
+		}
+		if (native && !trace)
+			runNative(scr.get());
+		else
+			runOp();
 	}
 }
 
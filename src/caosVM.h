@@ -62,10 +62,10 @@ class vmStackItem {
 				return std::string("ptr ") + i->dump();
 			}
 
-			std::string operator()(const bytestring_t &bs) const {
+			std::string operator()(const shared_ptr<const bytestring_t> &bs) const {
 				std::ostringstream oss;
 				oss << "[ ";
-				for (bytestring_t::const_iterator i = bs.begin(); i != bs.end(); i++) {
+				for (bytestring_t::const_iterator i = bs->begin(); i != bs->end(); i++) {
 					oss << (int)*i << " ";
 				}
 				oss << "]";
@@ -83,25 +83,26 @@ class vmStackItem {
 				return *i;
 			}
 
-			const caosVar &operator()(const bytestring_t &) const {
+			const caosVar &operator()(const shared_ptr<const bytestring_t> &) const {
 				throw badParamException();
 			}
 				
 		};
 
-		struct visit_bs : public boost::static_visitor<bytestring_t> {
-			bytestring_t operator()(const bytestring_t &i) const {
+		struct visit_bs : public boost::static_visitor<const shared_ptr<const bytestring_t> &> {
+			const shared_ptr<const bytestring_t> &operator()(const shared_ptr<const bytestring_t> &i) const {
 				return i;
 			}
-			bytestring_t operator()(caosVar *i) const {
+			const shared_ptr<const bytestring_t> &operator()(caosVar *i) const {
 				throw badParamException();
 			}
-			bytestring_t operator()(const caosVar &i) const {
+			const shared_ptr<const bytestring_t> &operator()(const caosVar &i) const {
 				throw badParamException();
 			}
 		};
 				
-		boost::variant<caosVar, bytestring_t> value;
+		// bytestrings are shared with the script they're a constant of
+		boost::variant<caosVar, shared_ptr<const bytestring_t> > value;
 
 	public:
 
@@ -109,7 +110,7 @@ class vmStackItem {
 			value = v;
 		}
 
-		vmStackItem(bytestring_t bs) {
+		vmStackItem(const shared_ptr<const bytestring_t> &bs) {
 			value = bs;
 		}
 
@@ -125,7 +126,16 @@ class vmStackItem {
 			}
 		}
 
-		bytestring_t getByteStr() const {
+		// for operands the compiler has proven to be integers; unlike
+		// VM_PARAM_INTEGER, this doesn't copy the stack item
+		int getInt() const {
+			const caosVar *v = boost::get<caosVar>(&value);
+			if (!v || !v->hasInt())
+				throw badParamException();
+			return v->getInt();
+		}
+
+		const shared_ptr<const bytestring_t> &getByteStr() const {
 			try {
 				return boost::apply_visitor(visit_bs(), value);
 			} catch (boost::bad_visit &e) {
@@ -335,6 +345,8 @@ public:
 	void v_LOFT();
 	void c_BKGD();
 	void v_BKGD();
+	void c_CMRD();
+	void v_CMRD();
 	void c_FRSH();
 	void c_SYS_CMRP();
 	void c_SYS_CMRA();
@@ -382,6 +394,9 @@ public:
 	void c_SYS_CMND();
 
 	// variables
+	// the bodies of SETV and ADDV, shared with their fused bytecode ops
+	void setVariable(caosVar &var, const caosVar &value);
+	void addVariable(caosVar &v, const caosVar &add);
 	void c_SETV();
 	void v_RAND();
 	void c_REAF();
@@ -490,10 +505,15 @@ public:
 	void v_DBG_IDNT();
 	void c_DBG_PROF();
 	void c_DBG_CPRO();
+	void c_DBG_AOTC();
 	void v_DBG_STOK();
 	void c_DBG_TSLC();
 	void v_DBG_TSLC();
+	void c_DBG_BUDG();
+	void v_DBG_BUDG();
+	void v_DBG_SOUN();
 	void v_DBG_SIZO();
+	void v_DBG_SNAP();
 
 	// agent
 	void c_NEW_COMP();
@@ -1099,7 +1119,9 @@ public:
 	void safeJMP(int nip);
 	void invoke_cmd(script *s, bool is_saver, int opidx);
 	void runOpCore(script *s, struct caosOp op);
+	void runOpAt(script *s, int idx); // for AOT-compiled code
 	void runOp();
+	void runNative(script *s);
 	void runEntirely(shared_ptr<script> s);
 
 	void tick();
@@ -1150,27 +1172,28 @@ class caosVM__lval {
 };
 
 #define VM_PARAM_VALUE(name) caosVar name; { VM_STACK_CHECK(vm); \
-	vmStackItem __x = vm->valueStack.back(); \
+	const vmStackItem &__x = vm->valueStack.back(); \
 	name = __x.getRVal(); } vm->valueStack.pop_back();
-#define VM_PARAM_STRING(name) std::string name; { VM_STACK_CHECK(vm); vmStackItem __x = vm->valueStack.back(); \
+#define VM_PARAM_STRING(name) std::string name; { VM_STACK_CHECK(vm); const vmStackItem &__x = vm->valueStack.back(); \
 	name = __x.getRVal().getString(); } vm->valueStack.pop_back();
-#define VM_PARAM_INTEGER(name) int name; { VM_STACK_CHECK(vm); vmStackItem __x = vm->valueStack.back(); \
+#define VM_PARAM_INTEGER(name) int name; { VM_STACK_CHECK(vm); const vmStackItem &__x = vm->valueStack.back(); \
 	name = __x.getRVal().getInt(); } vm->valueStack.pop_back();
-#define VM_PARAM_FLOAT(name) float name; { VM_STACK_CHECK(vm); vmStackItem __x = vm->valueStack.back(); \
+#define VM_PARAM_FLOAT(name) float name; { VM_STACK_CHECK(vm); const vmStackItem &__x = vm->valueStack.back(); \
 	name = __x.getRVal().getFloat(); } vm->valueStack.pop_back();
-#define VM_PARAM_VECTOR(name) Vector<float> name; { VM_STACK_CHECK(vm); vmStackItem __x = vm->valueStack.back(); \
+#define VM_PARAM_VECTOR(name) Vector<float> name; { VM_STACK_CHECK(vm); const vmStackItem &__x = vm->valueStack.back(); \
 	name = __x.getRVal().getVector(); } vm->valueStack.pop_back();
-#define VM_PARAM_AGENT(name) boost::shared_ptr<Agent> name; { VM_STACK_CHECK(vm); vmStackItem __x = vm->valueStack.back(); \
+#define VM_PARAM_AGENT(name) boost::shared_ptr<Agent> name; { VM_STACK_CHECK(vm); const vmStackItem &__x = vm->valueStack.back(); \
 	name = __x.getRVal().getAgent(); } vm->valueStack.pop_back();
 // TODO: is usage of valid_agent correct here, or should we be caos_asserting?
 #define VM_PARAM_VALIDAGENT(name) VM_PARAM_AGENT(name) valid_agent(name);
 #define VM_PARAM_VARIABLE(name) caosVM__lval vm__lval_##name(this); caosVar * const name = &vm__lval_##name.value;
-#define VM_PARAM_DECIMAL(name) caosVar name; { VM_STACK_CHECK(vm); vmStackItem __x = vm->valueStack.back(); \
+#define VM_PARAM_DECIMAL(name) caosVar name; { VM_STACK_CHECK(vm); const vmStackItem &__x = vm->valueStack.back(); \
 	name = __x.getRVal(); } vm->valueStack.pop_back();
-#define VM_PARAM_BYTESTR(name) bytestring_t name; { \
+#define VM_PARAM_BYTESTR(name) shared_ptr<const bytestring_t> name##_p; { \
 	VM_STACK_CHECK(vm); \
-	vmStackItem __x = vm->valueStack.back(); \
-	name = __x.getByteStr(); } vm->valueStack.pop_back();
+	const vmStackItem &__x = vm->valueStack.back(); \
+	name##_p = __x.getByteStr(); } vm->valueStack.pop_back(); \
+	const bytestring_t &name = *name##_p;
 
 #define CAOS_LVALUE(name, check, get, set) \
 	void caosVM::v_##name() { \
@@ -23,6 +23,7 @@
 #include <boost/variant.hpp>
 #include "openc2e.h"
 #include <string>
+#include "shared_str.h"
 #include <cassert>
 #include "AgentRef.h"
 #include <typeinfo>
@@ -52,7 +53,7 @@ class caosVar {
 		struct typeVisit : public boost::static_visitor<variableType> {
 			variableType operator()(int) const { return CAOSINT; }
 			variableType operator()(float) const { return CAOSFLOAT; }
-			variableType operator()(const std::string &) const { return CAOSSTR; }
+			variableType operator()(const shared_str &) const { return CAOSSTR; }
 			variableType operator()(const AgentRef &) const { return CAOSAGENT; }
 			variableType operator()(nulltype_tag) const { return CAOSNULL; }
 			variableType operator()(const Vector<float> &) const { return CAOSVEC; }
@@ -79,7 +80,7 @@ class caosVar {
 			int operator()(const Vector<float> &v) const {
 				return (int)v.getMagnitude();
 			}
-			BAD_TYPE(int, std::string);
+			BAD_TYPE(int, shared_str);
 			BAD_TYPE(int, AgentRef);
 			BAD_TYPE(int, nulltype_tag);
 		};
@@ -88,14 +89,14 @@ class caosVar {
 			float operator()(int i) const { return (float)i; }
 			float operator()(float f) const { return f; }
 			float operator()(const Vector<float> &v) const { return v.getMagnitude(); }
-			BAD_TYPE(float, std::string);
+			BAD_TYPE(float, shared_str);
 			BAD_TYPE(float, AgentRef);
 			BAD_TYPE(float, nulltype_tag);
 		};
 
 		struct stringVisit : public boost::static_visitor<const std::string &> {
-			const std::string &operator()(const std::string &s) const {
-				return s;
+			const std::string &operator()(const shared_str &s) const {
+				return *s;
 			}
 			BAD_TYPE(std::string, AgentRef);
 			BAD_TYPE(std::string, nulltype_tag);
@@ -108,7 +109,7 @@ class caosVar {
 			const AgentRef &operator()(const AgentRef &a) const {
 				return a;
 			}
-			BAD_TYPE(AgentRef, std::string);
+			BAD_TYPE(AgentRef, shared_str);
 			BAD_TYPE(AgentRef, nulltype_tag);
 			const AgentRef &operator()(int i) const;
 			BAD_TYPE(AgentRef, float);
@@ -119,7 +120,7 @@ class caosVar {
 			const Vector<float> &operator()(const Vector<float> &v) const {
 				return v;
 			}
-			BAD_TYPE(Vector<float>, std::string);
+			BAD_TYPE(Vector<float>, shared_str);
 			BAD_TYPE(Vector<float>, nulltype_tag);
 			BAD_TYPE(Vector<float>, int);
 			BAD_TYPE(Vector<float>, float);
@@ -128,7 +129,10 @@ class caosVar {
 
 			
 #undef BAD_TYPE
-		boost::variant<int, float, AgentRef, std::string, nulltype_tag, Vector<float> > value;
+		// strings are shared between copies, so that copying a caosVar (such
+		// as pushing a string constant) never copies the string itself; they
+		// are never modified in place
+		boost::variant<int, float, AgentRef, shared_str, nulltype_tag, Vector<float> > value;
 
 	public:
 		variableType getType() const {
@@ -181,7 +185,7 @@ class caosVar {
 			value = r;
 		}
 		void setString(const std::string &i) {
-			value = i;
+			value = shared_str(i);
 		}
 		void setVector(const Vector<float> &v) {
 			value = v;
@@ -54,6 +54,9 @@ struct cmdinfo {
 	const enum ci_type *argtypes;
 	enum ci_type rettype;
 	int evalcost;
+	// names of the handlers, for code generated by the AOT compiler
+	const char *implementation;
+	const char *saveimpl;
 };
 
 void registerAutoDelegates();
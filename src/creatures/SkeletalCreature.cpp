@@ -95,6 +95,7 @@ SkeletalCreature::SkeletalCreature(unsigned char _family) : Agent(_family, 0, 0,
 	gaitgene = 0;
 	
 	calculated = false;
+	width = height = 0;
 
 	if (engine.version == 1) {
 		setAttributes(64 + 4 + 2); // mouseable, activateable, groundbound(?!)
@@ -235,30 +236,29 @@ void SkeletalCreature::skeletonInit() {
 			throw creaturesException(boost::str(boost::format("SkeletalCreature couldn't find body data for part %c of species %d, variant %d, stage %d") % x % (int)partspecies % (int)partvariant % creature->getStage()));
 
 		// load ATT file
-		std::ifstream in(attfilename.c_str());
-		if (in.fail())
+		mmapifstream in(attfilename);
+		if (!in.live)
 			throw creaturesException(boost::str(boost::format("SkeletalCreature couldn't load body data for part %c of species %d, variant %d, stage %d (tried file %s)") % x % (int)partspecies % (int)partvariant % creature->getStage() % attfilename));
-		in >> att[i];
+		binaryCursor c(in);
+		c >> att[i];
 		
 		images[i] = tintBodySprite(images[i]);
 	}
 }
 
 shared_ptr<creaturesImage> SkeletalCreature::tintBodySprite(shared_ptr<creaturesImage> s) {
-	// TODO: don't bother tinting if we don't need to
-	
 	// TODO: work out tinting for other engine versions
 	if (engine.version > 2) {
-		shared_ptr<creaturesImage> newimage = s->mutableCopy();
-		newimage->tint(creature->getTint(0), creature->getTint(1), creature->getTint(2), creature->getTint(3), creature->getTint(4));
-		return newimage;
+		// creatures with identical tint genes share the same tinted sprite
+		return world.gallery.getTintedImage(s, creature->getTint(0), creature->getTint(1), creature->getTint(2), creature->getTint(3), creature->getTint(4));
 	}
 
 	return s;
 }
 
 void SkeletalCreature::render(Surface *renderer, int xoffset, int yoffset) {
-	bool mirror_body_parts = (world.variables["engine_mirror_creature_body_parts"] == 1);
+	static unsigned int mirrorslot = world.variables.slot("engine_mirror_creature_body_parts");
+	bool mirror_body_parts = (world.variables.get(mirrorslot) == 1);
 
 	for (int j = 0; j < 17; j++) {
 		int i = cee_zorder[posedirection][j];
@@ -373,8 +373,11 @@ void SkeletalCreature::recalculateSkeleton() {
 	oldfooty = attachmentY(orig_footpart, 1);
 	
 	// recalculate width/height
+	int oldwidth = width, oldheight = height;
 	height = downfoot_left ? leftfoot : rightfoot;
 	width = 50; // TODO: arbitary values bad
+	if (width != oldwidth || height != oldheight)
+		world.partsChanged(); // the skeleton part is indexed at this size
 
 	// TODO: muh, we should cooperate with physics system etc
 	/*if (carriedby || invehicle)
@@ -453,7 +456,7 @@ void SkeletalCreature::snapDownFoot() {
 		std::cout << "Creature out of room system at (" << footx << ", " << footy << "), pushing it back in." << std::endl;
 
 		// TODO: sucky code
-		x = lastgoodfootx - attachmentX(orig_footpart, 1);
+		moveTo(lastgoodfootx - attachmentX(orig_footpart, 1), y);
 		footx = lastgoodfootx;
 		footy = lastgoodfooty;
 		downfootroom = m->roomAt(footx, footy);
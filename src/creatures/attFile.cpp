@@ -20,11 +20,11 @@
 #include <boost/tokenizer.hpp>
 using namespace boost;
 
-std::istream &operator >> (std::istream &i, attFile &f) {
+binaryCursor &operator >> (binaryCursor &i, attFile &f) {
 	f.nolines = 0;
 
 	std::string s;
-	while (std::getline(i, s)) {
+	while (i.readLine(s)) {
 		if (s.size() == 0) return i;
 		if (f.nolines >= 16) return i; // TODO: what the heck? wah
 		assert(f.nolines < 16);
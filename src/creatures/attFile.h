@@ -17,13 +17,14 @@
  *
  */
 #include <fstream>
+#include "binaryCursor.h"
 
 class attFile {
 public:
 	unsigned int attachments[16][20];
 	unsigned int noattachments[16];
 	unsigned int nolines;
-	friend std::istream &operator >> (std::istream &, attFile &);
+	friend binaryCursor &operator >> (binaryCursor &, attFile &);
 };
 
 /* vim: set noet: */
@@ -24,6 +24,67 @@
 
 float dummyValues[8] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
 
+/*
+ * The wiring of a non-migratory tract only depends on how many neurons it
+ * covers at each end and how many connections each neuron gets, so we build
+ * it once as a list of (src, dest) indices and share it between every tract
+ * with the same shape (eg, every creature hatched from the same genome).
+ */
+struct c2eTractLayoutKey {
+	unsigned int srcsize, destsize, srcconns, destconns;
+
+	bool operator<(const c2eTractLayoutKey &o) const {
+		if (srcsize != o.srcsize) return srcsize < o.srcsize;
+		if (destsize != o.destsize) return destsize < o.destsize;
+		if (srcconns != o.srcconns) return srcconns < o.srcconns;
+		return destconns < o.destconns;
+	}
+};
+
+typedef std::vector<std::pair<unsigned int, unsigned int> > c2eTractLayout;
+
+static std::map<c2eTractLayoutKey, c2eTractLayout> tractlayouts;
+
+static const c2eTractLayout &getTractLayout(const c2eTractLayoutKey &key) {
+	std::map<c2eTractLayoutKey, c2eTractLayout>::iterator i = tractlayouts.find(key);
+	if (i != tractlayouts.end()) return i->second;
+
+	c2eTractLayout &layout = tractlayouts[key];
+
+	// distribute neurons
+	// this seems identical to CL's brain-in-a-vat for the default brain and for some test cases fuzzie made up
+	// TODO: test the algorithm a bit more
+	// TODO: take notice of norandomconnections? (doesn't look like it)
+	std::vector<bool> connected(key.srcsize * key.destsize, false);
+	unsigned int srcneuron = 0, srcconns = 0;
+	unsigned int destneuron = 0, destconns = 0;
+	while (true) {
+		// if there's already a dendrite like the one we're about to create, we're done
+		std::vector<bool>::reference c = connected[srcneuron * key.destsize + destneuron];
+		if (c) break;
+		c = true;
+
+		layout.push_back(std::pair<unsigned int, unsigned int>(srcneuron, destneuron));
+
+		srcconns++;
+		if (srcconns >= key.srcconns) {
+			srcconns = 0;
+			destneuron++;
+			if (destneuron >= key.destsize)
+				destneuron = 0;
+		}
+		destconns++;
+		if (destconns >= key.destconns) {
+			destconns = 0;
+			srcneuron++;
+			if (srcneuron >= key.srcsize)
+				srcneuron = 0;
+		}
+	}
+
+	return layout;
+}
+
 /*
  * c2ebraincomponentorder::operator()
  *
@@ -133,38 +194,17 @@ void c2eTract::setupTract() {
 			return;
 		}
 	
-		// distribute neurons
-		// this seems identical to CL's brain-in-a-vat for the default brain and for some test cases fuzzie made up
-		// TODO: test the algorithm a bit more
-		// TODO: take notice of norandomconnections? (doesn't look like it)
-		unsigned int srcneuron = 0, srcconns = 0;
-		unsigned int destneuron = 0, destconns = 0;
-		while (true) {
-			c2eNeuron *src = src_neurons[srcneuron];
-			c2eNeuron *dest = dest_neurons[destneuron];
-
-			// if there's already a dendrite like the one we're about to create, we're done
-			if (getDendriteFromTo(src, dest)) return;
-			
-			c2eDendrite d;
-			d.source = src;
-			d.dest = dest;
-			dendrites.push_back(d);
-
-			srcconns++;
-			if (srcconns >= g->src_noconnections) {
-				srcconns = 0;
-				destneuron++;
-				if (destneuron >= dest_neurons.size())
-					destneuron = 0;
-			}
-			destconns++;
-			if (destconns >= g->dest_noconnections) {
-				destconns = 0;
-				srcneuron++;
-				if (srcneuron >= src_neurons.size())
-					srcneuron = 0;
-			}
+		c2eTractLayoutKey key;
+		key.srcsize = src_neurons.size();
+		key.destsize = dest_neurons.size();
+		key.srcconns = g->src_noconnections;
+		key.destconns = g->dest_noconnections;
+		const c2eTractLayout &layout = getTractLayout(key);
+
+		dendrites.resize(layout.size());
+		for (unsigned int i = 0; i < layout.size(); i++) {
+			dendrites[i].source = src_neurons[layout[i].first];
+			dendrites[i].dest = dest_neurons[layout[i].second];
 		}
 	}
 }
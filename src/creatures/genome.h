@@ -22,6 +22,7 @@
 #include "endianlove.h"
 #include "exceptions.h"
 #include "lifestage.h"
+#include "binaryCursor.h"
 
 #include <vector>
 #include <string>
@@ -39,16 +40,19 @@ class genomeFile {
   uint8 cversion;
   organGene *currorgan;
 
-  gene *nextGene(istream &); // returns NULL upon 'gend'
+  gene *nextGene(binaryCursor &); // returns NULL upon 'gend'
   geneNote *findNote(uint8 type, uint8 subtype, uint8 which);
 
   friend ostream &operator << (ostream &, const genomeFile &);
   friend istream &operator >> (istream &, genomeFile &);
+  friend binaryCursor &operator >> (binaryCursor &, genomeFile &);
 
 public:
+  // copies of a genomeFile share the same gene objects (see World::loadGenome),
+  // so genes must be copied before being changed
   vector<gene *> genes;
 
-  void readNotes(istream &);
+  void readNotes(binaryCursor &);
   void writeNotes(ostream &) const;
 
   uint8 getVersion() { return cversion; }
@@ -102,7 +106,7 @@ struct geneHeader {
 //! The base class for all Creatures genes.
 class gene {
   friend ostream &operator << (ostream &, const gene &);
-  friend istream &operator >> (istream &, gene &);
+  friend binaryCursor &operator >> (binaryCursor &, gene &);
 
 protected:
   uint8 cversion;
@@ -111,7 +115,7 @@ protected:
   virtual uint8 subtype() const = 0;
 
   virtual void write(ostream &) const = 0;
-  virtual void read(istream &) = 0;
+  virtual void read(binaryCursor &) = 0;
 
   friend class genomeFile;
 
@@ -137,7 +141,7 @@ protected:
   uint8 subtype() const { if (brainorgan) return 1; else return 0; }
 
   void write(ostream &) const;
-  void read(istream &);
+  void read(binaryCursor &);
 
 public:
   vector<gene *> genes;
@@ -170,7 +174,7 @@ protected:
   uint8 subtype() const { return 0; }
 
   void write(ostream &) const;
-  void read(istream &);
+  void read(binaryCursor &);
 
 public:
   uint8 id[4]; // todo: string
@@ -224,7 +228,7 @@ struct oldDendriteInfo {
   uint8 forproprule[12];
 
   friend ostream &operator << (ostream &, const oldDendriteInfo &);
-  friend istream &operator >> (istream &, oldDendriteInfo &);
+  friend binaryCursor &operator >> (binaryCursor &, oldDendriteInfo &);
 
   oldDendriteInfo(uint8 v) { cversion = v; }
 };
@@ -235,7 +239,7 @@ protected:
   uint8 subtype() const { return 0; }
 
   void write(ostream &) const;
-  void read(istream &);
+  void read(binaryCursor &);
 
 public:  
   // rules have size 8 for C1, size 12 for C2
@@ -266,7 +270,7 @@ protected:
   uint8 subtype() const { return 2; }
 
   void write(ostream &) const;
-  void read(istream &);
+  void read(binaryCursor &);
 
 public:
   uint16 updatetime;
@@ -305,7 +309,7 @@ protected:
   uint8 subtype() const { return 0; }
 
   void write(ostream &) const;
-  void read(istream &);
+  void read(binaryCursor &);
 
 public:
   uint8 organ;
@@ -328,7 +332,7 @@ protected:
   uint8 subtype() const { return 1; }
 
   void write(ostream &) const;
-  void read(istream &);
+  void read(binaryCursor &);
 
 public:
   uint8 organ;
@@ -352,7 +356,7 @@ protected:
   uint8 subtype() const { return 2; }
 
   void write(ostream &) const;
-  void read(istream &);
+  void read(binaryCursor &);
 
 public:
   uint8 reactant[4];
@@ -369,7 +373,7 @@ protected:
   uint8 subtype() const { return 3; }
 
   void write(ostream &) const;
-  void read(istream &);
+  void read(binaryCursor &);
 
 public:
   uint8 halflives[256];
@@ -384,7 +388,7 @@ protected:
   uint8 subtype() const { return 4; }
 
   void write(ostream &) const;
-  void read(istream &);
+  void read(binaryCursor &);
 
 public:
   uint8 chemical;
@@ -400,7 +404,7 @@ protected:
   uint8 subtype() const { return 5; }
 
   void write(ostream &) const;
-  void read(istream &);
+  void read(binaryCursor &);
 
 public:
   uint8 lobes[3];
@@ -428,7 +432,7 @@ protected:
   uint8 subtype() const { return 0; }
 
   void write(ostream &) const;
-  void read(istream &);
+  void read(binaryCursor &);
 
 public:
   uint8 stim;
@@ -452,7 +456,7 @@ protected:
   uint8 subtype() const { return 1; }
 
   void write(ostream &) const;
-  void read(istream &);
+  void read(binaryCursor &);
 
 public:
   uint8 genus;
@@ -469,7 +473,7 @@ protected:
   uint8 subtype() const { return 2; }
 
   void write(ostream &) const;
-  void read(istream &);
+  void read(binaryCursor &);
 
 public:
   uint8 part;
@@ -486,7 +490,7 @@ protected:
   uint8 subtype() const { return 3; }
 
   void write(ostream &) const;
-  void read(istream &);
+  void read(binaryCursor &);
 
 public:
   uint8 poseno;
@@ -505,7 +509,7 @@ protected:
   uint8 subtype() const { return 4; }
 
   void write(ostream &) const;
-  void read(istream &);
+  void read(binaryCursor &);
 
 public:
   uint8 drive;
@@ -523,7 +527,7 @@ protected:
   uint8 subtype() const { return 5; }
 
   void write(ostream &) const;
-  void read(istream &);
+  void read(binaryCursor &);
 
 public:
   uint8 lobes[3];
@@ -542,7 +546,7 @@ protected:
   uint8 subtype() const { return 6; }
 
   void write(ostream &) const;
-  void read(istream &);
+  void read(binaryCursor &);
 
 public:
   uint8 color;
@@ -558,7 +562,7 @@ protected:
   uint8 subtype() const { return 7; }
 
   void write(ostream &) const;
-  void read(istream &);
+  void read(binaryCursor &);
 
 public:
   uint8 rotation;
@@ -574,7 +578,7 @@ protected:
   uint8 subtype() const { return 8; }
   
   void write(ostream &) const;
-  void read(istream &);
+  void read(binaryCursor &);
 
 public:
   uint16 expressionno;
@@ -21,6 +21,8 @@
 #include <typeinfo>
 #include <exception>
 #include <iostream>
+#include <iterator>
+#include <string.h>
 
 geneNote *genomeFile::findNote(uint8 type, uint8 subtype, uint8 which) {
 	for (vector<gene *>::iterator x = genes.begin(); x != genes.end(); x++) {
@@ -43,7 +45,13 @@ geneNote *genomeFile::findNote(uint8 type, uint8 subtype, uint8 which) {
 	return 0;
 }
 
-void genomeFile::readNotes(istream &s) {
+// notes are stored as NUL-terminated C strings
+static std::string noteString(const char *buffer, unsigned int len) {
+	const char *end = (const char *)memchr(buffer, 0, len);
+	return std::string(buffer, end ? (end - buffer) : len);
+}
+
+void genomeFile::readNotes(binaryCursor &s) {
 	if (cversion == 3) {
 		uint16 gnover = read16(s);
 		uint16 nosvnotes = read16(s);
@@ -58,14 +66,14 @@ void genomeFile::readNotes(istream &s) {
 			// TODO: we currently skip all the notes (note that there are 18 and then 1!)
 			for (int i = 0; i < 19; i++) {
 				uint16 skip = read16(s);
-				uint8 *dummy = new uint8[skip]; s.read((char *)dummy, skip); delete[] dummy;
+				s.skip(skip);
 			}
 			}
 
 		uint16 ver = 0;
 
 		while (ver != 0x02) {
-			if (s.fail() || s.eof()) throw genomeException("c3 gno loading broke ... second magic not present");
+			if (s.remaining() < 2) throw genomeException("c3 gno loading broke ... second magic not present");
 			ver = read16(s);
 		}
 	}
@@ -80,14 +88,11 @@ void genomeFile::readNotes(istream &s) {
 		geneNote *n = findNote(type, subtype, which);
 
 		uint16 buflen = read16(s);
-		char *buffer = new char[buflen + 1];
-		s.read(buffer, buflen); buffer[buflen] = 0;
-		if (n != 0) n->description = buffer;
+		const char *buffer = s.skip(buflen);
+		if (n != 0) n->description = noteString(buffer, buflen);
 		buflen = read16(s);
-		delete[] buffer; buffer = new char[buflen + 1];
-		s.read(buffer, buflen); buffer[buflen] = 0;
-		if (n != 0) n->comments = buffer;
-		delete[] buffer;		
+		buffer = s.skip(buflen);
+		if (n != 0) n->comments = noteString(buffer, buflen);
 	}
 }
 
@@ -95,14 +100,12 @@ void genomeFile::writeNotes(ostream &s) const {
 	// TODO
 }
 
-gene *genomeFile::nextGene(istream &s) {
-	uint8 majic[3];
-	s.read((char *)majic, 3);
-	if (strncmp((char *)majic, "gen", 3) != 0) throw genomeException("bad majic for a gene");
+gene *genomeFile::nextGene(binaryCursor &s) {
+	if (strncmp(s.skip(3), "gen", 3) != 0) throw genomeException("bad majic for a gene");
 
-	s >> majic[0];
-	if (majic[0] == 'd') return 0;
-	if (majic[0] != 'e')
+	uint8 majic = s.read8();
+	if (majic == 'd') return 0;
+	if (majic != 'e')
 		throw genomeException("bad majic at stage2 for a gene");
 
 	uint8 type, subtype;
@@ -172,19 +175,18 @@ gene *genomeFile::nextGene(istream &s) {
 	return g;
 }
 
-istream &operator >> (istream &s, genomeFile &f) {
-	char majic[3]; s.read(majic, 3);
-	if (strncmp((char *)majic, "gen", 3) == 0) {
-		s >> majic[0];
-		if (majic[0] == 'e') f.cversion = 1;
+binaryCursor &operator >> (binaryCursor &s, genomeFile &f) {
+	unsigned int start = s.tell();
+	const char *majic = s.skip(3);
+	if (strncmp(majic, "gen", 3) == 0) {
+		if (s.read8() == 'e') f.cversion = 1;
 		else throw genomeException("bad majic for genome");
 
-		s.seekg(0, std::ios::beg);
+		s.seek(start);
 	} else {
-		if (strncmp((char *)majic, "dna", 3) != 0) throw genomeException("bad majic for genome");
+		if (strncmp(majic, "dna", 3) != 0) throw genomeException("bad majic for genome");
 
-		s >> majic[0];
-		f.cversion = majic[0] - 48; // 48 = ASCII '0'
+		f.cversion = s.read8() - 48; // 48 = ASCII '0'
 		if ((f.cversion < 1) || (f.cversion > 3)) throw genomeException("unsupported genome version in majic");
 	}
 
@@ -197,6 +199,15 @@ istream &operator >> (istream &s, genomeFile &f) {
 	return s;
 }
 
+istream &operator >> (istream &s, genomeFile &f) {
+	// read the rest of the stream into memory and parse it from there
+	std::string data((std::istreambuf_iterator<char>(s)), std::istreambuf_iterator<char>());
+	binaryCursor c(data);
+	c >> f;
+
+	return s;
+}
+
 ostream &operator << (ostream &s, const genomeFile &f) {
 	s << "dna" << char(f.cversion + 48); // 48 = ASCII '0'
 
@@ -250,7 +261,7 @@ ostream &operator << (ostream &s, const gene &g) {
 	return s;
 }
 
-istream &operator >> (istream &s, gene &g) {
+binaryCursor &operator >> (binaryCursor &s, gene &g) {
 	uint8 b;
 	s >> g.note.which >> g.header.generation >> b;
 	g.header.switchontime = (lifestage)b;
@@ -270,7 +281,7 @@ void bioEmitterGene::write(ostream &s) const {
 	s << flags;
 }
 
-void bioEmitterGene::read(istream &s) {
+void bioEmitterGene::read(binaryCursor &s) {
 	s >> organ >> tissue >> locus >> chemical >> threshold >> rate >> gain;
 	uint8 flags;
 	s >> flags;
@@ -285,7 +296,7 @@ void bioHalfLivesGene::write(ostream &s) const {
 	}
 }
 
-void bioHalfLivesGene::read(istream &s) {
+void bioHalfLivesGene::read(binaryCursor &s) {
 	for (int i = 0; i < 256; i++) {
 		s >> halflives[i];
 	}
@@ -295,7 +306,7 @@ void bioInitialConcentrationGene::write(ostream &s) const {
 	s << chemical << quantity;
 }
 
-void bioInitialConcentrationGene::read(istream &s) {
+void bioInitialConcentrationGene::read(binaryCursor &s) {
 	s >> chemical >> quantity;
 }
 
@@ -309,7 +320,7 @@ void bioNeuroEmitterGene::write(ostream &s) const {
 	}
 }
 
-void bioNeuroEmitterGene::read(istream &s) {
+void bioNeuroEmitterGene::read(binaryCursor &s) {
 	for (int i = 0; i < 3; i++) {
 		s >> lobes[i] >> neurons[i];
 	}
@@ -328,7 +339,7 @@ void bioReactionGene::write(ostream &s) const {
 	s << rate;
 }
 
-void bioReactionGene::read(istream &s) {
+void bioReactionGene::read(binaryCursor &s) {
 	for (int i = 0; i < 4; i++) {
 		s >> quantity[i];
 		s >> reactant[i];
@@ -343,7 +354,7 @@ void bioReceptorGene::write(ostream &s) const {
 	s << flags;
 }
 
-void bioReceptorGene::read(istream &s) {
+void bioReceptorGene::read(binaryCursor &s) {
 	s >> organ >> tissue >> locus >> chemical >> threshold >> nominal >> gain;
 	uint8 flags;
 	s >> flags;
@@ -367,7 +378,7 @@ void c2eBrainLobeGene::write(ostream &s) const {
 	for (int i = 0; i < 48; i++) s << updaterule[i];
 }
 
-void c2eBrainLobeGene::read(istream &s) {
+void c2eBrainLobeGene::read(binaryCursor &s) {
 	for (int i = 0; i < 4; i++) s >> id[i];
 
 	updatetime = read16(s, false);
@@ -399,7 +410,7 @@ void c2eBrainTractGene::write(ostream &s) const {
 	for (int i = 0; i < 48; i++) s << updaterule[i];
 }
 
-void c2eBrainTractGene::read(istream &s) {
+void c2eBrainTractGene::read(binaryCursor &s) {
 	updatetime = read16(s, false);
 	for (int i = 0; i < 4; i++) s >> srclobe[i];
 	srclobe_lowerbound = read16(s, false);
@@ -420,7 +431,7 @@ void creatureAppearanceGene::write(ostream &s) const {
 	if (cversion > 1) s << species;
 }
 
-void creatureAppearanceGene::read(istream &s) {
+void creatureAppearanceGene::read(binaryCursor &s) {
 	s >> part >> variant;
 	if (cversion > 1) s >> species;
 }
@@ -434,7 +445,7 @@ void creatureFacialExpressionGene::write(ostream &s) const {
 	}
 }
 
-void creatureFacialExpressionGene::read(istream &s) {
+void creatureFacialExpressionGene::read(binaryCursor &s) {
 	expressionno = read16(s);
 	s >> weight;
 
@@ -451,7 +462,7 @@ void creatureGaitGene::write(ostream &s) const {
 	}
 }
 
-void creatureGaitGene::read(istream &s) {
+void creatureGaitGene::read(binaryCursor &s) {
 	s >> drive;
 
 	for (int i = 0; i < gaitLength(); i++) {
@@ -471,7 +482,7 @@ void creatureGenusGene::write(ostream &s) const {
 	for (int i = 0; i < ((cversion == 3) ? 32 : 4); i++) s << b[i];
 }
 
-void creatureGenusGene::read(istream &s) {
+void creatureGenusGene::read(binaryCursor &s) {
 	s >> genus;
 
 	char buf[33];
@@ -496,7 +507,7 @@ void creatureInstinctGene::write(ostream &s) const {
 	s << level;
 }
 
-void creatureInstinctGene::read(istream &s) {
+void creatureInstinctGene::read(binaryCursor &s) {
 	for (int i = 0; i < 3; i++) {
 		s >> lobes[i] >> neurons[i];
 	}
@@ -510,7 +521,7 @@ void creaturePigmentGene::write(ostream &s) const {
 	s << color << amount;
 }
 
-void creaturePigmentGene::read(istream &s) {
+void creaturePigmentGene::read(binaryCursor &s) {
 	s >> color >> amount;
 }
 
@@ -518,7 +529,7 @@ void creaturePigmentBleedGene::write(ostream &s) const {
 	s << rotation << swap;
 }
 
-void creaturePigmentBleedGene::read(istream &s) {
+void creaturePigmentBleedGene::read(binaryCursor &s) {
 	s >> rotation >> swap;
 }
 
@@ -530,7 +541,7 @@ void creaturePoseGene::write(ostream &s) const {
 	}
 }
 
-void creaturePoseGene::read(istream &s) {
+void creaturePoseGene::read(binaryCursor &s) {
 	s >> poseno;
 
 	for (int i = 0; i < poseLength(); i++) {
@@ -552,7 +563,7 @@ void creatureStimulusGene::write(ostream &s) const {
 	}
 }
 
-void creatureStimulusGene::read(istream &s) {
+void creatureStimulusGene::read(binaryCursor &s) {
 	s >> stim >> significance >> sensoryneuron >> intensity;
 	uint8 flags;
 	s >> flags;
@@ -578,7 +589,7 @@ void oldBrainLobeGene::write(ostream &s) const {
 	s << dendrite1 << dendrite2;
 }
 
-void oldBrainLobeGene::read(istream &s) {
+void oldBrainLobeGene::read(binaryCursor &s) {
 	s >> x >> y >> width >> height >> perceptflag >> nominalthreshold >> leakagerate >> reststate >> inputgain;
 	s.read((char *)staterule, (cversion == 1) ? 8 : 12);
 	s >> flags;
@@ -594,7 +605,7 @@ void organGene::write(ostream &s) const {
 		s << **x;
 }
 
-void organGene::read(istream &s) {
+void organGene::read(binaryCursor &s) {
 	s >> clockrate >> damagerate >> lifeforce >> biotickstart >> atpdamagecoefficient;
 }
 
@@ -617,7 +628,7 @@ ostream &operator << (ostream &s, const oldDendriteInfo &i) {
 	return s;
 }
 
-istream &operator >> (istream &s, oldDendriteInfo &i) {
+binaryCursor &operator >> (binaryCursor &s, oldDendriteInfo &i) {
 	s >> i.srclobe >> i.min >> i.max >> i.spread >> i.fanout >> i.minLTW >> i.maxLTW;
 	s >> i.minstr >> i.maxstr >> i.migrateflag >> i.relaxsuscept >> i.relaxSTW >> i.LTWgainrate;
 
@@ -46,6 +46,48 @@ void oldSVRule::init(uint8 version, uint8 *src) {
 			rules[i] += 8; // then skip the 8 new C2 svrules (to map to C2 svrules)
 	}
 	rndconst = 0; // TODO: correct?
+	compile();
+}
+
+void oldSVRule::compile() {
+	// original engine seems to simply happily walk off the end of the svrule array for constants!
+	// so our behaviour for truncated operators (which we just drop) is NOT the same
+
+	noops = 0;
+	for (unsigned int i = 0; i < length; i++) {
+		op &o = ops[noops];
+		o.opcode = rules[i];
+		o.a = o.b = 0;
+
+		unsigned int operands = 0;
+		switch (rules[i]) {
+			case 0: // <end>
+				return;
+
+			case 31: // PLUS
+			case 32: // MINUS
+			case 33: // TIMES
+			case 37: // multiply
+			case 38: // average
+				operands = 1;
+				break;
+
+			case 39: // move twrds
+			case 40: // random
+				operands = 2;
+				break;
+		}
+
+		if (operands) {
+			if (++i == length) return;
+			o.a = rules[i];
+		}
+		if (operands == 2) {
+			if (++i == length) return;
+			o.b = rules[i];
+		}
+		noops++;
+	}
 }
 
 unsigned char oldLobe::evaluateSVRuleConstant(oldNeuron *cell, oldDendrite *dend, uint8 id, oldSVRule &rule) {
@@ -166,16 +208,11 @@ unsigned char oldLobe::evaluateSVRuleConstant(oldNeuron *cell, oldDendrite *dend
 unsigned char oldLobe::processSVRule(oldNeuron *cell, oldDendrite *dend, oldSVRule &rule) {
 	unsigned char state = 0;
 
-	// original engine seems to simply happily walk off the end of the svrule array for constants!
-	// so our behaviour for the 'if (i == len)' lines is NOT the same
-
-	for (unsigned int i = 0; i < rule.length; i++) {
-		switch (rule.rules[i]) {
-			case 0: // <end>
-				return state;
-
+	for (unsigned int i = 0; i < rule.noops; i++) {
+		oldSVRule::op &o = rule.ops[i];
+		switch (o.opcode) {
 			default:
-				state = evaluateSVRuleConstant(cell, dend, rule.rules[i], rule);
+				state = evaluateSVRuleConstant(cell, dend, o.opcode, rule);
 				break;
 
 			case 30: // TRUE
@@ -183,22 +220,16 @@ unsigned char oldLobe::processSVRule(oldNeuron *cell, oldDendrite *dend, oldSVRu
 				break;
 
 			case 31: // PLUS
-				i++;
-				if (i == rule.length) return state;
-				state = state + evaluateSVRuleConstant(cell, dend, rule.rules[i], rule);
+				state = state + evaluateSVRuleConstant(cell, dend, o.a, rule);
 				break;
 
 			case 32: // MINUS
-				i++;
-				if (i == rule.length) return state;
-				state = state - evaluateSVRuleConstant(cell, dend, rule.rules[i], rule);
+				state = state - evaluateSVRuleConstant(cell, dend, o.a, rule);
 				break;
 
 			case 33: // TIMES
 				// unused?
-				i++;
-				if (i == rule.length) return state;
-				state = (state * evaluateSVRuleConstant(cell, dend, rule.rules[i], rule)) / 256;
+				state = (state * evaluateSVRuleConstant(cell, dend, o.a, rule)) / 256;
 				break;
 
 			case 34: // INCR
@@ -217,35 +248,23 @@ unsigned char oldLobe::processSVRule(oldNeuron *cell, oldDendrite *dend, oldSVRu
 
 			case 37: // multiply
 				// unused?
-				i++;
-				if (i == rule.length) return state;
-				state = state * evaluateSVRuleConstant(cell, dend, rule.rules[i], rule);
+				state = state * evaluateSVRuleConstant(cell, dend, o.a, rule);
 				break;
 
 			case 38: // average
 				// unused?
-				i++;
-				if (i == rule.length) return state;
-				state = (state + evaluateSVRuleConstant(cell, dend, rule.rules[i], rule)) / 2;
+				state = (state + evaluateSVRuleConstant(cell, dend, o.a, rule)) / 2;
 				break;
 
 			case 39: { // move twrds
-				i++;
-				if (i == rule.length) return state;
-				unsigned char towards = evaluateSVRuleConstant(cell, dend, rule.rules[i], rule);
-				i++;
-				if (i == rule.length) return state;
-				unsigned char multiplier = evaluateSVRuleConstant(cell, dend, rule.rules[i], rule);
+				unsigned char towards = evaluateSVRuleConstant(cell, dend, o.a, rule);
+				unsigned char multiplier = evaluateSVRuleConstant(cell, dend, o.b, rule);
 				state = ((towards - state) * multiplier) / 256;
 				} break;
 
 			case 40: { // random
-				i++;
-				if (i == rule.length) return state;
-				unsigned char min = evaluateSVRuleConstant(cell, dend, rule.rules[i], rule);
-				i++;
-				if (i == rule.length) return state;
-				unsigned char max = evaluateSVRuleConstant(cell, dend, rule.rules[i], rule);
+				unsigned char min = evaluateSVRuleConstant(cell, dend, o.a, rule);
+				unsigned char max = evaluateSVRuleConstant(cell, dend, o.b, rule);
 				state = (rand() % (max - min + 1)) + min;
 				} break;
 		}
@@ -269,16 +288,6 @@ unsigned char oldLobe::dendrite_sum(oldNeuron &neu, unsigned int type, bool only
 	return (sum * inputgain) / 255;
 }
 
-// TODO: precalculate this if we end up using it much?
-unsigned int oldLobe::getDendriteCount() {
-	unsigned int count = 0;
-	for (unsigned int i = 0; i < neurons.size(); i++) {
-		count += neurons[i].dendrites[0].size();
-		count += neurons[i].dendrites[1].size();
-	}
-	return count;
-}
-
 oldLobe::oldLobe(oldBrain *b, oldBrainLobeGene *g) {
 	assert(b);
 	parent = b;
@@ -303,7 +312,9 @@ oldLobe::oldLobe(oldBrain *b, oldBrainLobeGene *g) {
 			forproprule[i].init(g->version(), (uint8 *)dend_info->forproprule);
 		} else {
 			backproprule[i].length = 0;
+			backproprule[i].compile();
 			forproprule[i].length = 0;
+			forproprule[i].compile();
 		}
 	}
 
@@ -379,9 +390,21 @@ void oldLobe::init() {
 					break;
 			}
 			value += our_min;
-			for (unsigned int j = 0; j < (unsigned int)value; j++) {
-				neurons[i].dendrites[type].push_back(oldDendrite());
-			}
+			neurons[i].dendrites[type].count = value;
+		}
+	}
+
+	// all the dendrites of a type live in one array, so ticking walks memory in order
+	for (unsigned int type = 0; type < 2; type++) {
+		unsigned int total = 0;
+		for (unsigned int i = 0; i < neurons.size(); i++)
+			total += neurons[i].dendrites[type].count;
+		alldendrites[type].resize(total, oldDendrite());
+
+		unsigned int offset = 0;
+		for (unsigned int i = 0; i < neurons.size(); i++) {
+			neurons[i].dendrites[type].first = total ? &alldendrites[type][offset] : 0;
+			offset += neurons[i].dendrites[type].count;
 		}
 	}
 
@@ -405,7 +428,7 @@ void oldLobe::connect() {
 		unsigned int offset = 0;
 		for (unsigned int i = 0; i < neurons.size(); i++) {
 			oldNeuron &destneu = neurons[i];
-			std::vector<oldDendrite> &dendrites = destneu.dendrites[type];
+			oldDendriteList &dendrites = destneu.dendrites[type];
 			if (dendrites.size() == 0) continue;
 
 			unsigned int srcneu_id = offset / destsize;
@@ -485,7 +508,29 @@ void oldLobe::wipe() {
 	}
 }
 
+void oldLobe::calculateRates() {
+	oldCreature *c = parent->getParent();
+	unsigned int ticks = parent->getTicks();
+
+	leaknow = (ticks & c->calculateTickMask(leakagerate / 8)) == 0;
+	leakmultiplier = c->calculateMultiplier(leakagerate / 8);
+
+	oldDendriteInfo *dend_info[2] = { &ourGene->dendrite1, &ourGene->dendrite2 };
+	for (unsigned int type = 0; type < 2; type++) {
+		dendriteRates &r = rates[type];
+		r.relaxsuscept = (ticks & c->calculateTickMask(dend_info[type]->relaxsuscept / 8)) == 0;
+		r.susceptmultiplier = c->calculateMultiplier(dend_info[type]->relaxsuscept / 8);
+		r.relaxSTW = (ticks & c->calculateTickMask(dend_info[type]->relaxSTW / 8)) == 0;
+		r.STWmultiplier = c->calculateMultiplier(dend_info[type]->relaxSTW / 8);
+		r.LTWgain = dend_info[type]->LTWgainrate && (ticks % dend_info[type]->LTWgainrate) == 0;
+		r.strgain = dend_info[type]->strgain && (ticks % dend_info[type]->strgain) == 0;
+		r.strloss = dend_info[type]->strloss && (ticks % dend_info[type]->strloss) == 0;
+	}
+}
+
 void oldLobe::tick() {
+	calculateRates();
+
 	if (ourGene->dendrite1.migrateflag == 1) loose_dendrites[0] = 255;
 	else loose_dendrites[0] = 0;
 	if (ourGene->dendrite2.migrateflag == 1) loose_dendrites[1] = 255;
@@ -499,9 +544,9 @@ void oldLobe::tick() {
 		unsigned char out = processSVRule(&neurons[i], NULL, staterule);
 
 		// apply leakage rate in order to settle at rest state
-		if ((parent->getTicks() & parent->getParent()->calculateTickMask(leakagerate / 8)) == 0) {
+		if (leaknow) {
 			if (out > ourGene->reststate)
-				out = ourGene->reststate + ((out - ourGene->reststate) * parent->getParent()->calculateMultiplier(leakagerate / 8)) / 65536;
+				out = ourGene->reststate + ((out - ourGene->reststate) * leakmultiplier) / 65536;
 			else
 				out = ourGene->reststate;
 		}
@@ -602,7 +647,7 @@ unsigned int oldNeuron::magicalHash(unsigned int type) {
 }
 
 // helper function for neuronTryAllLooseMigration (below)
-bool oldLobe::migrationTryCandidateSlice(unsigned int type, oldLobe *src, std::vector<oldDendrite> &dendrites, unsigned int i) {
+bool oldLobe::migrationTryCandidateSlice(unsigned int type, oldLobe *src, oldDendriteList &dendrites, unsigned int i) {
 	// we examine a 'slice' of candidate active neurons, one for each dendrite, starting at i
 	for (unsigned int j = 0; j < dendrites.size(); j++) {
 		// if the neuron is perceptible..
@@ -738,76 +783,79 @@ void oldLobe::neuronTryMigration(unsigned int type, oldNeuron &neu, oldLobe *src
 void oldLobe::tickDendrites(unsigned int id, unsigned int type) {
 	oldDendriteInfo *dend_info = &ourGene->dendrite1;
 	if (type == 1) dend_info = &ourGene->dendrite2;
+	const dendriteRates &r = rates[type];
 
 	oldNeuron &dest = neurons[id];
 
+	oldSVRule &suscept = susceptrule[type], &relax = relaxrule[type];
+	oldSVRule &strgain = strgainrule[type], &strloss = strlossrule[type];
+	oldSVRule &backprop = backproprule[type], &forprop = forproprule[type];
+
 	unsigned int loose_dends = 0;
-	for (unsigned int i = 0; i < dest.dendrites[type].size(); i++) {
+	for (oldDendrite *dend = dest.dendrites[type].begin(); dend != dest.dendrites[type].end(); dend++) {
 		unsigned char out;
 
-		oldDendrite &dend = dest.dendrites[type][i];
-
-		if (!dend.strength) loose_dends++;
+		if (!dend->strength) loose_dends++;
 
 		// recalculate suscept
-		out = processSVRule(&dest, &dend, susceptrule[type]);
-		if (out > dend.suscept) {
-			dend.suscept = out;
+		out = suscept.isEmpty() ? 0 : processSVRule(&dest, dend, suscept);
+		if (out > dend->suscept) {
+			dend->suscept = out;
 		} else {
 			// decay old suscept
-			if ((parent->getTicks() & parent->getParent()->calculateTickMask(dend_info->relaxsuscept / 8)) == 0) {
-				dend.suscept = (dend.suscept * parent->getParent()->calculateMultiplier(dend_info->relaxsuscept / 8)) / 65536;
+			if (r.relaxsuscept) {
+				dend->suscept = (dend->suscept * r.susceptmultiplier) / 65536;
 			}
 		}
 
 		// recalculate reinforce (TODO: why do we call this relaxrule?) (TODO: don't run if suscept is zero?)
-		out = processSVRule(&dest, &dend, relaxrule[type]);
-		unsigned char x = ((int)dend.suscept * (int)out) / 255;
-		if (x && x < dend.stw - dend.ltw)
-			dend.stw = dend.ltw + x;
+		out = relax.isEmpty() ? 0 : processSVRule(&dest, dend, relax);
+		unsigned char x = ((int)dend->suscept * (int)out) / 255;
+		if (x && x < dend->stw - dend->ltw)
+			dend->stw = dend->ltw + x;
 
 		// STW relax
-		if ((parent->getTicks() & parent->getParent()->calculateTickMask(dend_info->relaxSTW / 8)) == 0) {
-			out = dend.ltw + ((out - dend.ltw) * parent->getParent()->calculateMultiplier(dend_info->relaxSTW / 8)) / 65536;
+		if (r.relaxSTW) {
+			out = dend->ltw + ((out - dend->ltw) * r.STWmultiplier) / 65536;
 		}
 
 		// LTW gain
-		if (dend_info->LTWgainrate && (parent->getTicks() % dend_info->LTWgainrate) == 0) {
-			if (dend.ltw < dend.stw)
-				dend.ltw++;
-			else if (dend.ltw > dend.stw)
-				dend.ltw--; // does this case really happen?
+		if (r.LTWgain) {
+			if (dend->ltw < dend->stw)
+				dend->ltw++;
+			else if (dend->ltw > dend->stw)
+				dend->ltw--; // does this case really happen?
 		}
 
 		// strength gain
-		if (dend.strength < 255 && dend_info->strgain && (parent->getTicks() % dend_info->strgain) == 0) {
-			out = processSVRule(&dest, &dend, strgainrule[type]);
-			if ((int)dend.strength + (int)out > 255) dend.strength = 255;
-			else dend.strength += out;
+		if (dend->strength < 255 && r.strgain) {
+			out = strgain.isEmpty() ? 0 : processSVRule(&dest, dend, strgain);
+			if ((int)dend->strength + (int)out > 255) dend->strength = 255;
+			else dend->strength += out;
 		}
 
 		// strength loss
-		if (dend.strength && dend_info->strloss && (parent->getTicks() % dend_info->strloss) == 0) {
-			out = processSVRule(&dest, &dend, strlossrule[type]);
-			if ((int)dend.strength - (int)out < 0) dend.strength = 0;
-			else dend.strength -= out;
-			if (!dend.strength) {
+		if (dend->strength && r.strloss) {
+			out = strloss.isEmpty() ? 0 : processSVRule(&dest, dend, strloss);
+			if ((int)dend->strength - (int)out < 0) dend->strength = 0;
+			else dend->strength -= out;
+			if (!dend->strength) {
 				loose_dends++;
 				// also reset STW, LTW, suscept, output/state on dest neuron
-				dend.stw = 0;
-				dend.ltw = 0;
-				dend.suscept = 0;
+				dend->stw = 0;
+				dend->ltw = 0;
+				dend->suscept = 0;
 				dest.output = 0;
 				dest.state = 0;
 			}
 		}
 
 		// back propogation (set leak in of src neuron)
-		out = processSVRule(&dest, &dend, backproprule[type]);
-		dend.src->leakin = out;
+		out = backprop.isEmpty() ? 0 : processSVRule(&dest, dend, backprop);
+		dend->src->leakin = out;
 
 		// front propogation (set leak out of dest neuron)
-		out = processSVRule(&dest, &dend, forproprule[type]);
+		out = forprop.isEmpty() ? 0 : processSVRule(&dest, dend, forprop);
 		dest.leakout = out;
 	}
 
@@ -32,6 +32,16 @@ struct oldSVRule {
 	uint8 rndconst;
 	uint8 rules[12];
 	void init(uint8 version, uint8 *src);
+
+	// the rule with operands attached to their operators, and stopped at
+	// <end> or a truncated operator, so it needn't be re-parsed every time
+	struct op {
+		uint8 opcode, a, b;
+	};
+	op ops[12];
+	unsigned int noops;
+	void compile();
+	bool isEmpty() const { return noops == 0; } // always evaluates to 0
 };
 
 struct oldDendrite {
@@ -39,9 +49,21 @@ struct oldDendrite {
 	unsigned char strength, stw, ltw, suscept;
 };
 
+// a neuron's view of its dendrites, which are owned by the lobe
+struct oldDendriteList {
+	oldDendrite *first;
+	unsigned int count;
+
+	oldDendriteList() { first = 0; count = 0; }
+	unsigned int size() const { return count; }
+	oldDendrite &operator[](unsigned int i) { return first[i]; }
+	oldDendrite *begin() { return first; }
+	oldDendrite *end() { return first + count; }
+};
+
 struct oldNeuron {
 	unsigned char state, output, leakin, leakout;
-	std::vector<oldDendrite> dendrites[2];
+	oldDendriteList dendrites[2];
 	unsigned char percept_src;
 	oldNeuron() { state = 0; output = 0; leakin = 0; leakout = 0; percept_src = 0; }
 	unsigned int magicalHash(unsigned int type);
@@ -52,6 +74,7 @@ protected:
 	class oldBrain *parent;
 	oldBrainLobeGene *ourGene;
 	std::vector<oldNeuron> neurons;
+	std::vector<oldDendrite> alldendrites[2]; // contiguous, in neuron order
 	oldLobe *sourceLobe[2];
 	bool inited;
 
@@ -73,12 +96,22 @@ protected:
 	oldSVRule relaxrule[2];
 	oldSVRule backproprule[2], forproprule[2];
 
+	// which of the rate-limited updates happen this tick, worked out once
+	// per tick rather than once per neuron/dendrite
+	bool leaknow;
+	unsigned int leakmultiplier;
+	struct dendriteRates {
+		bool relaxsuscept, relaxSTW, LTWgain, strgain, strloss;
+		unsigned int susceptmultiplier, STWmultiplier;
+	} rates[2];
+	void calculateRates();
+
 	unsigned char evaluateSVRuleConstant(oldNeuron *cell, oldDendrite *dend, uint8 id, oldSVRule &rule);
 	unsigned char processSVRule(oldNeuron *cell, oldDendrite *dend, oldSVRule &rule);
 
 	unsigned char dendrite_sum(oldNeuron &cell, unsigned int type, bool only_if_all_firing);
 
-	bool migrationTryCandidateSlice(unsigned int type, oldLobe *src, std::vector<oldDendrite> &dendrites, unsigned int i);
+	bool migrationTryCandidateSlice(unsigned int type, oldLobe *src, oldDendriteList &dendrites, unsigned int i);
 	void neuronTryAllLooseMigration(unsigned int type, oldNeuron &neu);
 	void neuronTryMigration(unsigned int type, oldNeuron &neu, oldLobe *src);
 	void connectDendrite(unsigned int type, oldDendrite &dend, oldNeuron *dest);
@@ -98,7 +131,7 @@ public:
 
 	unsigned int getNoNeurons() { return neurons.size(); }
 	oldNeuron *getNeuron(unsigned int i) { return &neurons[i]; }
-	unsigned int getDendriteCount();
+	unsigned int getDendriteCount() { return alldendrites[0].size() + alldendrites[1].size(); }
 	unsigned int getWidth() { return width; }
 	unsigned int getHeight() { return height; }
 
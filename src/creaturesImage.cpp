@@ -24,10 +24,34 @@ uint8 *creaturesImage::getCustomPalette() {
 	throw creaturesException("Internal error: Tried to get a custom palette of a sprite which doesn't support that.");
 }
 	
-bool creaturesImage::transparentAt(unsigned int frame, unsigned int x, unsigned int y) {
+bool creaturesImage::pixelTransparent(unsigned int frame, unsigned int x, unsigned int y) {
 	return false;
 }
 
+void creaturesImage::findMaxSize() {
+	for (unsigned int i = 0; i < m_numframes; i++) {
+		if (widths[i] > maxwidth) maxwidth = widths[i];
+		if (heights[i] > maxheight) maxheight = heights[i];
+	}
+}
+
+void creaturesImage::buildMask(unsigned int frame) {
+	assert(frame < m_numframes);
+	if (masks.size() < m_numframes)
+		masks.resize(m_numframes);
+
+	unsigned int w = widths[frame], h = heights[frame];
+	std::vector<uint32> &mask = masks[frame];
+	mask.assign((w * h + 31) / 32 + 1, 0); // never empty, even for empty frames
+	for (unsigned int y = 0; y < h; y++) {
+		for (unsigned int x = 0; x < w; x++) {
+			unsigned int bit = y * w + x;
+			if (pixelTransparent(frame, x, y))
+				mask[bit >> 5] |= (1 << (bit & 31));
+		}
+	}
+}
+
 boost::shared_ptr<creaturesImage> creaturesImage::mutableCopy() {
 	throw creaturesException("Internal error: Tried to make a mutable copy of a sprite which doesn't support that.");
 }
@@ -23,6 +23,7 @@
 #include <string>
 #include <fstream>
 #include <cassert>
+#include <vector>
 #include <boost/shared_ptr.hpp>
 
 #include "endianlove.h"
@@ -43,22 +44,35 @@ protected:
 	
 	std::ifstream *stream;
 	std::string name;
+
+	// 1-bit transparency masks, built the first time a frame is hit-tested
+	std::vector<std::vector<uint32> > masks;
+	void buildMask(unsigned int frame);
+	unsigned int maxwidth, maxheight;
+	virtual bool pixelTransparent(unsigned int frame, unsigned int x, unsigned int y);
   
 public:
-	creaturesImage(std::string n = std::string()) { stream = 0; name = n; }
+	creaturesImage(std::string n = std::string()) { stream = 0; name = n; maxwidth = maxheight = 0; }
 	virtual ~creaturesImage() { if (stream) delete stream; }
 	bool is565() { return is_565; }
 	imageformat format() { return imgformat; }
 	unsigned int numframes() { return m_numframes; }
 	unsigned int width(unsigned int frame) { return widths[frame]; }
 	unsigned int height(unsigned int frame) { return heights[frame]; }
+	unsigned int maxWidth() { if (!maxwidth) findMaxSize(); return maxwidth; }
+	unsigned int maxHeight() { if (!maxheight) findMaxSize(); return maxheight; }
+	void findMaxSize();
 	void *data(unsigned int frame) { return buffers[frame]; }
 	std::string getName() { return name; }
 
 	virtual bool hasCustomPalette() { return false; }
 	virtual uint8 *getCustomPalette();
 	
-	virtual bool transparentAt(unsigned int frame, unsigned int x, unsigned int y);
+	bool transparentAt(unsigned int frame, unsigned int x, unsigned int y) {
+		if (frame >= masks.size() || masks[frame].empty()) buildMask(frame);
+		unsigned int bit = y * widths[frame] + x;
+		return (masks[frame][bit >> 5] >> (bit & 31)) & 1;
+	}
 	virtual boost::shared_ptr<creaturesImage> mutableCopy();
 	virtual void tint(unsigned char r, unsigned char g, unsigned char b, unsigned char rotation, unsigned char swap);
 };
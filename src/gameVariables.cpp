@@ -0,0 +1,125 @@
+/*
+ *  gameVariables.cpp
+ *  openc2e
+ *
+ *  Created by the openc2e team on Mon Oct 19 2026.
+ *  Copyright (c) 2026 the openc2e team. All rights reserved.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ */
+
+
+#include "gameVariables.h"
+#include <cassert>
+
+unsigned int gameVariables::intern(const std::string &name) {
+	std::map<std::string, unsigned int>::iterator i = names.find(name);
+	if (i != names.end())
+		return i->second;
+
+	unsigned int s;
+	if (freeslots.empty()) {
+		s = entries.size();
+		entries.push_back(entry());
+	} else {
+		s = freeslots.back();
+		freeslots.pop_back();
+	}
+
+	entry &e = entries[s];
+	e.name = name;
+	e.present = false;
+	e.pinned = false;
+	names[name] = s;
+	return s;
+}
+
+unsigned int gameVariables::slot(const std::string &name) {
+	unsigned int s = intern(name);
+	entries[s].pinned = true;
+	return s;
+}
+
+// forget the name of an absent, unpinned variable, so its slot can be reused
+void gameVariables::release(std::map<std::string, unsigned int>::iterator i) {
+	entry &e = entries[i->second];
+	assert(!e.present && !e.pinned);
+	e.name.clear();
+	freeslots.push_back(i->second);
+	names.erase(i);
+}
+
+const caosVar *gameVariables::find(const std::string &name) const {
+	std::map<std::string, unsigned int>::const_iterator i = names.find(name);
+	if (i == names.end())
+		return NULL;
+	return find(i->second);
+}
+
+void gameVariables::erase(const std::string &name) {
+	std::map<std::string, unsigned int>::iterator i = names.find(name);
+	if (i == names.end())
+		return;
+	entry &e = entries[i->second];
+	if (!e.present)
+		return;
+	e.present = false;
+	e.value = caosVar(); // don't keep strings or agents around
+	count--;
+	if (!e.pinned)
+		release(i);
+}
+
+void gameVariables::clear() {
+	for (std::deque<entry>::iterator i = entries.begin(); i != entries.end(); i++) {
+		i->present = false;
+		i->value = caosVar();
+	}
+	count = 0;
+
+	std::map<std::string, unsigned int>::iterator i = names.begin();
+	while (i != names.end()) {
+		std::map<std::string, unsigned int>::iterator n = i; n++;
+		if (!entries[i->second].pinned)
+			release(i);
+		i = n;
+	}
+}
+
+std::string gameVariables::first() const {
+	for (std::map<std::string, unsigned int>::const_iterator i = names.begin(); i != names.end(); i++)
+		if (entries[i->second].present)
+			return i->first;
+	return std::string();
+}
+
+std::string gameVariables::next(const std::string &previous) const {
+	for (std::map<std::string, unsigned int>::const_iterator i = names.upper_bound(previous); i != names.end(); i++)
+		if (entries[i->second].present)
+			return i->first;
+	return std::string();
+}
+
+void gameVariables::save(std::map<std::string, caosVar> &m) const {
+	m.clear();
+	for (std::deque<entry>::const_iterator i = entries.begin(); i != entries.end(); i++)
+		if (i->present)
+			m[i->name] = i->value;
+}
+
+void gameVariables::load(const std::map<std::string, caosVar> &m) {
+	clear();
+	for (std::map<std::string, caosVar>::const_iterator i = m.begin(); i != m.end(); i++)
+		(*this)[i->first] = i->second;
+}
+
+/* vim: set noet: */
@@ -0,0 +1,91 @@
+/*
+ *  gameVariables.h
+ *  openc2e
+ *
+ *  Created by the openc2e team on Mon Oct 19 2026.
+ *  Copyright (c) 2026 the openc2e team. All rights reserved.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ */
+
+
+#ifndef _GAMEVARIABLES_H
+#define _GAMEVARIABLES_H
+
+#include "caosVar.h"
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+/*
+ * The GAME variables, with their names interned into slots.
+ *
+ * Scripts and engine code intern a name once with slot() and then access
+ * the variable by slot, which is just an index; such slots are pinned, and
+ * keep their name for as long as the store exists (deleting the variable
+ * only marks it as absent). Names which were only ever used by name are
+ * dropped when the variable is deleted, and their slots reused.
+ */
+class gameVariables {
+protected:
+	struct entry {
+		std::string name;
+		caosVar value;
+		bool present;
+		bool pinned;
+	};
+
+	std::deque<entry> entries; // a deque, so references survive new slots
+	std::map<std::string, unsigned int> names;
+	std::vector<unsigned int> freeslots;
+	unsigned int count;
+
+	unsigned int intern(const std::string &name);
+	void release(std::map<std::string, unsigned int>::iterator i);
+
+public:
+	gameVariables() : count(0) { }
+
+	unsigned int slot(const std::string &name);
+
+	// like std::map::operator[], these create the variable if necessary
+	caosVar &get(unsigned int s) {
+		entry &e = entries[s];
+		if (!e.present) {
+			e.present = true;
+			e.value = caosVar();
+			count++;
+		}
+		return e.value;
+	}
+	caosVar &operator[](const std::string &name) { return get(intern(name)); }
+
+	// .. and these return NULL instead
+	const caosVar *find(unsigned int s) const { return entries[s].present ? &entries[s].value : NULL; }
+	const caosVar *find(const std::string &name) const;
+
+	void erase(const std::string &name);
+	void clear();
+	unsigned int size() const { return count; }
+
+	// name order, as GAMN wants; both return an empty string at the end
+	std::string first() const;
+	std::string next(const std::string &previous) const;
+
+	// for serialisation
+	void save(std::map<std::string, caosVar> &m) const;
+	void load(const std::map<std::string, caosVar> &m);
+};
+
+#endif
+/* vim: set noet: */
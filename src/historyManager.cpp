@@ -74,7 +74,7 @@ historyevent &monikerData::addEvent(unsigned int event, std::string moniker1, st
 	events.back().monikers[0] = moniker1;
 	events.back().monikers[1] = moniker2;
 
-	for (std::list<boost::shared_ptr<Agent> >::iterator i = world.agents.begin(); i != world.agents.end(); i++) {
+	for (agentRegistry::iterator i = world.agents.begin(); i != world.agents.end(); i++) {
 		if (!*i) continue;
 
 		(*i)->queueScript(127, 0, moniker, (int)(events.size() - 1)); // new life event
@@ -224,6 +224,24 @@ std::string historyManager::findMoniker(AgentRef a) {
 	return "";
 }
 
+/*
+ * Points a moniker at a genome which was just loaded (see agentSnapshot), and
+ * at the agent holding it, if the moniker's still just a genome in a slot.
+ * Monikers we've never heard of are added.
+ */
+void historyManager::restoreMoniker(std::string s, shared_ptr<genomeFile> genome, AgentRef holder) {
+	std::map<std::string, monikerData>::iterator i = monikers.find(s);
+	if (i == monikers.end()) {
+		monikers[s].init(s, genome);
+		i = monikers.find(s);
+	}
+
+	i->second.genome = genome;
+	monikerstatus status = i->second.getStatus();
+	if (status == referenced || status == unreferenced)
+		i->second.moveToAgent(holder);
+}
+
 void historyManager::delMoniker(std::string s) {
 	std::map<std::string, monikerData>::iterator i = monikers.find(s);
 	if (i == monikers.end()) throw creaturesException("getMoniker was called with a non-existant moniker");
@@ -84,6 +84,7 @@ public:
 	std::string findMoniker(shared_ptr<genomeFile>);
 	std::string findMoniker(AgentRef);
 	void delMoniker(std::string);
+	void restoreMoniker(std::string, shared_ptr<genomeFile>, AgentRef);
 };
 
 #endif
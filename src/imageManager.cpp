@@ -174,4 +174,58 @@ shared_ptr<creaturesImage> imageManager::getImage(std::string name, bool is_back
 	return img;
 }
 
+bool imageManager::tintKey::operator < (const tintKey &o) const {
+	if (source != o.source) return source < o.source;
+	if (r != o.r) return r < o.r;
+	if (g != o.g) return g < o.g;
+	if (b != o.b) return b < o.b;
+	if (rotation != o.rotation) return rotation < o.rotation;
+	return swap < o.swap;
+}
+
+/*
+ * Retrieve a tinted copy of a sprite. Copies are shared between everyone asking
+ * for the same tint of the same sprite (eg, every creature of a breed), so callers
+ * must treat the result as read-only, just like the sprites from getImage.
+ */
+shared_ptr<creaturesImage> imageManager::getTintedImage(shared_ptr<creaturesImage> source, unsigned char r, unsigned char g, unsigned char b, unsigned char rotation, unsigned char swap) {
+	assert(source);
+
+	if (r == 128 && g == 128 && b == 128 && rotation == 128 && swap == 128) return source; // no-op tint
+
+	tintKey key;
+	key.source = source.get();
+	key.r = r; key.g = g; key.b = b; key.rotation = rotation; key.swap = swap;
+
+	std::map<tintKey, tintEntry>::iterator i = tints.find(key);
+	if (i != tints.end()) {
+		// the source pointer might have been recycled for a different sprite, so check it's still the same one
+		shared_ptr<creaturesImage> tinted = i->second.tinted.lock();
+		if (tinted && i->second.source.lock() == source) return tinted;
+	}
+
+	shared_ptr<creaturesImage> tinted = source->mutableCopy();
+	tinted->tint(r, g, b, rotation, swap);
+
+	tintEntry &entry = tints[key];
+	entry.source = source;
+	entry.tinted = tinted;
+
+	if (++tintsSinceCleanup > 256) cleanupTints();
+
+	return tinted;
+}
+
+void imageManager::cleanupTints() {
+	tintsSinceCleanup = 0;
+
+	std::map<tintKey, tintEntry>::iterator i = tints.begin();
+	while (i != tints.end()) {
+		if (i->second.tinted.expired() || i->second.source.expired())
+			tints.erase(i++);
+		else
+			i++;
+	}
+}
+
 /* vim: set noet: */
@@ -30,8 +30,23 @@ class imageManager {
 protected:
 	std::map<std::string, boost::weak_ptr<creaturesImage> > images;
 
+	struct tintKey {
+		creaturesImage *source;
+		unsigned char r, g, b, rotation, swap;
+		bool operator < (const tintKey &o) const;
+	};
+	struct tintEntry {
+		boost::weak_ptr<creaturesImage> source, tinted;
+	};
+	std::map<tintKey, tintEntry> tints;
+	unsigned int tintsSinceCleanup;
+
+	void cleanupTints();
+
 public:
+	imageManager() { tintsSinceCleanup = 0; }
 	boost::shared_ptr<creaturesImage> getImage(std::string name, bool is_background = false);
+	boost::shared_ptr<creaturesImage> getTintedImage(boost::shared_ptr<creaturesImage> source, unsigned char r, unsigned char g, unsigned char b, unsigned char rotation, unsigned char swap);
 };
 
 #endif
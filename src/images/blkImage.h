@@ -37,7 +37,6 @@ public:
 	void readHeader(std::istream &in);
 	void writeHeader(std::ostream &s);
 	virtual std::string serializedName() { return name + ".blk"; }
-	bool transparentAt(unsigned int frame, unsigned int x, unsigned int y) { (void)frame; (void)x; (void)y; return false; }
 
 	friend class fileSwapper;
 };
@@ -26,19 +26,24 @@ class c16Image : public creaturesImage {
 private:
 	unsigned int **lineoffsets;
 
+protected:
+	bool pixelTransparent(unsigned int frame, unsigned int x, unsigned int y);
+
 public:
 	c16Image() { }
 	c16Image(mmapifstream *, std::string n);
 	~c16Image();
 	void readHeader(std::istream &in);
 	boost::shared_ptr<creaturesImage> mutableCopy();
-	bool transparentAt(unsigned int frame, unsigned int x, unsigned int y);
 };
 
 class s16Image : public creaturesImage {
 private:
 	uint32 *offsets;
 
+protected:
+	bool pixelTransparent(unsigned int frame, unsigned int x, unsigned int y);
+
 public:
 	s16Image() { }
 	s16Image(mmapifstream *, std::string n);
@@ -47,7 +52,6 @@ public:
 	void writeHeader(std::ostream &out);
 	boost::shared_ptr<creaturesImage> mutableCopy();
 	void tint(unsigned char r, unsigned char g, unsigned char b, unsigned char rotation, unsigned char swap);
-	bool transparentAt(unsigned int frame, unsigned int x, unsigned int y);
 
 	friend class c16Image;
 	friend class fileSwapper;
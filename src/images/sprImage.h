@@ -28,12 +28,14 @@ class sprImage : public creaturesImage {
 private:
 	uint32 *offsets;
 
+protected:
+	bool pixelTransparent(unsigned int frame, unsigned int x, unsigned int y);
+
 public:
 	sprImage() { }
 	sprImage(mmapifstream *, std::string n);
 	~sprImage();
 	virtual unsigned int bitdepth() { return 8; }
-	bool transparentAt(unsigned int frame, unsigned int x, unsigned int y);
 	void fixBufferOffsets();
 };
 
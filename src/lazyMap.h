@@ -0,0 +1,96 @@
+/*
+ *  lazyMap.h
+ *  openc2e
+ *
+ *  Created by the openc2e team on Mon Oct 19 2026.
+ *  Copyright (c) 2026 the openc2e team. All rights reserved.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ */
+
+
+#ifndef _LAZYMAP_H
+#define _LAZYMAP_H
+
+#include <map>
+#include <functional>
+
+/*
+ * A std::map which costs a single pointer until something is actually
+ * inserted into it. Agents carry a handful of these (ports, carry points,
+ * genome slots, NAME variables) and almost all of them stay empty, so
+ * paying for a full map header in every agent adds up quickly.
+ *
+ * Iterators are plain std::map iterators; while the map is unallocated,
+ * begin()/end()/find() hand out iterators into a shared empty map.
+ */
+template <class K, class V, class C = std::less<K> >
+class lazyMap {
+public:
+	typedef std::map<K, V, C> map_type;
+	typedef typename map_type::iterator iterator;
+	typedef typename map_type::const_iterator const_iterator;
+	typedef typename map_type::size_type size_type;
+
+protected:
+	map_type *m;
+
+	static map_type &none() { static map_type n; return n; }
+	void release() { delete m; m = 0; }
+
+public:
+	lazyMap() : m(0) { }
+	lazyMap(const lazyMap &o) : m(o.m ? new map_type(*o.m) : 0) { }
+	~lazyMap() { delete m; }
+
+	lazyMap &operator=(const lazyMap &o) {
+		if (this == &o) return *this;
+		release();
+		if (o.m) m = new map_type(*o.m);
+		return *this;
+	}
+
+	// forces allocation
+	map_type &get() { if (!m) m = new map_type; return *m; }
+	bool allocated() const { return m != 0; }
+
+	V &operator[](const K &k) { return get()[k]; }
+
+	iterator begin() { return m ? m->begin() : none().begin(); }
+	iterator end() { return m ? m->end() : none().end(); }
+	const_iterator begin() const { return m ? m->begin() : none().begin(); }
+	const_iterator end() const { return m ? m->end() : none().end(); }
+
+	iterator find(const K &k) { return m ? m->find(k) : none().end(); }
+	const_iterator find(const K &k) const { return m ? m->find(k) : none().end(); }
+
+	size_type size() const { return m ? m->size() : 0; }
+	bool empty() const { return !m || m->empty(); }
+
+	void erase(iterator i) { m->erase(i); if (m->empty()) release(); }
+	size_type erase(const K &k) {
+		if (!m) return 0;
+		size_type n = m->erase(k);
+		if (m->empty()) release();
+		return n;
+	}
+	void clear() { release(); }
+
+	// rough heap footprint, for DBG: SIZO
+	unsigned int heapBytes() const {
+		if (!m) return 0;
+		return sizeof(map_type) + m->size() * (sizeof(typename map_type::value_type) + 4 * sizeof(void *));
+	}
+};
+
+#endif
+/* vim: set noet: */
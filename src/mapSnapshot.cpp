@@ -0,0 +1,271 @@
+/*
+ *  mapSnapshot.cpp
+ *  openc2e
+ *
+ *  Created by the openc2e team on Mon Oct 19 2026.
+ *  Copyright (c) 2026 the openc2e team. All rights reserved.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ */
+
+#include "mapSnapshot.h"
+#include "exceptions.h"
+#include "zlib.h"
+
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <set>
+#include <boost/filesystem/path.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <boost/filesystem/convenience.hpp>
+#include <boost/bind.hpp>
+#include <boost/format.hpp>
+
+namespace fs = boost::filesystem;
+
+/*
+ * Compressed sections are stored as the uncompressed size (4 bytes, little
+ * endian) followed by the zlib stream.
+ */
+static std::string compressSection(const std::string &data, int level) {
+	uLongf destlen = compressBound(data.size());
+	std::string out(4 + destlen, '\0');
+	unsigned int len = data.size();
+	for (unsigned int i = 0; i < 4; i++)
+		out[i] = (char)((len >> (i * 8)) & 0xff);
+
+	if (compress2((Bytef *)&out[4], &destlen, (const Bytef *)data.data(), data.size(), level) != Z_OK)
+		throw creaturesException("failed to compress map snapshot section");
+	out.resize(4 + destlen);
+	return out;
+}
+
+static std::string uncompressSection(const std::string &data) {
+	if (data.size() < 4)
+		throw creaturesException("truncated map snapshot section");
+	uLongf len = 0;
+	for (unsigned int i = 0; i < 4; i++)
+		len |= ((uLongf)(unsigned char)data[i]) << (i * 8);
+
+	std::string out(len, '\0');
+	uLongf destlen = len;
+	if (len && uncompress((Bytef *)&out[0], &destlen, (const Bytef *)data.data() + 4, data.size() - 4) != Z_OK)
+		throw creaturesException("failed to decompress map snapshot section");
+	if (destlen != len)
+		throw creaturesException("map snapshot section has the wrong size");
+	return out;
+}
+
+/*
+ * Reads the header and section file names from a manifest, into 's'. If the
+ * manifest is missing but a finished temporary one exists, a save was
+ * interrupted just as it was replacing the manifest, so that one is used.
+ */
+static bool readManifest(const std::string &dir, mapSnapshot &s) {
+	std::ifstream m((dir + "/manifest").c_str());
+	if (!m.is_open()) {
+		m.clear();
+		m.open((dir + "/manifest.tmp").c_str());
+		if (!m.is_open())
+			return false;
+	}
+
+	std::string header, format;
+	std::getline(m, header);
+	std::istringstream h(header);
+	h >> format >> s.tick >> s.compression;
+	if (!(h >> s.generation))
+		s.generation = 0; // older manifests didn't have one
+	if (format != "text" && format != "binary")
+		throw creaturesException("unknown map snapshot format '" + format + "'");
+	s.text = (format == "text");
+
+	s.files.clear();
+	std::string line;
+	while (std::getline(m, line)) {
+		std::istringstream l(line);
+		std::string name, file;
+		if (!(l >> name)) continue;
+		if (!(l >> file))
+			file = name + ".snap";
+		s.files[name] = file;
+	}
+
+	return true;
+}
+
+/*
+ * Writes the snapshot to the given directory, as one file per section plus a
+ * manifest. If 'previous' is the snapshot which was last written to the same
+ * directory, sections which haven't changed since then are left alone.
+ *
+ * New section files get new names (including the generation), and only the
+ * manifest refers to them, so the manifest is always in step with the files
+ * it names: replacing it is what commits the save. Files which no longer
+ * belong to any snapshot are removed afterwards.
+ *
+ * Returns the number of bytes of section data written.
+ */
+unsigned int mapSnapshot::write(const std::string &dir, const mapSnapshot *previous) {
+	fs::path p(dir, fs::native);
+	if (!fs::exists(p))
+		fs::create_directories(p);
+	if (!fs::is_directory(p))
+		throw creaturesException("couldn't create world directory '" + dir + "'");
+
+	// never reuse a name which the manifest on disk might still refer to
+	mapSnapshot ondisk;
+	generation = previous ? previous->generation : 0;
+	if (readManifest(dir, ondisk) && ondisk.generation > generation)
+		generation = ondisk.generation;
+	generation++;
+
+	unsigned int written = 0;
+	files.clear();
+	for (std::map<std::string, std::string>::const_iterator i = sections.begin(); i != sections.end(); i++) {
+		if (previous && previous->text == text && previous->compression == compression) {
+			std::map<std::string, std::string>::const_iterator old = previous->sections.find(i->first);
+			std::map<std::string, std::string>::const_iterator oldfile = previous->files.find(i->first);
+			if (old != previous->sections.end() && old->second == i->second && oldfile != previous->files.end()
+				&& fs::exists(fs::path(dir + "/" + oldfile->second, fs::native))) {
+				files[i->first] = oldfile->second;
+				continue;
+			}
+		}
+
+		// write to a temporary file first, so an interrupted save doesn't leave a half-written section
+		std::string file = boost::str(boost::format("%s.%u.snap") % i->first % generation);
+		std::string filename = dir + "/" + file;
+		std::ofstream f((filename + ".tmp").c_str(), std::ios::binary | std::ios::trunc);
+		if (compression >= 0) {
+			std::string data = compressSection(i->second, compression);
+			f.write(data.data(), data.size());
+		} else {
+			f.write(i->second.data(), i->second.size());
+		}
+		f.close();
+		if (f.fail())
+			throw creaturesException("couldn't write map snapshot file '" + filename + "'");
+
+		fs::rename(fs::path(filename + ".tmp", fs::native), fs::path(filename, fs::native));
+		files[i->first] = file;
+		written += i->second.size();
+	}
+
+	// the manifest goes last, via a temporary file, and names the section files belonging to this snapshot
+	std::string manifest = dir + "/manifest";
+	std::ofstream m((manifest + ".tmp").c_str(), std::ios::trunc);
+	m << (text ? "text" : "binary") << " " << tick << " " << compression << " " << generation << std::endl;
+	for (std::map<std::string, std::string>::const_iterator i = files.begin(); i != files.end(); i++)
+		m << i->first << " " << i->second << std::endl;
+	m.close();
+	if (m.fail())
+		throw creaturesException("couldn't write map snapshot manifest '" + manifest + "'");
+
+	fs::path final(manifest, fs::native);
+	if (fs::exists(final)) fs::remove(final);
+	fs::rename(fs::path(manifest + ".tmp", fs::native), final);
+
+	// tidy up section files left over from older snapshots
+	std::set<std::string> keep;
+	for (std::map<std::string, std::string>::const_iterator i = files.begin(); i != files.end(); i++)
+		keep.insert(i->second);
+	fs::directory_iterator end;
+	for (fs::directory_iterator i(p); i != end; ++i) {
+		std::string leaf = i->path().leaf();
+		bool snapfile = (leaf.size() > 5 && leaf.substr(leaf.size() - 5) == ".snap") || (leaf.size() > 9 && leaf.substr(leaf.size() - 9) == ".snap.tmp");
+		if (snapfile && keep.find(leaf) == keep.end()) {
+			try {
+				fs::remove(i->path());
+			} catch (std::exception &e) {
+				std::cerr << "couldn't remove old map snapshot file '" << leaf << "': " << e.what() << std::endl;
+			}
+		}
+	}
+
+	return written;
+}
+
+void mapSnapshot::read(const std::string &dir) {
+	if (!readManifest(dir, *this))
+		throw creaturesException("couldn't find a saved world in '" + dir + "'");
+
+	sections.clear();
+	for (std::map<std::string, std::string>::iterator i = files.begin(); i != files.end(); i++) {
+		std::string filename = dir + "/" + i->second;
+		std::ifstream f(filename.c_str(), std::ios::binary);
+		if (!f.is_open())
+			throw creaturesException("missing map snapshot file '" + filename + "'");
+		std::ostringstream data;
+		data << f.rdbuf();
+		if (compression >= 0)
+			sections[i->first] = uncompressSection(data.str());
+		else
+			sections[i->first] = data.str();
+	}
+}
+
+unsigned int mapSnapshot::size() const {
+	unsigned int total = 0;
+	for (std::map<std::string, std::string>::const_iterator i = sections.begin(); i != sections.end(); i++)
+		total += i->second.size();
+	return total;
+}
+
+snapshotWriter::snapshotWriter(boost::shared_ptr<mapSnapshot> s, boost::shared_ptr<mapSnapshot> prev, std::string d) {
+	snapshot = s;
+	previous = prev;
+	dir = d;
+	finished = false;
+	succeeded = false;
+	written = 0;
+	thread = new boost::thread(boost::bind(&snapshotWriter::run, this));
+}
+
+snapshotWriter::~snapshotWriter() {
+	join();
+}
+
+void snapshotWriter::run() {
+	bool ok = false;
+	std::string err;
+	unsigned int bytes = 0;
+
+	try {
+		snapshot->capture(snapshot->text);
+		bytes = snapshot->write(dir, previous.get());
+		ok = true;
+	} catch (std::exception &e) {
+		err = e.what();
+	}
+
+	boost::mutex::scoped_lock l(lock);
+	succeeded = ok;
+	error = err;
+	written = bytes;
+	finished = true;
+}
+
+bool snapshotWriter::done() {
+	boost::mutex::scoped_lock l(lock);
+	return finished;
+}
+
+void snapshotWriter::join() {
+	if (!thread) return;
+	thread->join();
+	delete thread;
+	thread = 0;
+}
+
+/* vim: set noet: */
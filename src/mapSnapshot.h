@@ -0,0 +1,111 @@
+/*
+ *  mapSnapshot.h
+ *  openc2e
+ *
+ *  Created by the openc2e team on Mon Oct 19 2026.
+ *  Copyright (c) 2026 the openc2e team. All rights reserved.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ */
+
+#ifndef _MAPSNAPSHOT_H
+#define _MAPSNAPSHOT_H
+
+#include <map>
+#include <string>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+
+/*
+ * A serialised copy of the world, taken at a tick boundary: the map, the
+ * scriptorium, game variables and clock, and the agents and their genomes
+ * (see agentSnapshot for which agents are covered, and what isn't kept).
+ * SAVE/LOAD and --autosave use it.
+ *
+ * The state is split into named sections, each of which is a separate archive,
+ * so a save only needs to rewrite the sections which changed since the previous
+ * one (see write()). Capturing and restoring need the (experimental)
+ * serialization code; builds without it throw a creaturesException.
+ *
+ * Saving is done in two steps too: copyWorld() takes a private copy of the
+ * state on the main thread, which is quick, and capture() serialises that copy,
+ * which can then happen on a snapshotWriter's thread while the world carries
+ * on ticking. The copy is copy-on-write in effect: the map, game variables and
+ * agents are copied outright (agents as agentSnapshot records), while scripts,
+ * strings and genes are shared, since nothing modifies those once they exist.
+ * So whatever the world does after copyWorld(), the writer saves the world as
+ * it was then. Once captured, a snapshot's sections are never modified.
+ *
+ * Loading is done in two steps: stage() deserialises everything into scratch
+ * objects, which can fail (and throws) without affecting the world, and then
+ * restore() swaps them in.
+ */
+class mapSnapshot {
+protected:
+	struct stagedState;
+	boost::shared_ptr<stagedState> staged;
+
+public:
+	std::map<std::string, std::string> sections;
+	std::map<std::string, std::string> files; // section files, as of the last write() or read()
+	unsigned int tick;
+	unsigned int generation; // bumped by each write(), to name new section files
+	bool text;
+	int compression; // zlib level used by write(), or -1 for none
+
+	mapSnapshot() { tick = 0; generation = 0; text = false; compression = -1; }
+
+	void copyWorld();
+	void capture(bool textarchive = false);
+	void stage();
+	void restore();
+
+	unsigned int write(const std::string &dir, const mapSnapshot *previous = 0);
+	void read(const std::string &dir);
+	unsigned int size() const;
+
+	static std::string benchmark();
+	static bool supported();
+};
+
+/*
+ * Serialises (see mapSnapshot::copyWorld), compresses and writes a snapshot
+ * on a worker thread. The owner must poll
+ * done() and then call join() before reading the results or destroying it.
+ */
+class snapshotWriter {
+protected:
+	boost::shared_ptr<mapSnapshot> snapshot, previous;
+	std::string dir;
+	boost::thread *thread;
+	boost::mutex lock;
+	bool finished;
+
+	void run();
+
+public:
+	bool succeeded;
+	std::string error;
+	unsigned int written;
+
+	snapshotWriter(boost::shared_ptr<mapSnapshot> s, boost::shared_ptr<mapSnapshot> prev, std::string d);
+	~snapshotWriter();
+
+	bool done();
+	void join();
+	boost::shared_ptr<mapSnapshot> getSnapshot() { return snapshot; }
+	const std::string &getDir() { return dir; }
+};
+
+#endif
+/* vim: set noet: */
@@ -32,48 +32,87 @@ mmapifstream::mmapifstream(std::string filename) {
 	mmapopen(filename);
 }
 
+/*
+ * Open and map the file. Empty or unreadable files leave the stream closed
+ * with failbit set (and live false); if the mapping itself fails, the file
+ * is read into a heap buffer instead, so callers can use map regardless.
+ */
 void mmapifstream::mmapopen(std::string filename) {
+	unmap();
+
 	open(filename.c_str(), std::ios::binary);
 	if (!is_open()) return;
 
+	seekg(0, std::ios::end);
+	std::streamoff size = tellg();
+	seekg(0, std::ios::beg);
+	if (size <= 0) {
+		close();
+		setstate(failbit);
+		return;
+	}
+	filesize = size;
+
+	void *mapr = 0;
 #ifdef _WIN32
-	// todo: store the handle somewhere?
 	HANDLE hFile = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ,
 		NULL, OPEN_EXISTING, 0, NULL);
-	HANDLE hMap = CreateFileMapping(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
-	void *mapr = MapViewOfFile(hMap, FILE_MAP_READ, 0, 0, 0);
+	if (hFile != INVALID_HANDLE_VALUE) {
+		HANDLE hMap = CreateFileMapping(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (hMap) {
+			mapr = MapViewOfFile(hMap, FILE_MAP_READ, 0, 0, 0);
+			CloseHandle(hMap); // the view keeps the mapping alive
+		}
+		CloseHandle(hFile);
+	}
 #else
 	FILE *f = fopen(filename.c_str(), "r");
-	assert(f);
-/*	if (!f) {
-		close();
-		setstate(failbit);
-		perror("fopen");
-		return;
-	} */
-
-	// now do the mmap (work out filesize, then mmap)
-	int fno = fileno(f);
-	seekg(0, std::ios::end);
-	filesize = tellg();
-	assert((int)filesize != -1);
-	seekg(0, std::ios::beg);
-
-	void *mapr = mmap(0, filesize, PROT_READ, MAP_PRIVATE, fno, 0);
-	fclose(f); // we don't need it, now!
+	if (f) {
+		mapr = mmap(0, filesize, PROT_READ, MAP_PRIVATE, fileno(f), 0);
+		if (mapr == MAP_FAILED) mapr = 0;
+		fclose(f); // we don't need it, now!
+	}
 #endif
 
-	assert(mapr != (void *)-1);
-	map = (char *)mapr;
+	if (mapr) {
+		map = (char *)mapr;
+		mapped = true;
+	} else {
+		// couldn't map it, so fall back to reading the whole thing in
+		map = new char[filesize];
+		read(map, filesize);
+		if (gcount() != (std::streamsize)filesize) {
+			delete[] map;
+			map = 0;
+			close();
+			setstate(failbit);
+			return;
+		}
+		clear();
+		seekg(0, std::ios::beg);
+		mapped = false;
+	}
 	live = true;
 }
 
-mmapifstream::~mmapifstream() {
-	if (live)
+void mmapifstream::unmap() {
+	if (!live) return;
+
+	if (mapped) {
 #ifdef _WIN32
 		UnmapViewOfFile(map);
 #else
 		munmap(map, filesize);
 #endif
+	} else
+		delete[] map;
+
+	map = 0;
+	live = false;
+}
+
+mmapifstream::~mmapifstream() {
+	unmap();
 }
+
 /* vim: set noet: */
@@ -33,6 +33,10 @@ public:
 	mmapifstream(std::string filename);
 	~mmapifstream();
 	void mmapopen(std::string filename);
+
+protected:
+	bool mapped; // false if map is a heap copy (the mmap failed)
+	void unmap();
 };
 
 #endif
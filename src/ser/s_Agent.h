@@ -6,11 +6,14 @@
 #include "serialization.h"
 #include "Agent.h"
 
+// not used yet: world snapshots save agents as agentSnapshot records instead,
+// and that re-registers their IMSK flags on restore
 SERIALIZE(Agent) {
 	assert(!obj.dying);
 
-	ar & obj.var;
-	ar & obj.name_variables;
+	for (unsigned int i = 0; i < agentVariables::count; i++)
+		ar & obj.var[i];
+	ar & obj.name_variables.get();
 #if 0
 	if (1 <= version)
 		ar & slots;
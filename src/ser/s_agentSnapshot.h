@@ -0,0 +1,97 @@
+/*
+ *  s_agentSnapshot.h
+ *  openc2e
+ *
+ *  Created by the openc2e team on Mon Oct 19 2026.
+ *  Copyright (c) 2026 the openc2e team. All rights reserved.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ */
+
+#ifndef S_AGENTSNAPSHOT_H
+#define S_AGENTSNAPSHOT_H 1
+
+#include "agentSnapshot.h"
+#include "serialization.h"
+#include "ser/s_caosVar.h"
+#include "ser/s_genome.h"
+
+SERIALIZE(savedValue) {
+	ar & obj.value & obj.isagent & obj.unid;
+}
+
+SERIALIZE(savedPart) {
+	ar & obj.kind & obj.id & obj.x & obj.y & obj.zorder;
+	ar & obj.sprite & obj.firstimg & obj.base & obj.pose & obj.frameno;
+	ar & obj.framerate & obj.is_transparent & obj.has_alpha & obj.alpha;
+	ar & obj.animation;
+
+	ar & obj.hoveranimation & obj.messageid & obj.hitopaquepixelsonly;
+
+	ar & obj.text & obj.fontsprite;
+	ar & obj.leftmargin & obj.topmargin & obj.rightmargin & obj.bottommargin;
+	ar & obj.linespacing & obj.charspacing & obj.horz_align & obj.vert_align;
+	ar & obj.last_page_scroll & obj.page;
+
+	ar & obj.viewwidth & obj.viewheight & obj.camerawidth & obj.cameraheight & obj.refreshdivisor;
+}
+
+SERIALIZE(savedAgent) {
+	ar & obj.kind & obj.unid;
+	ar & obj.family & obj.genus & obj.species;
+	ar & obj.zorder & obj.x & obj.y;
+
+	ar & obj.attr & obj.bhvr & obj.imsk;
+	ar & obj.paused & obj.visible & obj.displaycore & obj.falling;
+	for (unsigned int i = 0; i < 3; i++)
+		ar & obj.clac[i];
+	ar & obj.clik;
+	ar & obj.tickssincelasttimer & obj.timerrate;
+
+	ar & obj.velx & obj.vely & obj.accg & obj.aero & obj.rest & obj.range;
+	ar & obj.friction & obj.perm & obj.elas;
+	ar & obj.has_custom_core_size;
+	ar & obj.custom_core_xleft & obj.custom_core_xright & obj.custom_core_ytop & obj.custom_core_ybottom;
+	ar & obj.objp & obj.babymoniker & obj.actv & obj.thrt & obj.size;
+
+	ar & obj.vars & obj.namevars & obj.genomes;
+	ar & obj.carrying & obj.carriedby & obj.invehicle & obj.floatingagent;
+
+	ar & obj.parts;
+
+	if (obj.kind == simpleagent) return;
+	for (unsigned int i = 0; i < 6; i++) {
+		for (unsigned int j = 0; j < 4; j++)
+			ar & obj.hotspots[i][j];
+		ar & obj.hotspotfunctions[i] & obj.hotspotmessages[i] & obj.hotspotmasks[i];
+	}
+
+	if (obj.kind == compoundagent) return;
+	ar & obj.capacity & obj.bump & obj.xvec & obj.yvec;
+	ar & obj.cabinleft & obj.cabintop & obj.cabinright & obj.cabinbottom & obj.cabinplane;
+	ar & obj.passengers;
+}
+
+// each genome is written once, however many agents hold it (see agentSnapshot::capture)
+SAVE(savedGenome) {
+	ar & obj.moniker;
+	ar & *obj.genome;
+}
+
+LOAD(savedGenome) {
+	ar & obj.moniker;
+	obj.genome = boost::shared_ptr<genomeFile>(new genomeFile());
+	ar & *obj.genome;
+}
+
+#endif
+/* vim: set noet: */
@@ -16,7 +16,7 @@ SAVE(caosOp) {
 LOAD(caosOp) {
 	uint32_t op;
 	ar & op & obj.traceindex;
-	obj.opcode = op & 0xFF;
+	obj.opcode = (opcode_t)(op & 0xFF);
 	obj.argument = (op >> 8) - 0x800000;
 }
 
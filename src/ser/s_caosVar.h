@@ -6,6 +6,7 @@
 #include <boost/serialization/variant.hpp>
 #include "caosVM.h"
 #include "ser/s_physics.h"
+#include "ser/s_shared_str.h"
 
 // XXX: stub so serialtest works until everything else serializes
 SAVE(AgentRef) {}
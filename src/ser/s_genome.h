@@ -1,7 +1,7 @@
 #ifndef S_GENOME_H
 #define S_GENOME_H 1
 
-#include "genome.h"
+#include "creatures/genome.h"
 #include "serialization.h"
 #include <sstream>
 
@@ -25,9 +25,32 @@
 #include "serialization.h"
 #include "ser/s_creaturesImage.h"
 
-SERIALIZE(MetaRoom) {
+// backgrounds are stored by name, and reloaded from the gallery
+SAVE(MetaRoom) {
 	ar & obj.xloc & obj.yloc & obj.wid & obj.hei;
-	ar & obj.backgrounds & obj.firstback;
+	ar & obj.wraps;
+	ar & obj.id & obj.rooms;
+	std::string first;
+	std::vector<std::string> backs;
+	for (std::map<std::string, shared_ptr<creaturesImage> >::const_iterator i = obj.backgrounds.begin(); i != obj.backgrounds.end(); i++) {
+		if (i->second == obj.firstback) first = i->first;
+		else backs.push_back(i->first);
+	}
+	ar & first & backs;
+}
+
+LOAD(MetaRoom) {
+	ar & obj.xloc & obj.yloc & obj.wid & obj.hei;
+	ar & obj.wraps;
+	ar & obj.id & obj.rooms;
+	std::string first;
+	std::vector<std::string> backs;
+	ar & first & backs;
+	obj.backgrounds.clear();
+	obj.firstback.reset();
+	if (!first.empty()) obj.addBackground(first);
+	for (std::vector<std::string>::iterator i = backs.begin(); i != backs.end(); i++)
+		obj.addBackground(*i);
 }
 
 #endif
@@ -25,6 +25,7 @@
 #include "ser/s_metaroom.h"
 #include "serialization.h"
 #include <boost/serialization/set.hpp>
+#include <boost/serialization/weak_ptr.hpp>
 #include <iostream>
 #include <cassert>
 
@@ -33,7 +34,7 @@ SERIALIZE(RoomDoor) {
 }
 
 SERIALIZE(Room) {
-	ar & obj.doors & obj.nearby;
+	ar & obj.doors;
 	ar & obj.x_left & obj.x_right;
 	ar & obj.y_left_ceiling & obj.y_right_ceiling;
 	ar & obj.y_left_floor & obj.y_right_floor;
@@ -152,7 +152,7 @@ void BrainView::drawOldBrain(oldBrain *b) {
 		for (unsigned int j = 0; j < (*i)->getNoNeurons(); j++) {
 			oldNeuron *dest = (*i)->getNeuron(j);
 			for (unsigned int type = 0; type < 2; type++) {
-				for (std::vector<oldDendrite>::iterator d = dest->dendrites[type].begin();
+				for (oldDendrite *d = dest->dendrites[type].begin();
 					d != dest->dendrites[type].end(); d++) {
 					oldNeuron *src = d->src;
 
@@ -17,6 +17,9 @@ int main() {
     PSIZE(CompoundAgent);
     PSIZE(PointerAgent);
     PSIZE(SimpleAgent);
+    PSIZE(agentVariables);
+    typedef lazyMap<caosVar, caosVar, caosVarCompare> nameVariables;
+    PSIZE(nameVariables);
     
     PSIZE(AgentRef);
     PSIZE(variant);
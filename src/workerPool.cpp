@@ -0,0 +1,91 @@
+/*
+ *  workerPool.cpp
+ *  openc2e
+ *
+ *  Created by the openc2e team on Mon Oct 19 2026.
+ *  Copyright (c) 2026 the openc2e team. All rights reserved.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ */
+
+
+#include "workerPool.h"
+#include <boost/bind.hpp>
+#include <cassert>
+
+workerPool::workerPool(unsigned int size) {
+	assert(size > 0);
+	generation = 0;
+	running = 0;
+	stopping = false;
+	for (unsigned int i = 1; i < size; i++)
+		threads.push_back(new boost::thread(boost::bind(&workerPool::work, this, i)));
+}
+
+workerPool::~workerPool() {
+	{
+		boost::mutex::scoped_lock l(lock);
+		stopping = true;
+		wake.notify_all();
+	}
+	for (std::vector<boost::thread *>::iterator i = threads.begin(); i != threads.end(); i++) {
+		(*i)->join();
+		delete *i;
+	}
+}
+
+void workerPool::work(unsigned int n) {
+	unsigned int seen = 0;
+
+	while (true) {
+		boost::function<void (unsigned int, unsigned int)> j;
+		{
+			boost::mutex::scoped_lock l(lock);
+			while (!stopping && generation == seen)
+				wake.wait(l);
+			if (stopping) return;
+			seen = generation;
+			j = job;
+		}
+
+		j(n, size());
+
+		boost::mutex::scoped_lock l(lock);
+		if (--running == 0)
+			finished.notify_one();
+	}
+}
+
+void workerPool::run(boost::function<void (unsigned int, unsigned int)> j) {
+	if (threads.empty()) {
+		j(0, 1);
+		return;
+	}
+
+	{
+		boost::mutex::scoped_lock l(lock);
+		assert(running == 0);
+		job = j;
+		running = threads.size();
+		generation++;
+		wake.notify_all();
+	}
+
+	j(0, size());
+
+	boost::mutex::scoped_lock l(lock);
+	while (running != 0)
+		finished.wait(l);
+	job.clear();
+}
+
+/* vim: set noet: */
@@ -0,0 +1,60 @@
+/*
+ *  workerPool.h
+ *  openc2e
+ *
+ *  Created by the openc2e team on Mon Oct 19 2026.
+ *  Copyright (c) 2026 the openc2e team. All rights reserved.
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ */
+
+
+#ifndef _WORKERPOOL_H
+#define _WORKERPOOL_H
+
+#include <vector>
+#include <boost/function.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition.hpp>
+
+/*
+ * A fixed set of threads for splitting a job up within a tick.
+ *
+ * run(job) calls job(n, size()) once for each n from 0 to size() - 1, one of
+ * them on the calling thread, and returns when all of them have finished; so
+ * a job usually takes every size()'th item of some list, starting at n.
+ *
+ * Jobs must not throw, and must only touch state which nothing else (the
+ * other calls included) writes to while they run.
+ */
+class workerPool {
+protected:
+	std::vector<boost::thread *> threads;
+	boost::mutex lock;
+	boost::condition wake, finished;
+	boost::function<void (unsigned int, unsigned int)> job;
+	unsigned int generation, running;
+	bool stopping;
+
+	void work(unsigned int n);
+
+public:
+	workerPool(unsigned int size);
+	~workerPool();
+
+	unsigned int size() const { return threads.size() + 1; }
+	void run(boost::function<void (unsigned int, unsigned int)> j);
+};
+
+#endif
+/* vim: set noet: */
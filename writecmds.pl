@@ -189,11 +189,13 @@ sub printarr {
 		}
 		$buf .= "\t\t$rettype, // rettype\n";
 		my $cost = $cmd->{evalcost}{$variant};
-		$buf .= "\t\t$cost // evalcost\n";
+		$buf .= "\t\t$cost, // evalcost\n";
+		$buf .= qq{\t\t"$cmd->{implementation}", // implementation\n};
+		$buf .= qq{\t\t"$cmd->{saveimpl}" // saveimpl\n};
 		$buf .= "\t},\n";
 
 	}
-	$buf .= "\t{ NULL, NULL, NULL, NULL, NULL, NULL, NULL, 0, 0, NULL, CI_END, 0 }\n";
+	$buf .= "\t{ NULL, NULL, NULL, NULL, NULL, NULL, NULL, 0, 0, NULL, CI_END, 0, NULL, NULL }\n";
 
 	$buf .= "};\n";
 	print $buf;